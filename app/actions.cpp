@@ -207,6 +207,22 @@ void Actions::setup()
 	connect(action, SIGNAL(triggered()), mainWnd(), SLOT(openProject()));
 	menu->addAction(action);
 
+	// Open another project alongside the active one.
+	action = new QAction(tr("&Add to Workspace..."), this);
+	action->setStatusTip(tr("Open another project, and query all projects "
+	                        "together"));
+	connect(action, SIGNAL(triggered()), mainWnd(), SLOT(addToWorkspace()));
+	menu->addAction(action);
+	projectGroup->addAction(action);
+
+	// Keep the current version of the database.
+	action = new QAction(tr("Create &Snapshot..."), this);
+	action->setStatusTip(tr("Save the current database, to compare query "
+	                        "results with later versions"));
+	connect(action, SIGNAL(triggered()), mainWnd(), SLOT(createSnapshot()));
+	menu->addAction(action);
+	projectGroup->addAction(action);
+
 	menu->addSeparator();
 
 	// Manage project files.
@@ -317,6 +333,14 @@ void Actions::setup()
 	action->setData(Core::Query::IncludingFiles);
 	menu->addAction(action);
 
+	// Find direct and indirect #include dependencies.
+	action = new QAction(tr("#include &Dependencies"), queryGroup);
+	action->setShortcut(tr("Ctrl+9"));
+	action->setStatusTip(tr("Find all files depending on, or included by, "
+	                        "a given file"));
+	action->setData(Core::Query::IncludeClosure);
+	menu->addAction(action);
+
 	// Show local tags.
 	action = new QAction(tr("Local &Tags"), this);
 	action->setShortcut(tr("Ctrl+T"));
@@ -339,6 +363,68 @@ void Actions::setup()
 	menu->addAction(action);
 	projectGroup->addAction(action);
 
+	// Composed query.
+	action = new QAction(tr("C&ombine Queries..."), this);
+	action->setStatusTip(tr("Intersect, unite or subtract the results of two "
+	                        "queries"));
+	connect(action, SIGNAL(triggered()), mainWnd(),
+	        SLOT(promptComposedQuery()));
+	menu->addAction(action);
+	projectGroup->addAction(action);
+
+	// Compare with an older version of the database.
+	action = new QAction(tr("Compare with &Snapshot..."), this);
+	action->setStatusTip(tr("Show results added or removed since a database "
+	                        "snapshot was taken"));
+	connect(action, SIGNAL(triggered()), mainWnd(),
+	        SLOT(promptSnapshotQuery()));
+	menu->addAction(action);
+	projectGroup->addAction(action);
+
+	// Rename a symbol in all files.
+	action = new QAction(tr("Re&name Symbol..."), this);
+	action->setStatusTip(tr("Rename a symbol in all files of the project"));
+	connect(action, SIGNAL(triggered()), mainWnd(), SLOT(promptRename()));
+	menu->addAction(action);
+	projectGroup->addAction(action);
+
+	// Code metrics reports.
+	// Handled by a single slot, with the report name as the action data.
+	QMenu* metricsMenu = menu->addMenu(tr("Code &Metrics"));
+	QActionGroup* metricsGroup = new QActionGroup(this);
+	connect(metricsGroup, SIGNAL(triggered(QAction*)), this,
+	        SLOT(metrics(QAction*)));
+	connect(ProjectManager::signalProxy(), SIGNAL(hasProject(bool)),
+			metricsGroup, SLOT(setEnabled(bool)));
+	metricsGroup->setEnabled(false);
+
+	action = new QAction(tr("&Unused Functions"), metricsGroup);
+	action->setStatusTip(tr("List functions that are never called or "
+	                        "referenced"));
+	action->setData(QString("unused"));
+	metricsMenu->addAction(action);
+
+	action = new QAction(tr("Most &Referenced Symbols"), metricsGroup);
+	action->setStatusTip(tr("List the symbols with the most references"));
+	action->setData(QString("referenced"));
+	metricsMenu->addAction(action);
+
+	action = new QAction(tr("Largest Fan-&In"), metricsGroup);
+	action->setStatusTip(tr("List the functions called by the most "
+	                        "functions"));
+	action->setData(QString("fanin"));
+	metricsMenu->addAction(action);
+
+	action = new QAction(tr("Largest Fan-&Out"), metricsGroup);
+	action->setStatusTip(tr("List the functions calling the most functions"));
+	action->setData(QString("fanout"));
+	metricsMenu->addAction(action);
+
+	action = new QAction(tr("Costliest &Headers"), metricsGroup);
+	action->setStatusTip(tr("List the headers that the most files depend on"));
+	action->setData(QString("includes"));
+	metricsMenu->addAction(action);
+
 	// Settings menu.
 	menu = mainWnd()->menuBar()->addMenu(tr("&Settings"));
 
@@ -381,6 +467,15 @@ void Actions::query(QAction* action)
 	mainWnd()->promptQuery(type);
 }
 
+/**
+ * A common handler for code metrics actions.
+ * @param  action  The triggered action
+ */
+void Actions::metrics(QAction* action)
+{
+	mainWnd()->showMetrics(action->data().toString());
+}
+
 /**
  * Constructs a sub-menu showing all open editor windows.
  * Called before the "Window" menu is shown.
@@ -58,6 +58,7 @@ private:
 
 private slots:
 	void query(QAction*);
+	void metrics(QAction*);
 	void showWindowMenu();
 	void setEditorViewMode(QAction*);
 };
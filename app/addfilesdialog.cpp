@@ -20,11 +20,12 @@
 
 #include <QList>
 #include <QSortFilterProxyModel>
-#include <QProgressDialog>
+#include <QAbstractListModel>
+#include <QElapsedTimer>
 #include <QMessageBox>
 #include <QDebug>
+#include <algorithm>
 #include <core/filefilter.h>
-#include <core/filescanner.h>
 #include "addfilesdialog.h"
 #include "projectmanager.h"
 
@@ -80,14 +81,102 @@ private:
 	Core::FileFilter filter_;
 };
 
+/**
+ * A flat list of file paths.
+ * Unlike QListWidget, the model does not create an item per file, which
+ * keeps large lists cheap, and files are appended a batch at a time.
+ * @author Elad Lahav
+ */
+class FileListModel : public QAbstractListModel
+{
+public:
+	FileListModel(QObject* parent = NULL) : QAbstractListModel(parent) {}
+
+	/**
+	 * @return The list of files
+	 */
+	const QStringList& files() const { return fileList_; }
+
+	/**
+	 * Adds files to the end of the list.
+	 * @param  files  The files to add
+	 */
+	void append(const QStringList& files) {
+		if (files.isEmpty())
+			return;
+
+		int first = fileList_.size();
+		beginInsertRows(QModelIndex(), first, first + files.size() - 1);
+		fileList_ += files;
+		endInsertRows();
+	}
+
+	/**
+	 * Removes all files.
+	 */
+	void clear() {
+		beginResetModel();
+		fileList_.clear();
+		endResetModel();
+	}
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const {
+		return parent.isValid() ? 0 : fileList_.size();
+	}
+
+	QVariant data(const QModelIndex& index, int role) const {
+		if (!index.isValid() || (role != Qt::DisplayRole))
+			return QVariant();
+
+		return fileList_.at(index.row());
+	}
+
+	bool removeRows(int row, int count,
+	                const QModelIndex& parent = QModelIndex()) {
+		if (parent.isValid() || (row < 0) || (count <= 0)
+		    || (row + count > fileList_.size())) {
+			return false;
+		}
+
+		beginRemoveRows(parent, row, row + count - 1);
+		fileList_.erase(fileList_.begin() + row,
+		                fileList_.begin() + row + count);
+		endRemoveRows();
+		return true;
+	}
+
+private:
+	QStringList fileList_;
+};
+
+Core::GitIndex AddFilesDialog::gitIndex_;
+
 /**
  * Class constructor.
- * @param  parent  Parent widget
+ * @param  snapshot  Listings of directories from the last scan of the
+ *                   project, updated by scans made in the dialogue
+ * @param  parent    Parent widget
  */
-AddFilesDialog::AddFilesDialog(QWidget* parent) : QDialog(parent),
-                                                  Ui::AddFilesDialog()
+AddFilesDialog::AddFilesDialog(Core::DirSnapshot* snapshot, QWidget* parent)
+	: QDialog(parent), Ui::AddFilesDialog(), snapshot_(snapshot)
 {
 	setupUi(this);
+
+	model_ = new FileListModel(this);
+	fileList_->setModel(model_);
+
+	// Show the results of scans as they arrive.
+	scanner_.setProgressMessage(tr("Found %2 of %1 files"));
+	scanner_.setSnapshot(snapshot_);
+	connect(&scanner_, SIGNAL(filesFound(const QStringList&)), this,
+	        SLOT(filesFound(const QStringList&)));
+	connect(&scanner_, SIGNAL(progress(const QString&)), statusLabel_,
+	        SLOT(setText(const QString&)));
+	connect(&scanner_, SIGNAL(finished(bool)), this, SLOT(scanFinished(bool)));
+	connect(stopButton_, SIGNAL(clicked()), &scanner_, SLOT(stop()));
+
+	feedTimer_.setSingleShot(true);
+	connect(&feedTimer_, SIGNAL(timeout()), this, SLOT(feedFiles()));
 }
 
 /**
@@ -103,11 +192,32 @@ AddFilesDialog::~AddFilesDialog()
  */
 void AddFilesDialog::fileList(QStringList& list) const
 {
-	QListWidgetItem* item;
-	int i = 0;
+	foreach (const QString& path, model_->files())
+		list.append(QDir::toNativeSeparators(path));
+
+	foreach (const QString& path, pending_)
+		list.append(QDir::toNativeSeparators(path));
+}
+
+/**
+ * Generates a list of files that should be removed from the project.
+ * These are files that were found by a previous scan of a directory, but not
+ * by a later scan made in this dialogue.
+ * @param  list  The list object to fill
+ */
+void AddFilesDialog::removedFiles(QStringList& list) const
+{
+	list += removed_;
+}
 
-	while ((item = fileList_->item(i++)))
-		list.append(QDir::toNativeSeparators(item->text()));
+/**
+ * Closes the dialogue without adding files.
+ * A running scan is stopped.
+ */
+void AddFilesDialog::reject()
+{
+	scanner_.stop();
+	QDialog::reject();
 }
 
 /**
@@ -117,7 +227,7 @@ void AddFilesDialog::addFiles()
 {
 	QStringList list;
 	if (getFiles(QFileDialog::ExistingFiles, list))
-		fileList_->addItems(list);
+		model_->append(list);
 }
 
 /**
@@ -192,13 +302,35 @@ void AddFilesDialog::saveFilter()
  */
 void AddFilesDialog::deleteSelectedFiles()
 {
-	// Get the currently selected items.
-	QList<QListWidgetItem*> selectedItems = fileList_->selectedItems();
+	// Get the currently selected rows.
+	QList<int> rows;
+	foreach (const QModelIndex& index,
+	         fileList_->selectionModel()->selectedIndexes()) {
+		rows.append(index.row());
+	}
 
-	// Delete the selected items.
-	QList<QListWidgetItem*>::Iterator itr;
-	for (itr = selectedItems.begin(); itr != selectedItems.end(); ++itr)
-		delete *itr;
+	std::sort(rows.begin(), rows.end());
+
+	// Remove consecutive rows together, starting from the end, so that the
+	// rows yet to be removed are not shifted.
+	int end = rows.size();
+	while (end > 0) {
+		int begin = end - 1;
+		while ((begin > 0) && (rows[begin - 1] == rows[begin] - 1))
+			begin--;
+
+		model_->removeRows(rows[begin], end - begin);
+		end = begin;
+	}
+}
+
+/**
+ * Removes all files from the list.
+ * Files found by a running scan are still added.
+ */
+void AddFilesDialog::clearFiles()
+{
+	model_->clear();
 }
 
 /**
@@ -231,6 +363,7 @@ bool AddFilesDialog::getFiles(QFileDialog::FileMode mode, QStringList& list)
  * Service method for addDir() and addTree().
  * Prompts the user for a directory, and then adds all files under this
  * directory that match the current filter.
+ * For git work trees, only tracked files are added.
  * @param  recursive  true to descend into sub-directories, false otherwise
  */
 void AddFilesDialog::addTree(bool recursive)
@@ -240,25 +373,109 @@ void AddFilesDialog::addTree(bool recursive)
 	if (!getFiles(QFileDialog::DirectoryOnly, list))
 		return;
 
-	// Create the scanner object.
-	Core::FileScanner scanner(this);
-	scanner.setProgressMessage(tr("Found %2 of %1 files"));
+	QString filter = filterEdit_->text();
+
+	// Directories inside a git work tree are listed from the repository's
+	// index, which is much faster than scanning the file system. Directories
+	// the index knows nothing about (untracked or ignored) are scanned.
+	if (gitIndex_.open(list.first()) && gitIndex_.refresh()) {
+		QStringList files;
+		if (gitIndex_.files(list.first(), Core::FileFilter(filter), recursive,
+		                    files)) {
+			model_->append(files);
+			return;
+		}
+	}
 
-	// Create a modal progress dialogue.
-	// This will be used to display progress information, as well as allow the
-	// user to cancel scanning.
-	QProgressDialog dlg(tr("Scanning..."), tr("Cancel"), 0, 0, this);
-	dlg.setModal(true);
-	connect(&dlg, SIGNAL(canceled()), &scanner, SLOT(stop()));
-	connect(&scanner, SIGNAL(progress(const QString&)), &dlg,
-	        SLOT(setLabelText(const QString&)));
-	dlg.show();
+	// Scan for files in the background.
+	// All matched files are listed, even in an incremental scan: files found
+	// by the previous scan may have never made it to the project (e.g., if
+	// they were deleted from the list, or the dialogue was cancelled).
+	if (!scanner_.start(list.first(), Core::FileFilter(filter), recursive))
+		return;
 
-	QString filter = filterEdit_->text();
+	setScanning(true);
+}
+
+/**
+ * Enables or disables the controls that cannot be used during a scan.
+ * @param  scanning  true if a scan is in progress, false otherwise
+ */
+void AddFilesDialog::setScanning(bool scanning)
+{
+	dirButton_->setEnabled(!scanning);
+	treeButton_->setEnabled(!scanning);
+	stopButton_->setEnabled(scanning);
+	buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!scanning);
+}
+
+/**
+ * Queues files found by the scanner for insertion into the list.
+ * @param  files  The new matching files
+ */
+void AddFilesDialog::filesFound(const QStringList& files)
+{
+	pending_ += files;
+	if (!feedTimer_.isActive())
+		feedTimer_.start(0);
+}
+
+/**
+ * Inserts pending files into the list, until the frame budget is used up.
+ * The remaining files are inserted after the event loop gets a chance to run.
+ */
+void AddFilesDialog::feedFiles()
+{
+	QElapsedTimer elapsed;
+	elapsed.start();
+
+	int pos = 0;
+	while ((pos < pending_.size()) && (elapsed.elapsed() < FrameBudget)) {
+		model_->append(pending_.mid(pos, FeedSize));
+		pos += FeedSize;
+	}
+
+	if (pos < pending_.size()) {
+		pending_.erase(pending_.begin(), pending_.begin() + pos);
+		feedTimer_.start(0);
+	}
+	else {
+		pending_.clear();
+	}
+}
+
+/**
+ * Called when a scan ends.
+ * @param  completed  true if all directories were scanned, false if the scan
+ *                    was stopped
+ */
+void AddFilesDialog::scanFinished(bool completed)
+{
+	// Files still waiting to be inserted must be in the list before the
+	// dialogue can be accepted.
+	feedTimer_.stop();
+	model_->append(pending_);
+	pending_.clear();
+
+	setScanning(false);
+	if (!completed) {
+		statusLabel_->setText(tr("The scan was stopped"));
+		return;
+	}
+
+	if (!snapshot_->isIncremental())
+		return;
+
+	// Files that disappeared since the last scan are removed from the
+	// project along with the addition of the new files.
+	removed_ += snapshot_->removed();
+	QString msg = tr("%1 files were added, and %2 files were removed, since "
+	                 "the directory was last scanned.")
+	              .arg(snapshot_->added().size())
+	              .arg(snapshot_->removed().size());
+	QMessageBox::information(this, tr("Add Files"), msg);
+}
 
-	// Scan for files.
-	if (scanner.scan(list.first(), Core::FileFilter(filter), recursive))
-		fileList_->addItems(scanner.matchedFiles());
 }
 
 }
@@ -23,6 +23,10 @@
 
 #include <QDialog>
 #include <QFileDialog>
+#include <QTimer>
+#include <core/gitindex.h>
+#include <core/dirsnapshot.h>
+#include <core/filescanner.h>
 #include "ui_addfilesdialog.h"
 
 namespace KScope
@@ -31,8 +35,14 @@ namespace KScope
 namespace App
 {
 
+class FileListModel;
+
 /**
  * A dialogue used to select files to be added to a project.
+ * Directories are scanned in the background, while the dialogue remains
+ * responsive: matched files are shown as they are found, and the scan can be
+ * stopped at any time. Files are inserted into the list in small portions, so
+ * that no single update takes longer than a frame.
  * @author Elad Lahav
  */
 class AddFilesDialog : public QDialog, public Ui::AddFilesDialog
@@ -40,10 +50,14 @@ class AddFilesDialog : public QDialog, public Ui::AddFilesDialog
 	Q_OBJECT
 
 public:
-	AddFilesDialog(QWidget* parent = NULL);
+	AddFilesDialog(Core::DirSnapshot*, QWidget* parent = NULL);
 	~AddFilesDialog();
 
 	void fileList(QStringList&) const;
+	void removedFiles(QStringList&) const;
+
+public slots:
+	void reject();
 
 protected slots:
 	void addFiles();
@@ -52,10 +66,66 @@ protected slots:
 	void loadFilter();
 	void saveFilter();
 	void deleteSelectedFiles();
+	void clearFiles();
 
 private:
+	/**
+	 * The maximal time, in milliseconds, spent on inserting files into the
+	 * list before returning to the event loop.
+	 */
+	static const int FrameBudget = 16;
+
+	/**
+	 * The number of files inserted into the list at a time.
+	 */
+	static const int FeedSize = 1024;
+
+	/**
+	 * Caches the list of tracked files in a git repository between uses of
+	 * the dialogue.
+	 */
+	static Core::GitIndex gitIndex_;
+
+	/**
+	 * Listings of directories from the last scan of the project, used to
+	 * avoid reading directories that did not change.
+	 */
+	Core::DirSnapshot* snapshot_;
+
+	/**
+	 * The files selected for addition.
+	 */
+	FileListModel* model_;
+
+	/**
+	 * Scans directories in the background.
+	 */
+	Core::FileScanner scanner_;
+
+	/**
+	 * Files that were found by a previous scan of the project, but no longer
+	 * exist.
+	 */
+	QStringList removed_;
+
+	/**
+	 * Files found by the scanner, waiting to be inserted into the list.
+	 */
+	QStringList pending_;
+
+	/**
+	 * Schedules the insertion of pending files.
+	 */
+	QTimer feedTimer_;
+
 	bool getFiles(QFileDialog::FileMode, QStringList&);
 	void addTree(bool);
+	void setScanning(bool);
+
+private slots:
+	void filesFound(const QStringList&);
+	void feedFiles();
+	void scanFinished(bool);
 };
 
 }
@@ -1,7 +1,7 @@
 include(../config)
 TEMPLATE = app
 TARGET = kscopeapp
-DEPENDPATH += ". ../core ../cscope ../editor"
+DEPENDPATH += ". ../core ../cscope ../global ../editor"
 
 # Input
 SOURCES += openprojectdialog.cpp \
@@ -20,7 +20,12 @@ SOURCES += openprojectdialog.cpp \
     queryresultdock.cpp \
     queryresultdialog.cpp \
     addfilesdialog.cpp \
-    configenginesdialog.cpp
+    configenginesdialog.cpp \
+    batchquery.cpp \
+    querydaemon.cpp \
+    instanceserver.cpp \
+    renamedialog.cpp \
+    definitionpreview.cpp
 HEADERS += openprojectdialog.h \
     settings.h \
     session.h \
@@ -41,7 +46,12 @@ HEADERS += openprojectdialog.h \
     projectdialog.h \
     buildprogress.h \
     version.h \
-    configenginesdialog.h
+    configenginesdialog.h \
+    batchquery.h \
+    querydaemon.h \
+    instanceserver.h \
+    renamedialog.h \
+    definitionpreview.h
 FORMS += querydialog.ui \
     queryresultdialog.ui \
     stackpage.ui \
@@ -49,11 +59,13 @@ FORMS += querydialog.ui \
     addfilesdialog.ui \
     projectdialog.ui \
     configenginesdialog.ui \
-    openprojectdialog.ui
+    openprojectdialog.ui \
+    renamedialog.ui
 INCLUDEPATH += .. .
+QT += network concurrent
 
-CONFIG(debug, debug|release):LIBS += -L../core/debug -lkscope_core -L../cscope/debug -lkscope_cscope -L../editor/debug -lkscope_editor
-CONFIG(release, debug|release):LIBS += -L../core/release -lkscope_core -L../cscope/release -lkscope_cscope -L../editor/release -lkscope_editor
+CONFIG(debug, debug|release):LIBS += -L../core/debug -lkscope_core -L../cscope/debug -lkscope_cscope -L../global/debug -lkscope_global -L../editor/debug -lkscope_editor
+CONFIG(release, debug|release):LIBS += -L../core/release -lkscope_core -L../cscope/release -lkscope_cscope -L../global/release -lkscope_global -L../editor/release -lkscope_editor
 
 RESOURCES = app.qrc
 target.path = $${INSTALL_PATH}/bin
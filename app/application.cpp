@@ -20,7 +20,9 @@
 
 #include <QMessageBox>
 #include <cscope/managedproject.h>
+#include <global/crossref.h>
 #include "application.h"
+#include "instanceserver.h"
 #include "mainwindow.h"
 #include "projectmanager.h"
 #include "version.h"
@@ -61,6 +63,11 @@ Application::~Application()
  */
 int Application::run()
 {
+	// Let a running instance handle the command line, if possible, to avoid a
+	// full start-up.
+	if (InstanceServer::forward(arguments()))
+		return 0;
+
 	// Create the main window.
 	// We can do it on the stack, as the method does not return as long as the
 	// application is running.
@@ -68,6 +75,10 @@ int Application::run()
 	mainWnd_ = &mainWnd;
 	mainWnd_->show();
 
+	// Serve requests from later invocations.
+	InstanceServer instanceServer(mainWnd_);
+	instanceServer.listen();
+
 	// Do application initialisation.
 	// The reason for posting an event is to have a running application (event
 	// loop) before starting the initialisation process. This way, the process
@@ -114,7 +125,7 @@ void Application::init()
 {
 	// Load configuration.
 	settings_->load();
-	setupEngines();
+	setupEngines(*settings_);
 
 	// Parse command-line arguments.
 	// TODO: Need to think some more about the options.
@@ -125,13 +136,16 @@ void Application::init()
 		if (arg.startsWith("-")) {
 			switch (arg.at(1).toLatin1()) {
 			case 'f':
-				path = args.takeFirst();
-				mainWnd_->openFile(path);
+				{
+					Core::Location loc
+						= InstanceServer::parseLocation(args.takeFirst());
+					mainWnd_->openFile(loc.file_, loc.line_, loc.column_);
+				}
 				return;
 
 			case 'p':
 				path = args.takeFirst();
-				ProjectManager::load<Cscope::ManagedProject>(path);
+				ProjectManager::load(path);
 				return;
 			}
 		}
@@ -143,30 +157,45 @@ void Application::init()
 	mainWnd_->openProject();
 }
 
-void Application::setupEngines()
+/**
+ * Applies stored configuration parameters to an engine type.
+ * @param  settings  The application's settings object
+ */
+template<class EngineT>
+static void setupEngine(Settings& settings)
 {
-	// TODO: We'd like a list of engines that can be iterated over in compile
-	// time to generate multi-engine code.
-	typedef Core::EngineConfig<Cscope::Crossref> Config;
+	typedef Core::EngineConfig<EngineT> Config;
 
 	// Prefix group with "Engine_" so that engines do not overrun application
 	// groups by accident.
-	settings_->beginGroup(QString("Engine_") + Config::name());
+	settings.beginGroup(QString("Engine_") + Config::name());
 
 	// Add each value under the engine group to the map of configuration
 	// parameters.
 	Core::KeyValuePairs params;
-	QStringList keys = settings_->allKeys();
+	QStringList keys = settings.allKeys();
 	QString key;
 	foreach (key, keys)
-		params[key] = settings_->value(key);
+		params[key] = settings.value(key);
 
-	settings_->endGroup();
+	settings.endGroup();
 
 	// Apply configuration to the engine.
 	Config::setConfig(params);
 }
 
+/**
+ * Applies stored configuration parameters to all engine types.
+ * @param  settings  The application's settings object
+ */
+void Application::setupEngines(Settings& settings)
+{
+	// TODO: We'd like a list of engines that can be iterated over in compile
+	// time to generate multi-engine code.
+	setupEngine<Cscope::Crossref>(settings);
+	setupEngine<Global::Crossref>(settings);
+}
+
 } // namespace App
 
 } // namespace KScope
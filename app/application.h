@@ -53,6 +53,8 @@ public:
 		return *(static_cast<Application*>(qApp)->settings_);
 	}
 
+	static void setupEngines(Settings&);
+
 public slots:
 	void about();
 
@@ -67,7 +69,6 @@ private:
 	Settings* settings_;
 
 	void init();
-	void setupEngines();
 };
 
 inline Application* theApp() { return static_cast<Application*>(qApp); }
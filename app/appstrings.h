@@ -22,6 +22,7 @@
 #define __APP_APPSTRINGS_H__
 
 #include <QString>
+#include <core/querycomposer.h>
 
 namespace KScope
 {
@@ -69,6 +70,35 @@ public:
 
 		case Core::Query::LocalTags:
 			return QObject::tr("Symbols in This File");
+
+		case Core::Query::IncludeClosure:
+			return QObject::tr("#include Dependencies");
+
+		case Core::Query::Metrics:
+			return QObject::tr("Code Metrics");
+		}
+
+		return QString();
+	}
+
+	/**
+	 * Converts a query composition operation to a string.
+	 * @param  op  The operation to convert
+	 * @return A string describing the operation
+	 */
+	static QString toString(Core::QueryComposer::Operation op) {
+		switch (op) {
+		case Core::QueryComposer::Intersection:
+			return QObject::tr("AND");
+
+		case Core::QueryComposer::Union:
+			return QObject::tr("OR");
+
+		case Core::QueryComposer::Difference:
+			return QObject::tr("AND NOT");
+
+		case Core::QueryComposer::Changes:
+			return QObject::tr("VS");
 		}
 
 		return QString();
@@ -80,36 +110,58 @@ public:
 	 * @return A string describing the query
 	 */
 	static QString toString(const Core::Query& query) {
+		QString str;
+
 		switch (query.type_) {
 		case Core::Query::Invalid:
 			return "<INVALID>";
 
 		case Core::Query::Text:
-			return QObject::tr("Text search '%1'").arg(query.pattern_);
+			str = QObject::tr("Text search '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::Definition:
-			return QObject::tr("Definition of '%1'").arg(query.pattern_);
+			str = QObject::tr("Definition of '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::References:
-			return QObject::tr("References to '%1'").arg(query.pattern_);
+			str = QObject::tr("References to '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::CalledFunctions:
-			return QObject::tr("Functions called by '%1'").arg(query.pattern_);
+			str = QObject::tr("Functions called by '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::CallingFunctions:
-			return QObject::tr("Functions calling '%1'").arg(query.pattern_);
+			str = QObject::tr("Functions calling '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::FindFile:
-			return QObject::tr("Find file '%1'").arg(query.pattern_);
+			str = QObject::tr("Find file '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::IncludingFiles:
-			return QObject::tr("Files #including '%1'").arg(query.pattern_);
+			str = QObject::tr("Files #including '%1'").arg(query.pattern_);
+			break;
 
 		case Core::Query::LocalTags:
-			return QObject::tr("Symbols in '%1'").arg(query.pattern_);
+			str = QObject::tr("Symbols in '%1'").arg(query.pattern_);
+			break;
+
+		case Core::Query::IncludeClosure:
+			str = QObject::tr("#include dependencies of '%1'")
+			      .arg(query.pattern_);
+			break;
+
+		case Core::Query::Metrics:
+			str = QObject::tr("Code metrics '%1'").arg(query.pattern_);
+			break;
 		}
 
-		return QString();
+		if (!query.pathPrefixes_.isEmpty())
+			str += QObject::tr(" in %1").arg(query.pathPrefixes_.join(" "));
+
+		return str;
 	}
 };
 
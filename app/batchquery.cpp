@@ -0,0 +1,656 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <core/corestrings.h>
+#include <core/exception.h>
+#include <cscope/managedproject.h>
+#include <global/managedproject.h>
+#include "application.h"
+#include "batchquery.h"
+#include "querydaemon.h"
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Maps query type names, as used on the command line, to query types.
+ */
+static const struct {
+	const char* name_;
+	Core::Query::Type type_;
+} QueryTypes[] = {
+	{ "text", Core::Query::Text },
+	{ "def", Core::Query::Definition },
+	{ "refs", Core::Query::References },
+	{ "called", Core::Query::CalledFunctions },
+	{ "calling", Core::Query::CallingFunctions },
+	{ "file", Core::Query::FindFile },
+	{ "includers", Core::Query::IncludingFiles },
+	{ "tags", Core::Query::LocalTags },
+	{ "closure", Core::Query::IncludeClosure },
+	{ "metrics", Core::Query::Metrics },
+	{ NULL, Core::Query::Invalid }
+};
+
+/**
+ * Signals the end of opening a project.
+ */
+struct OpenCallback : public Core::Callback<>
+{
+	OpenCallback(QEventLoop& loop) : loop_(loop), done_(false) {}
+
+	void call() {
+		done_ = true;
+		loop_.quit();
+	}
+
+	QEventLoop& loop_;
+	bool done_;
+};
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+BatchQuery::BatchQuery(QObject* parent) : QObject(parent),
+	out_(stdout, QIODevice::WriteOnly), err_(stderr, QIODevice::WriteOnly),
+	format_(Tsv), timeout_(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+BatchQuery::~BatchQuery()
+{
+}
+
+/**
+ * Determines whether the command line requests batch mode.
+ * This is checked before any application object is created, as batch mode
+ * runs without a display.
+ * @param  argc  The number of command-line arguments
+ * @param  argv  Command-line argument list
+ * @return true for batch mode, false otherwise
+ */
+bool BatchQuery::isBatch(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "--query") == 0)
+		    || (strcmp(argv[i], "--queries") == 0)
+		    || (strcmp(argv[i], "--build") == 0)
+		    || (strcmp(argv[i], "--daemon") == 0)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Parses the command line and executes the requested operations.
+ * @param  args  Command-line arguments
+ * @return The exit code of the application: 0 on success, 1 if an operation
+ *         failed, 2 for invalid arguments
+ */
+int BatchQuery::run(const QStringList& args)
+{
+	QString projPath;
+	bool build = false;
+	QStringList queries;
+	QStringList scope;
+	uint flags = 0;
+
+	for (int i = 1; i < args.size(); i++) {
+		const QString& arg = args[i];
+		bool hasValue = (i + 1) < args.size();
+
+		if ((arg == "--project" || arg == "-p") && hasValue) {
+			projPath = args[++i];
+		}
+		else if (arg == "--query" && hasValue) {
+			queries.append(args[++i]);
+		}
+		else if (arg == "--queries" && hasValue) {
+			// Read queries from a file, one per line ("-" for standard input).
+			QFile file;
+			QString path = args[++i];
+			bool result;
+			if (path == "-") {
+				result = file.open(stdin, QIODevice::ReadOnly
+				                          | QIODevice::Text);
+			}
+			else {
+				file.setFileName(path);
+				result = file.open(QIODevice::ReadOnly | QIODevice::Text);
+			}
+
+			if (!result) {
+				err_ << tr("Cannot read queries from '%1'").arg(path) << endl;
+				return 2;
+			}
+
+			QTextStream strm(&file);
+			while (!strm.atEnd()) {
+				QString line = strm.readLine().trimmed();
+				if (!line.isEmpty() && !line.startsWith("#"))
+					queries.append(line);
+			}
+		}
+		else if (arg == "--format" && hasValue) {
+			QString format = args[++i];
+			if (format == "tsv")
+				format_ = Tsv;
+			else if (format == "json")
+				format_ = Json;
+			else
+				return usage();
+		}
+		else if (arg == "--daemon" && hasValue) {
+			daemonName_ = args[++i];
+		}
+		else if (arg == "--timeout" && hasValue) {
+			bool ok;
+			timeout_ = args[++i].toInt(&ok);
+			if (!ok || timeout_ < 0)
+				return usage();
+		}
+		else if (arg == "--scope" && hasValue) {
+			scope.append(args[++i]);
+		}
+		else if (arg == "--ignore-case") {
+			flags |= Core::Query::IgnoreCase;
+		}
+		else if (arg == "--regexp") {
+			flags |= Core::Query::RegExp;
+		}
+		else if (arg == "--build") {
+			build = true;
+		}
+		else {
+			return usage();
+		}
+	}
+
+	if (projPath.isEmpty())
+		return usage();
+
+	// Apply the stored engine configuration (e.g., the paths of executables).
+	Settings settings;
+	Application::setupEngines(settings);
+
+	if (Global::ManagedProject::isProject(projPath)) {
+		return run<Global::ManagedProject>(projPath, build, queries, flags,
+		                                   scope);
+	}
+
+	return run<Cscope::ManagedProject>(projPath, build, queries, flags, scope);
+}
+
+/**
+ * Executes the requested operations on a project of a specific type.
+ * @param  projPath  The project directory
+ * @param  build     Whether to (re)build the database
+ * @param  queries   A list of queries to run, in "type:pattern" form
+ * @param  flags     Query modifiers
+ * @param  scope     Directories to which results are restricted
+ * @return The exit code of the application
+ */
+template<class ProjectT>
+int BatchQuery::run(const QString& projPath, bool build,
+                    const QStringList& queries, uint flags,
+                    const QStringList& scope)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	ProjectT project(projPath);
+	if (!open(project))
+		return 1;
+
+	err_ << tr("Opened '%1' in %2 ms").arg(project.name())
+	        .arg(timer.elapsed()) << endl;
+
+	Core::Engine& engine = *project.engine();
+	if (build) {
+		if (!this->build(engine))
+			return 1;
+	}
+	else if (engine.status() == Core::Engine::Build) {
+		err_ << tr("The database needs to be built (use --build)") << endl;
+		return 1;
+	}
+
+	int result = 0;
+	QStringList::ConstIterator itr;
+	for (itr = queries.begin(); itr != queries.end(); ++itr) {
+		if (!query(engine, *itr, flags, scope))
+			result = 1;
+	}
+
+	if (!daemonName_.isEmpty()) {
+		// Serve queries until asked to shut down.
+		QueryDaemon daemon(engine, *project.codebase(), project.path());
+		if (!daemon.listen(daemonName_)) {
+			err_ << tr("Cannot listen on '%1': %2").arg(daemonName_)
+			        .arg(daemon.errorString()) << endl;
+			return 1;
+		}
+
+		err_ << tr("Serving queries on '%1'").arg(daemonName_) << endl;
+		result = qApp->exec();
+	}
+
+	project.close();
+	return result;
+}
+
+/**
+ * Opens a project, and waits for it to become ready.
+ * @param  project  The project to open
+ * @return true if successful, false otherwise
+ */
+bool BatchQuery::open(Core::ProjectBase& project)
+{
+	OpenCallback cb(loop_);
+
+	try {
+		project.open(&cb);
+	}
+	catch (Core::Exception* e) {
+		err_ << e->reason() << endl;
+		delete e;
+		return false;
+	}
+
+	if (!cb.done_)
+		loop_.exec();
+
+	return true;
+}
+
+/**
+ * Builds the database.
+ * @param  engine  The engine whose database is built
+ * @return true if successful, false otherwise
+ */
+bool BatchQuery::build(Core::Engine& engine)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	Connection conn(*this);
+	querySpec_.clear();
+	engine.build(&conn);
+	wait(conn);
+
+	if (conn.aborted_) {
+		err_ << tr("Build failed after %1 ms").arg(timer.elapsed()) << endl;
+		return false;
+	}
+
+	err_ << tr("Build finished in %1 ms").arg(timer.elapsed()) << endl;
+	return true;
+}
+
+/**
+ * Runs a single query, writing results as they arrive.
+ * @param  engine  The engine to query
+ * @param  spec    The query, in "type:pattern" form
+ * @param  flags   Query modifiers
+ * @param  scope   Directories to which results are restricted
+ * @return true if successful, false otherwise
+ */
+bool BatchQuery::query(Core::Engine& engine, const QString& spec, uint flags,
+                       const QStringList& scope)
+{
+	Core::Query::Type type;
+	QString pattern;
+	if (!parseQuery(spec, type, pattern)) {
+		err_ << tr("Invalid query '%1'").arg(spec) << endl;
+		return false;
+	}
+
+	Core::Query query(type, pattern, flags);
+	query.pathPrefixes_ = scope;
+	query.timeout_ = timeout_;
+
+	// Queries answered from indices need to wait for the engine to derive
+	// them from the database.
+	if (!engine.canQuery(query))
+		waitForIndices(engine, query);
+
+	QElapsedTimer timer;
+	timer.start();
+
+	Connection conn(*this);
+	querySpec_ = spec;
+	fields_ = engine.queryFields(type);
+
+	try {
+		engine.query(&conn, query);
+	}
+	catch (Core::Exception* e) {
+		err_ << spec << ": " << e->reason() << endl;
+		delete e;
+		return false;
+	}
+
+	wait(conn);
+	out_.flush();
+
+	QString status;
+	if (conn.timedOut_)
+		status = tr(" (timed out)");
+	else if (conn.aborted_)
+		status = tr(" (aborted)");
+
+	err_ << tr("%1: %2 results in %3 ms%4").arg(spec).arg(conn.results_)
+	        .arg(timer.elapsed()).arg(status) << endl;
+	return !conn.aborted_ && !conn.timedOut_;
+}
+
+/**
+ * Runs the event loop until an operation terminates.
+ * @param  conn  The connection of the operation
+ */
+void BatchQuery::wait(Connection& conn)
+{
+	// Some operations terminate before the engine call returns.
+	if (!conn.done_)
+		loop_.exec();
+}
+
+/**
+ * Runs the event loop until the engine can answer a query.
+ * @param  engine  The engine to query
+ * @param  query   The query to run
+ */
+void BatchQuery::waitForIndices(Core::Engine& engine, const Core::Query& query)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	connect(&engine, SIGNAL(indicesChanged()), &loop_, SLOT(quit()));
+	while (!engine.canQuery(query))
+		loop_.exec();
+	disconnect(&engine, SIGNAL(indicesChanged()), &loop_, SLOT(quit()));
+
+	err_ << tr("Indices ready in %1 ms").arg(timer.elapsed()) << endl;
+}
+
+/**
+ * Writes a single result.
+ * The first value is always the query that produced the result, followed by
+ * the fields filled by the query type.
+ * @param  loc  The result to write
+ */
+void BatchQuery::print(const Core::Location& loc)
+{
+	QStringList names;
+	QStringList values;
+
+	QList<Core::Location::Fields>::ConstIterator itr;
+	for (itr = fields_.begin(); itr != fields_.end(); ++itr) {
+		switch (*itr) {
+		case Core::Location::File:
+			names << "file";
+			values << loc.file_;
+			break;
+
+		case Core::Location::Line:
+			names << "line";
+			values << QString::number(loc.line_);
+			break;
+
+		case Core::Location::Column:
+			names << "column";
+			values << QString::number(loc.column_);
+			break;
+
+		case Core::Location::TagName:
+			names << "symbol";
+			values << loc.tag_.name_;
+			break;
+
+		case Core::Location::TagType:
+			names << "type";
+			values << Core::Strings::tagName(loc.tag_.type_);
+			break;
+
+		case Core::Location::Scope:
+			names << "scope";
+			values << loc.tag_.scope_;
+			break;
+
+		case Core::Location::Text:
+			names << "text";
+			values << loc.text_;
+			break;
+
+		case Core::Location::Project:
+			names << "project";
+			values << loc.project_;
+			break;
+
+		case Core::Location::Count:
+			names << "count";
+			values << QString::number(loc.count_);
+			break;
+		}
+	}
+
+	if (format_ == Tsv) {
+		// Tabs and line breaks would break the format.
+		out_ << querySpec_;
+		QStringList::Iterator valItr;
+		for (valItr = values.begin(); valItr != values.end(); ++valItr) {
+			(*valItr).replace('\t', ' ').replace('\n', ' ');
+			out_ << '\t' << *valItr;
+		}
+		out_ << '\n';
+	}
+	else {
+		out_ << "{\"query\":" << jsonString(querySpec_);
+		for (int i = 0; i < names.size(); i++) {
+			out_ << ",\"" << names[i] << "\":";
+			if (fields_[i] == Core::Location::Line
+			    || fields_[i] == Core::Location::Column
+			    || fields_[i] == Core::Location::Count) {
+				out_ << values[i];
+			}
+			else {
+				out_ << jsonString(values[i]);
+			}
+		}
+		out_ << "}\n";
+	}
+}
+
+/**
+ * Writes a usage message.
+ * @return The exit code for invalid arguments
+ */
+int BatchQuery::usage()
+{
+	err_ << "Usage: kscope --project PATH [--build] [--query TYPE:PATTERN]...\n"
+	        "              [--queries FILE] [--format tsv|json]\n"
+	        "              [--scope DIR]... [--ignore-case] [--regexp]\n"
+	        "              [--timeout MS] [--daemon SOCKET]\n"
+	        "Query types:";
+
+	for (int i = 0; QueryTypes[i].name_; i++)
+		err_ << ' ' << QueryTypes[i].name_;
+
+	err_ << endl;
+	return 2;
+}
+
+/**
+ * Parses a query given on the command line.
+ * @param  spec     The query, in "type:pattern" form
+ * @param  type     Holds the query type, upon successful return
+ * @param  pattern  Holds the pattern, upon successful return
+ * @return true if successful, false otherwise
+ */
+bool BatchQuery::parseQuery(const QString& spec, Core::Query::Type& type,
+                            QString& pattern)
+{
+	int colon = spec.indexOf(':');
+	if (colon <= 0)
+		return false;
+
+	QString name = spec.left(colon);
+	pattern = spec.mid(colon + 1);
+	for (int i = 0; QueryTypes[i].name_; i++) {
+		if (name == QueryTypes[i].name_) {
+			type = QueryTypes[i].type_;
+			return !pattern.isEmpty();
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Quotes and escapes a string for JSON output.
+ * @param  str  The string to convert
+ * @return The JSON string
+ */
+QString BatchQuery::jsonString(const QString& str)
+{
+	QString result("\"");
+	for (int i = 0; i < str.length(); i++) {
+		QChar c = str[i];
+		switch (c.unicode()) {
+		case '"':
+			result += "\\\"";
+			break;
+
+		case '\\':
+			result += "\\\\";
+			break;
+
+		case '\n':
+			result += "\\n";
+			break;
+
+		case '\r':
+			result += "\\r";
+			break;
+
+		case '\t':
+			result += "\\t";
+			break;
+
+		default:
+			if (c.unicode() < 0x20)
+				result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+			else
+				result += c;
+		}
+	}
+
+	result += '"';
+	return result;
+}
+
+/**
+ * Struct constructor.
+ * @param  batch  The owning object
+ */
+BatchQuery::Connection::Connection(BatchQuery& batch)
+	: Core::Engine::Connection(), batch_(batch), done_(false),
+	  aborted_(false), timedOut_(false), results_(0)
+{
+}
+
+/**
+ * Writes query results.
+ * @param  locList  A list of results
+ */
+void BatchQuery::Connection::onDataReady(const Core::LocationList& locList)
+{
+	Core::LocationList::ConstIterator itr;
+	for (itr = locList.begin(); itr != locList.end(); ++itr)
+		batch_.print(*itr);
+
+	results_ += locList.size();
+}
+
+/**
+ * Ends the wait for the operation.
+ */
+void BatchQuery::Connection::onFinished()
+{
+	done_ = true;
+	batch_.loop_.quit();
+}
+
+/**
+ * Ends the wait for the operation.
+ */
+void BatchQuery::Connection::onAborted()
+{
+	done_ = true;
+	aborted_ = true;
+	batch_.loop_.quit();
+}
+
+/**
+ * Ends the wait for an operation that ran past its deadline.
+ */
+void BatchQuery::Connection::onTimedOut()
+{
+	done_ = true;
+	timedOut_ = true;
+	batch_.loop_.quit();
+}
+
+/**
+ * Reports build progress on the standard error.
+ * Query progress is not reported, so as not to interfere with timing.
+ * @param  text   A message describing the kind of progress made
+ * @param  cur    The current value
+ * @param  total  The expected final value
+ */
+void BatchQuery::Connection::onProgress(const QString& text, uint cur,
+                                        uint total)
+{
+	if (!batch_.querySpec_.isEmpty())
+		return;
+
+	if (total > 0)
+		batch_.err_ << text << ' ' << cur << '/' << total << endl;
+	else
+		batch_.err_ << text << endl;
+}
+
+} // namespace App
+
+} // namespace KScope
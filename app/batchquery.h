@@ -0,0 +1,172 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __APP_BATCHQUERY_H__
+#define __APP_BATCHQUERY_H__
+
+#include <QEventLoop>
+#include <QTextStream>
+#include <core/engine.h>
+#include <core/project.h>
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Runs queries without a user interface.
+ * Batch mode is selected by the --query, --queries, --build and --daemon
+ * command-line options. A project is opened, its database optionally built,
+ * and each query is executed in turn, with results written to the standard
+ * output as they arrive. Timing information is written to the standard error,
+ * which makes this mode suitable for scripts and for benchmarking the engines.
+ * With --daemon, the project is then kept open to serve queries from other
+ * processes (see QueryDaemon).
+ * @author Elad Lahav
+ */
+class BatchQuery : public QObject
+{
+	Q_OBJECT
+
+public:
+	BatchQuery(QObject* parent = NULL);
+	~BatchQuery();
+
+	static bool isBatch(int argc, char** argv);
+
+	int run(const QStringList& args);
+
+	static bool parseQuery(const QString& spec, Core::Query::Type& type,
+	                       QString& pattern);
+
+private:
+	/**
+	 * Output formats.
+	 */
+	enum Format {
+		/** Tab-separated values, one result per line. */
+		Tsv,
+		/** A JSON object per result, one result per line. */
+		Json
+	};
+
+	/**
+	 * Receives the results of an engine operation.
+	 */
+	struct Connection : public Core::Engine::Connection
+	{
+		Connection(BatchQuery& batch);
+
+		void onDataReady(const Core::LocationList& locList);
+		void onFinished();
+		void onAborted();
+		void onTimedOut();
+		void onProgress(const QString& text, uint cur, uint total);
+
+		/**
+		 * The owning object.
+		 */
+		BatchQuery& batch_;
+
+		/**
+		 * Whether the operation has terminated.
+		 */
+		bool done_;
+
+		/**
+		 * Whether the operation has terminated abnormally.
+		 */
+		bool aborted_;
+
+		/**
+		 * Whether the operation was stopped by its deadline.
+		 */
+		bool timedOut_;
+
+		/**
+		 * The number of results received.
+		 */
+		uint results_;
+	};
+
+	/**
+	 * Standard output.
+	 */
+	QTextStream out_;
+
+	/**
+	 * Standard error.
+	 */
+	QTextStream err_;
+
+	/**
+	 * Waits for asynchronous operations to complete.
+	 */
+	QEventLoop loop_;
+
+	/**
+	 * The selected output format.
+	 */
+	Format format_;
+
+	/**
+	 * The deadline for each query, in milliseconds (0 for none).
+	 */
+	int timeout_;
+
+	/**
+	 * The query currently executing, as given on the command line.
+	 */
+	QString querySpec_;
+
+	/**
+	 * If not empty, the name of the socket on which to serve queries after
+	 * the command-line queries are done.
+	 */
+	QString daemonName_;
+
+	/**
+	 * The fields reported for the current query.
+	 */
+	QList<Core::Location::Fields> fields_;
+
+	template<class ProjectT>
+	int run(const QString& projPath, bool build, const QStringList& queries,
+	        uint flags, const QStringList& scope);
+
+	bool open(Core::ProjectBase& project);
+	bool build(Core::Engine& engine);
+	bool query(Core::Engine& engine, const QString& spec, uint flags,
+	           const QStringList& scope);
+	void wait(Connection& conn);
+	void waitForIndices(Core::Engine& engine, const Core::Query& query);
+	void print(const Core::Location& loc);
+	int usage();
+
+	static QString jsonString(const QString& str);
+};
+
+} // namespace App
+
+} // namespace KScope
+
+#endif // __APP_BATCHQUERY_H__
@@ -20,6 +20,7 @@
 
 #include <QLabel>
 #include <cscope/crossref.h>
+#include <global/crossref.h>
 #include "application.h"
 #include "configenginesdialog.h"
 
@@ -30,50 +31,39 @@ namespace App
 {
 
 /**
- * Class constructor.
- * @param  parent  Parent widget
+ * Adds a configuration page for an engine type.
+ * @param  tabWidget  The tab widget holding the pages
  */
-ConfigEnginesDialog::ConfigEnginesDialog(QWidget* parent)
-	: QDialog(parent), Ui::ConfigEnginesDialog()
+template<class EngineT>
+static void addEngineTab(QTabWidget* tabWidget)
 {
-	setupUi(this);
+	typedef Core::EngineConfig<EngineT> Config;
 
-	// TODO: We'd like a list of engines that can be iterated over in compile
-	// time to generate multi-engine code.
-	typedef Core::EngineConfig<Cscope::Crossref> Config;
-
-	QWidget* widget = Config::createConfigWidget(this);
+	QWidget* widget = Config::createConfigWidget(tabWidget);
 	QString title;
 	if (widget) {
 		title = widget->windowTitle();
 	}
 	else {
-		widget = new QLabel(tr("Configuration not available"), this);
+		widget = new QLabel(QObject::tr("Configuration not available"),
+		                    tabWidget);
 		title = Config::name();
 	}
 
-	tabWidget_->addTab(widget, title);
+	tabWidget->addTab(widget, title);
 }
 
 /**
- * Class destructor.
+ * Applies and stores the configuration of an engine type.
+ * @param  widget  The configuration page of the engine
  */
-ConfigEnginesDialog::~ConfigEnginesDialog()
+template<class EngineT>
+static void applyEngineConfig(QWidget* widget)
 {
-}
-
-/**
- * Called when the user clicks the "OK" button.
- * Applies the configuration to the engines, and exits the dialogue.
- */
-void ConfigEnginesDialog::accept()
-{
-	// TODO: We'd like a list of engines that can be iterated over in compile
-	// time to generate multi-engine code.
-	typedef Core::EngineConfig<Cscope::Crossref> Config;
+	typedef Core::EngineConfig<EngineT> Config;
 
 	// Apply configuration to the engine.
-	Config::configFromWidget(tabWidget_->widget(0));
+	Config::configFromWidget(widget);
 
 	// Get the new set of parameters.
 	Core::KeyValuePairs params;
@@ -91,6 +81,40 @@ void ConfigEnginesDialog::accept()
 		settings.setValue(itr.key(), itr.value());
 
 	settings.endGroup();
+}
+
+/**
+ * Class constructor.
+ * @param  parent  Parent widget
+ */
+ConfigEnginesDialog::ConfigEnginesDialog(QWidget* parent)
+	: QDialog(parent), Ui::ConfigEnginesDialog()
+{
+	setupUi(this);
+
+	// TODO: We'd like a list of engines that can be iterated over in compile
+	// time to generate multi-engine code.
+	addEngineTab<Cscope::Crossref>(tabWidget_);
+	addEngineTab<Global::Crossref>(tabWidget_);
+}
+
+/**
+ * Class destructor.
+ */
+ConfigEnginesDialog::~ConfigEnginesDialog()
+{
+}
+
+/**
+ * Called when the user clicks the "OK" button.
+ * Applies the configuration to the engines, and exits the dialogue.
+ */
+void ConfigEnginesDialog::accept()
+{
+	// TODO: We'd like a list of engines that can be iterated over in compile
+	// time to generate multi-engine code.
+	applyEngineConfig<Cscope::Crossref>(tabWidget_->widget(0));
+	applyEngineConfig<Global::Crossref>(tabWidget_->widget(1));
 
 	QDialog::accept();
 }
@@ -0,0 +1,306 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QFile>
+#include <QFileInfo>
+#include <QToolTip>
+#include <QtConcurrentRun>
+#include <core/exception.h>
+#include "definitionpreview.h"
+#include "projectmanager.h"
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+DefinitionPreview::DefinitionPreview(QObject* parent)
+	: QObject(parent), cache_(CacheSize), request_(NULL)
+{
+	connect(&watcher_, SIGNAL(finished()), this, SLOT(composed()));
+
+	// Cached definitions may be out of date once the project changes or the
+	// database is rebuilt.
+	connect(ProjectManager::signalProxy(), SIGNAL(hasProject(bool)), this,
+	        SLOT(clear()));
+	connect(ProjectManager::signalProxy(), SIGNAL(buildProject()), this,
+	        SLOT(clear()));
+	connect(ProjectManager::signalProxy(), SIGNAL(workspaceChanged()), this,
+	        SLOT(clear()));
+}
+
+/**
+ * Class destructor.
+ */
+DefinitionPreview::~DefinitionPreview()
+{
+	cancelRequest();
+	watcher_.waitForFinished();
+}
+
+/**
+ * Shows the definition of a symbol.
+ * The tool tip is shown immediately if the symbol is in the cache. Otherwise,
+ * a lookup is started, and the tool tip is shown when it completes, provided
+ * that the pointer is still over the same symbol.
+ * @param  symbol  The symbol under the mouse pointer
+ * @param  pos     The position of the pointer, in global coordinates
+ */
+void DefinitionPreview::show(const QString& symbol, const QPoint& pos)
+{
+	symbol_ = symbol;
+	pos_ = pos;
+
+	// Use the cached text, unless the file it was read from has changed since.
+	Entry* entry = cache_.object(symbol);
+	if (entry != NULL) {
+		if (entry->file_.isEmpty()
+		    || (QFileInfo(entry->file_).lastModified() == entry->modified_)) {
+			showText(entry->text_);
+			return;
+		}
+
+		cache_.remove(symbol);
+	}
+
+	// Nothing to do if the symbol is already being looked up.
+	if ((request_ != NULL) && (request_->symbol() == symbol))
+		return;
+
+	if (watcher_.isRunning() && (pending_ == symbol))
+		return;
+
+	cancelRequest();
+	if (!ProjectManager::hasProject())
+		return;
+
+	// The query may complete before query() returns, if the results are
+	// cached by the engine.
+	Request* request = new Request(this, symbol);
+	request_ = request;
+	try {
+		Core::Query query(Core::Query::Definition, symbol);
+		ProjectManager::engine().query(request, query);
+	}
+	catch (Core::Exception* e) {
+		// Do not bother the user with errors for something they did not
+		// explicitly ask for.
+		delete e;
+		if (request_ == request)
+			request_ = NULL;
+
+		delete request;
+	}
+}
+
+/**
+ * Hides the tool tip, and stops any lookup in progress.
+ * Called when the mouse pointer moves away from the symbol.
+ */
+void DefinitionPreview::hide()
+{
+	symbol_.clear();
+	cancelRequest();
+	QToolTip::hideText();
+}
+
+/**
+ * Discards all cached tool tips.
+ */
+void DefinitionPreview::clear()
+{
+	cache_.clear();
+}
+
+/**
+ * Stops the query in progress, if any.
+ * The request object deletes itself once the engine acknowledges the
+ * cancellation.
+ */
+void DefinitionPreview::cancelRequest()
+{
+	if (request_ != NULL) {
+		request_->cancel();
+		request_ = NULL;
+	}
+}
+
+/**
+ * Called when a Definition query completes.
+ * Starts composing the tool tip in a worker thread.
+ * @param  request  The completed request
+ * @param  locList  The definitions of the symbol
+ */
+void DefinitionPreview::definitionsFound(Request* request,
+                                         const Core::LocationList& locList)
+{
+	if (request_ == request)
+		request_ = NULL;
+
+	// Remember symbols without definitions, to avoid querying for them again.
+	if (locList.isEmpty()) {
+		cache_.insert(request->symbol(), new Entry());
+		return;
+	}
+
+	pending_ = request->symbol();
+	watcher_.setFuture(QtConcurrent::run(&DefinitionPreview::compose,
+	                                     locList));
+}
+
+/**
+ * Called when the text of a tool tip is ready.
+ */
+void DefinitionPreview::composed()
+{
+	Entry entry = watcher_.result();
+	cache_.insert(pending_, new Entry(entry));
+
+	if (pending_ == symbol_)
+		showText(entry.text_);
+
+	pending_.clear();
+}
+
+/**
+ * Displays the tool tip at the last position of the mouse pointer.
+ * @param  text  The text to display
+ */
+void DefinitionPreview::showText(const QString& text)
+{
+	if (!text.isEmpty())
+		QToolTip::showText(pos_, text);
+}
+
+/**
+ * Creates the text of a tool tip.
+ * Lists the definition sites of the symbol, followed by a few lines of source
+ * code from the first of these.
+ * Runs in a worker thread.
+ * @param  locList  The definitions of the symbol
+ * @return The cache entry for the symbol
+ */
+DefinitionPreview::Entry DefinitionPreview::compose(
+	const Core::LocationList& locList)
+{
+	Entry entry;
+	const Core::Location& first = locList.first();
+
+	// Read the lines following the first definition.
+	QString snippet;
+	if (first.line_ > 0) {
+		QFile file(first.file_);
+		entry.modified_ = QFileInfo(first.file_).lastModified();
+		if (file.open(QIODevice::ReadOnly)) {
+			entry.file_ = first.file_;
+			uint line = 1;
+			while ((line < first.line_ + SnippetLines) && !file.atEnd()) {
+				QByteArray text = file.readLine();
+				if (line >= first.line_)
+					snippet += QString::fromLocal8Bit(text);
+
+				line++;
+			}
+		}
+	}
+
+	// Fall back to the text reported by the engine.
+	if (snippet.isEmpty())
+		snippet = first.text_;
+
+	snippet.replace('\t', "    ");
+	while (snippet.endsWith('\n'))
+		snippet.chop(1);
+
+	// List the definition sites.
+	QString text;
+	int count = 0;
+	foreach (const Core::Location& loc, locList) {
+		if (count == MaxDefinitions) {
+			text += QObject::tr("<i>%1 more definitions</i>")
+			        .arg(locList.size() - count);
+			break;
+		}
+
+		text += QString("<b>%1:%2</b><br>").arg(loc.file_.toHtmlEscaped())
+		        .arg(loc.line_);
+
+		// Show the source after the first site.
+		if (count == 0)
+			text += QString("<pre>%1</pre>").arg(snippet.toHtmlEscaped());
+
+		count++;
+	}
+
+	entry.text_ = text;
+	return entry;
+}
+
+/**
+ * Stops the query.
+ * The owner is no longer notified of its results.
+ */
+void DefinitionPreview::Request::cancel()
+{
+	owner_ = NULL;
+	stop();
+}
+
+/**
+ * Collects the results of the query.
+ * @param  locList  A list of results
+ */
+void DefinitionPreview::Request::onDataReady(const Core::LocationList& locList)
+{
+	locList_ += locList;
+}
+
+/**
+ * Passes the results to the owner.
+ * The object is deleted once control returns to the event loop, as the engine
+ * may still refer to it.
+ */
+void DefinitionPreview::Request::onFinished()
+{
+	if (owner_ != NULL)
+		owner_->definitionsFound(this, locList_);
+
+	deleteLater();
+}
+
+/**
+ * Called when the query is stopped or fails.
+ */
+void DefinitionPreview::Request::onAborted()
+{
+	if ((owner_ != NULL) && (owner_->request_ == this))
+		owner_->request_ = NULL;
+
+	deleteLater();
+}
+
+} // namespace App
+
+} // namespace KScope
@@ -0,0 +1,187 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __APP_DEFINITIONPREVIEW_H__
+#define __APP_DEFINITIONPREVIEW_H__
+
+#include <QObject>
+#include <QCache>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QPoint>
+#include <core/engine.h>
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Shows the definition of the symbol under the mouse pointer in a tool tip.
+ * The definition is found with a Definition query, and a few lines of the
+ * source file are read from the definition site. Neither step blocks the
+ * GUI thread: the query is asynchronous (and answered immediately by the
+ * engine's query cache for symbols that were looked up recently), and the
+ * file is read in the global thread pool.
+ * The text of each tool tip is kept in a per-symbol cache, so that hovering
+ * over a symbol that was shown before requires only a check of the
+ * modification time of the file holding the definition. A new hover
+ * supersedes any lookup still in progress for an older one, and moving the
+ * pointer away stops the lookup altogether.
+ * @author Elad Lahav
+ */
+class DefinitionPreview : public QObject
+{
+	Q_OBJECT
+
+public:
+	DefinitionPreview(QObject* parent = 0);
+	~DefinitionPreview();
+
+public slots:
+	void show(const QString&, const QPoint&);
+	void hide();
+	void clear();
+
+private:
+	/**
+	 * Looks up the definition of a single symbol.
+	 */
+	class Request : public QObject, public Core::Engine::Connection
+	{
+	public:
+		Request(DefinitionPreview* owner, const QString& symbol)
+			: QObject(), Core::Engine::Connection(), owner_(owner),
+			  symbol_(symbol) {}
+
+		void cancel();
+
+		/**
+		 * @return The symbol being looked up
+		 */
+		const QString& symbol() const { return symbol_; }
+
+		// Engine::Connection implementation.
+		virtual void onDataReady(const Core::LocationList&);
+		virtual void onFinished();
+		virtual void onAborted();
+		virtual void onProgress(const QString&, uint, uint) {}
+
+	private:
+		/**
+		 * The object to notify when the query completes, NULL if the request
+		 * was cancelled.
+		 */
+		DefinitionPreview* owner_;
+
+		/**
+		 * The symbol being looked up.
+		 */
+		QString symbol_;
+
+		/**
+		 * The results of the query.
+		 */
+		Core::LocationList locList_;
+	};
+
+	/**
+	 * A cached tool tip.
+	 */
+	struct Entry
+	{
+		/**
+		 * The text of the tool tip, empty if the symbol has no definition.
+		 */
+		QString text_;
+
+		/**
+		 * The file from which the source lines were read.
+		 */
+		QString file_;
+
+		/**
+		 * The modification time of the file when it was read.
+		 */
+		QDateTime modified_;
+	};
+
+	/**
+	 * The maximal number of symbols kept in the cache.
+	 */
+	static const int CacheSize = 256;
+
+	/**
+	 * The maximal number of definitions listed in a tool tip.
+	 */
+	static const int MaxDefinitions = 4;
+
+	/**
+	 * The number of source lines shown from the first definition.
+	 */
+	static const uint SnippetLines = 6;
+
+	/**
+	 * Tool tips for recently-hovered symbols.
+	 */
+	QCache<QString, Entry> cache_;
+
+	/**
+	 * The symbol currently under the mouse pointer, an empty string if none.
+	 */
+	QString symbol_;
+
+	/**
+	 * The position of the mouse pointer over the symbol, in global
+	 * coordinates.
+	 */
+	QPoint pos_;
+
+	/**
+	 * The query in progress, NULL if none.
+	 */
+	Request* request_;
+
+	/**
+	 * The symbol whose tool tip is being composed in a worker thread.
+	 */
+	QString pending_;
+
+	/**
+	 * Monitors the composition of a tool tip.
+	 */
+	QFutureWatcher<Entry> watcher_;
+
+	void cancelRequest();
+	void definitionsFound(Request*, const Core::LocationList&);
+	void showText(const QString&);
+
+	static Entry compose(const Core::LocationList&);
+
+private slots:
+	void composed();
+};
+
+} // namespace App
+
+} // namespace KScope
+
+#endif // __APP_DEFINITIONPREVIEW_H__
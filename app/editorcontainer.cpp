@@ -59,6 +59,8 @@ EditorContainer::EditorContainer(QMainWindow* parent)
 	// Display the current cursor position in the status bar.
 	cursorPositionLabel_ = new QLabel(tr("Line: N/A Column: N/A"), this);
 	parent->statusBar()->addPermanentWidget(cursorPositionLabel_);
+
+	preview_ = new DefinitionPreview(this);
 }
 
 /**
@@ -105,6 +107,40 @@ bool EditorContainer::canClose()
 	return true;
 }
 
+/**
+ * @return The paths of all files with unsaved changes
+ */
+QStringList EditorContainer::modifiedFiles() const
+{
+	QStringList files;
+	foreach (QMdiSubWindow* window, fileMap_) {
+		Editor::Editor* editor = editorFromWindow(window);
+		if (editor->isModified() && !editor->path().isEmpty())
+			files.append(editor->path());
+	}
+
+	return files;
+}
+
+/**
+ * Reloads the open editors of files that were changed outside the editor.
+ * The cursor position of each editor is preserved.
+ * @param  files  The paths of the changed files
+ */
+void EditorContainer::reloadFiles(const QStringList& files)
+{
+	foreach (QMdiSubWindow* window, fileMap_) {
+		Editor::Editor* editor = editorFromWindow(window);
+		if (!files.contains(editor->path()))
+			continue;
+
+		Core::Location loc;
+		editor->getCurrentLocation(loc);
+		if (editor->load(loc.file_, config_.lexer(loc.file_)))
+			editor->moveCursor(loc.line_, loc.column_);
+	}
+}
+
 /**
  * Stores the locations of all editors in a session object.
  * @param  session  The session object to use
@@ -421,6 +457,11 @@ Editor::Editor* EditorContainer::createEditor(const QString& path)
 	        static_cast<QMainWindow*>(parent())->statusBar(),
 	        SLOT(showMessage(const QString&, int)));
 
+	// Show the definition of the symbol under the mouse pointer.
+	connect(editor, SIGNAL(symbolHovered(const QString&, const QPoint&)),
+	        preview_, SLOT(show(const QString&, const QPoint&)));
+	connect(editor, SIGNAL(hoverEnded()), preview_, SLOT(hide()));
+
 	// Create a new sub window for the editor.
 	QMdiSubWindow* window = addSubWindow(editor);
 	window->setAttribute(Qt::WA_DeleteOnClose);
@@ -31,6 +31,7 @@
 #include <editor/config.h>
 #include <editor/actions.h>
 #include "locationhistory.h"
+#include "definitionpreview.h"
 #include "session.h"
 
 namespace KScope
@@ -55,6 +56,8 @@ public:
 
 	void populateWindowMenu(QMenu*) const;
 	bool canClose();
+	QStringList modifiedFiles() const;
+	void reloadFiles(const QStringList&);
 	void saveSession(Session&);
 	void loadSession(Session&);
 	void clearHistory();
@@ -98,6 +101,11 @@ private:
 	 */
 	QLabel* editModeLabel_;
 
+	/**
+	 * Shows the definition of the symbol under the mouse pointer.
+	 */
+	DefinitionPreview* preview_;
+
 	bool gotoLocationInternal(const Core::Location&);
 	Editor::Editor* findEditor(const QString&);
 	Editor::Editor* createEditor(const QString&);
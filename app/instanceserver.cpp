@@ -0,0 +1,264 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocalSocket>
+#include <QDebug>
+#include "instanceserver.h"
+#include "mainwindow.h"
+#include "projectmanager.h"
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * How long a new invocation waits for the running instance, in milliseconds.
+ */
+static const int ForwardTimeout = 500;
+
+/**
+ * Class constructor.
+ * @param  mainWnd  The window that handles requests
+ * @param  parent   Parent object
+ */
+InstanceServer::InstanceServer(MainWindow* mainWnd, QObject* parent)
+	: QObject(parent), mainWnd_(mainWnd)
+{
+	connect(&server_, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+/**
+ * Class destructor.
+ */
+InstanceServer::~InstanceServer()
+{
+}
+
+/**
+ * Starts accepting requests from new invocations.
+ * Only one instance serves requests: if another instance is already
+ * listening, this one does not.
+ * The socket is only accessible by the current user, as requests open files
+ * and projects on its behalf.
+ * @return true if successful, false otherwise
+ */
+bool InstanceServer::listen()
+{
+	QString name = serverName();
+	server_.setSocketOptions(QLocalServer::UserAccessOption);
+	if (server_.listen(name))
+		return true;
+
+	if (server_.serverError() != QAbstractSocket::AddressInUseError)
+		return false;
+
+	// Check whether the socket belongs to a live instance, or was left behind
+	// by one that crashed.
+	QLocalSocket socket;
+	socket.connectToServer(name);
+	if (socket.waitForConnected(ForwardTimeout))
+		return false;
+
+	QLocalServer::removeServer(name);
+	return server_.listen(name);
+}
+
+/**
+ * Tries to have a running instance handle the command line.
+ * As in Application::init(), the first -f or -p option determines the request.
+ * Relative paths are converted to absolute ones, as the running instance may
+ * have a different working directory.
+ * @param  args  Command-line arguments
+ * @return true if a running instance accepted the request, false if this
+ *         process needs to handle it
+ */
+bool InstanceServer::forward(const QStringList& args)
+{
+	QString request;
+	for (int i = 1; i < (args.size() - 1) && request.isEmpty(); i++) {
+		if (args[i] == "-f") {
+			Core::Location loc = parseLocation(args[i + 1]);
+			request = QString("file\t%1\t%2\t%3")
+			          .arg(QFileInfo(loc.file_).absoluteFilePath())
+			          .arg(loc.line_).arg(loc.column_);
+		}
+		else if (args[i] == "-p") {
+			request = QString("project\t%1")
+			          .arg(QFileInfo(args[i + 1]).absoluteFilePath());
+		}
+	}
+
+	// A plain invocation starts a new instance.
+	if (request.isEmpty())
+		return false;
+
+	QLocalSocket socket;
+	socket.connectToServer(serverName());
+	if (!socket.waitForConnected(ForwardTimeout))
+		return false;
+
+	socket.write(request.toUtf8() + "\n");
+	if (!socket.waitForBytesWritten(ForwardTimeout))
+		return false;
+
+	while (!socket.canReadLine()) {
+		if (!socket.waitForReadyRead(ForwardTimeout))
+			return false;
+	}
+
+	return socket.readLine().trimmed() == "ok";
+}
+
+/**
+ * Splits a PATH[:LINE[:COLUMN]] argument into a location.
+ * This is the form in which compilers report locations, which allows paths
+ * to be copied directly from build logs.
+ * @param  arg  The argument to parse
+ * @return The matching location
+ */
+Core::Location InstanceServer::parseLocation(const QString& arg)
+{
+	Core::Location loc(arg);
+	uint numbers[2];
+	int count = 0;
+
+	// Strip up to two trailing numbers.
+	QString path = arg;
+	while (count < 2) {
+		int colon = path.lastIndexOf(':');
+		if (colon <= 0)
+			break;
+
+		bool ok;
+		uint value = path.mid(colon + 1).toUInt(&ok);
+		if (!ok)
+			break;
+
+		numbers[count++] = value;
+		path.truncate(colon);
+	}
+
+	if (count == 0)
+		return loc;
+
+	loc.file_ = path;
+	if (count == 1) {
+		loc.line_ = numbers[0];
+	}
+	else {
+		loc.line_ = numbers[1];
+		loc.column_ = numbers[0];
+	}
+
+	return loc;
+}
+
+/**
+ * Carries out a forwarded request.
+ * @param  request  The fields of the request
+ * @return true if the request was handled, false if the new invocation needs
+ *         to handle it itself
+ */
+bool InstanceServer::handle(const QStringList& request)
+{
+	if (request.size() == 4 && request[0] == "file") {
+		mainWnd_->openFile(request[1], request[2].toUInt(),
+		                   request[3].toUInt());
+	}
+	else if (request.size() == 2 && request[0] == "project") {
+		if (!ProjectManager::hasProject())
+			return false;
+
+		QString openPath = QDir(ProjectManager::project()->path())
+		                   .canonicalPath();
+		if (openPath != QDir(request[1]).canonicalPath())
+			return false;
+	}
+	else {
+		return false;
+	}
+
+	// Bring the window to the front.
+	if (mainWnd_->isMinimized())
+		mainWnd_->showNormal();
+
+	mainWnd_->raise();
+	mainWnd_->activateWindow();
+	return true;
+}
+
+/**
+ * The socket is created in the user's runtime directory, if there is one,
+ * which is private to the user. Otherwise, the user name is part of the
+ * socket name, which is created in the system's temporary directory.
+ * @return The name of the socket shared by all instances of the current user
+ */
+QString InstanceServer::serverName()
+{
+	QByteArray runtimeDir = qgetenv("XDG_RUNTIME_DIR");
+	if (!runtimeDir.isEmpty())
+		return QDir(QFile::decodeName(runtimeDir)).filePath("kscope");
+
+	QString user = qgetenv("USER");
+	if (user.isEmpty())
+		user = qgetenv("USERNAME");
+
+	return QString("kscope-%1").arg(user);
+}
+
+/**
+ * Handles connections from new invocations.
+ */
+void InstanceServer::newConnection()
+{
+	QLocalSocket* socket;
+	while ((socket = server_.nextPendingConnection()) != NULL) {
+		connect(socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+		connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+	}
+}
+
+/**
+ * Answers all complete requests received on a connection.
+ */
+void InstanceServer::readRequests()
+{
+	QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+	if (!socket)
+		return;
+
+	while (socket->canReadLine()) {
+		QString line = QString::fromUtf8(socket->readLine()).trimmed();
+		bool handled = handle(line.split('\t'));
+		qDebug() << "Forwarded request" << line << handled;
+		socket->write(handled ? "ok\n" : "no\n");
+	}
+
+	socket->flush();
+}
+
+} // namespace App
+
+} // namespace KScope
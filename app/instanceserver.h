@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __APP_INSTANCESERVER_H__
+#define __APP_INSTANCESERVER_H__
+
+#include <QLocalServer>
+#include <QStringList>
+#include <core/globals.h>
+
+namespace KScope
+{
+
+namespace App
+{
+
+class MainWindow;
+
+/**
+ * Lets a running instance of KScope handle the requests of new invocations.
+ * The first instance listens on a per-user local socket. Later invocations
+ * with a -f or -p option connect to that socket, forward the request and exit
+ * if the running instance accepts it, which saves a full application start
+ * and project load. A file request (-f PATH[:LINE[:COLUMN]]) is always
+ * accepted, while a project request (-p PATH) is only accepted if the running
+ * instance has the same project open.
+ * Requests are single lines of tab-separated fields, each answered by a line
+ * holding "ok" or "no".
+ * @author Elad Lahav
+ */
+class InstanceServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	InstanceServer(MainWindow* mainWnd, QObject* parent = NULL);
+	~InstanceServer();
+
+	bool listen();
+
+	static bool forward(const QStringList& args);
+	static Core::Location parseLocation(const QString& arg);
+
+private:
+	/**
+	 * The window that handles requests.
+	 */
+	MainWindow* mainWnd_;
+
+	/**
+	 * Accepts connections from new invocations.
+	 */
+	QLocalServer server_;
+
+	bool handle(const QStringList& request);
+
+	static QString serverName();
+
+private slots:
+	void newConnection();
+	void readRequests();
+};
+
+} // namespace App
+
+} // namespace KScope
+
+#endif // __APP_INSTANCESERVER_H__
@@ -19,9 +19,24 @@
  ***************************************************************************/
 
 #include "application.h"
+#include "batchquery.h"
+#include "version.h"
 
 int main(int argc, char *argv[])
 {
+	// Batch mode does not require a display.
+	if (KScope::App::BatchQuery::isBatch(argc, argv)) {
+		QCoreApplication app(argc, argv);
+		QCoreApplication::setOrganizationName(
+			"elad_lahav@users.sourceforge.net");
+		QCoreApplication::setApplicationName("KScope");
+		QCoreApplication::setApplicationVersion(
+			KScope::App::AppVersion::toString());
+
+		KScope::App::BatchQuery batch;
+		return batch.run(app.arguments());
+	}
+
 	KScope::App::Application app(argc, argv);
 	return app.run();
 }
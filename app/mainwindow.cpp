@@ -23,8 +23,12 @@
 #include <QStatusBar>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QInputDialog>
+#include <QDateTime>
 #include <core/fileutils.h>
+#include <core/gitindex.h>
 #include <cscope/managedproject.h>
+#include <global/managedproject.h>
 #include <editor/editor.h>
 #include "mainwindow.h"
 #include "editorcontainer.h"
@@ -37,6 +41,7 @@
 #include "openprojectdialog.h"
 #include "projectfilesdialog.h"
 #include "configenginesdialog.h"
+#include "renamedialog.h"
 
 namespace KScope
 {
@@ -87,6 +92,9 @@ MainWindow::MainWindow() : QMainWindow(), actions_(this)
 	// Rebuild the project when signalled by the project manager.
 	connect(ProjectManager::signalProxy(), SIGNAL(buildProject()), this,
 	        SLOT(buildProject()));
+
+	connect(ProjectManager::signalProxy(), SIGNAL(workspaceChanged()), this,
+	        SLOT(workspaceChanged()));
 }
 
 /**
@@ -117,9 +125,11 @@ void MainWindow::promptQuery(Core::Query::Type type)
 
 	//arguments to cscope
 	uint flags = queryDlg_->caseless ? Core::Query::IgnoreCase : 0;
+	Core::Query query(queryDlg_->type(), queryDlg_->pattern(), flags);
+	query.pathPrefixes_ = queryDlg_->pathPrefixes();
 	
 	// Start a query with results shown in a view inside the query dock.
-	queryDock_->query(Core::Query(queryDlg_->type(), queryDlg_->pattern(), flags), false);
+	queryDock_->query(query, false);
 }
 
 /**
@@ -213,6 +223,160 @@ void MainWindow::promptCallTree()
 	                  true);
 }
 
+/**
+ * Prompts the user for two queries and a set operation, and displays the
+ * combined results in the query dock.
+ */
+void MainWindow::promptComposedQuery()
+{
+	Core::Query queries[2];
+	QString titles[2] = { tr("First Query"), tr("Second Query") };
+
+	for (int i = 0; i < 2; i++) {
+		queryDlg_->setWindowTitle(titles[i]);
+		if (queryDlg_->exec(Core::Query::References) != QDialog::Accepted)
+			return;
+
+		uint flags = queryDlg_->caseless ? Core::Query::IgnoreCase : 0;
+		queries[i] = Core::Query(queryDlg_->type(), queryDlg_->pattern(),
+		                         flags);
+		queries[i].pathPrefixes_ = queryDlg_->pathPrefixes();
+	}
+
+	// Choose an operation.
+	QStringList opList;
+	opList << tr("Same location in both")
+	       << tr("Same scope in both")
+	       << tr("Location in either")
+	       << tr("Scope in either")
+	       << tr("Location in first but not in second")
+	       << tr("Scope in first but not in second");
+
+	bool ok;
+	QString opStr = QInputDialog::getItem(this, tr("Combine Queries"),
+	                                      tr("Show results with"), opList,
+	                                      0, false, &ok);
+	if (!ok)
+		return;
+
+	int index = opList.indexOf(opStr);
+	Core::QueryComposer::Operation op
+		= static_cast<Core::QueryComposer::Operation>(index / 2);
+	Core::QueryComposer::Key key
+		= (index % 2) ? Core::QueryComposer::ScopeKey
+		              : Core::QueryComposer::LocationKey;
+
+	queryDock_->compose(queries[0], queries[1], op, key);
+}
+
+/**
+ * Prompts the user for a snapshot and a query, and displays the results that
+ * were added or removed since the snapshot was taken.
+ */
+void MainWindow::promptSnapshotQuery()
+{
+	QStringList names = ProjectManager::engine().snapshots();
+	if (names.isEmpty()) {
+		QMessageBox::information(this, tr("Compare with Snapshot"),
+		                         tr("No database snapshots are available"));
+		return;
+	}
+
+	bool ok;
+	QString name = QInputDialog::getItem(this, tr("Compare with Snapshot"),
+	                                     tr("Snapshot"), names, 0, false,
+	                                     &ok);
+	if (!ok)
+		return;
+
+	queryDlg_->setWindowTitle(tr("Compare with Snapshot"));
+	Editor::Editor* editor = editCont_->currentEditor();
+	if (editor)
+		queryDlg_->setPattern(editor->currentSymbol());
+
+	// Text searches read the current files, and so cannot be compared.
+	QueryDialog::TypeList typeList;
+	typeList << Core::Query::References << Core::Query::Definition
+	         << Core::Query::CalledFunctions << Core::Query::CallingFunctions
+	         << Core::Query::FindFile << Core::Query::IncludingFiles;
+	if (queryDlg_->exec(Core::Query::CallingFunctions, typeList)
+	    != QDialog::Accepted) {
+		return;
+	}
+
+	uint flags = queryDlg_->caseless ? Core::Query::IgnoreCase : 0;
+	Core::Query query(queryDlg_->type(), queryDlg_->pattern(), flags);
+	query.pathPrefixes_ = queryDlg_->pathPrefixes();
+
+	// The snapshot engine is only needed to start the query.
+	Core::Engine* snapshot = ProjectManager::engine().openSnapshot(name);
+	if (!snapshot)
+		return;
+
+	queryDock_->compare(query, *snapshot, name);
+	delete snapshot;
+}
+
+/**
+ * Displays a code metrics report in the query dock.
+ * @param  report  The name of the report
+ */
+void MainWindow::showMetrics(const QString& report)
+{
+	queryDock_->query(Core::Query(Core::Query::Metrics, report), false);
+}
+
+/**
+ * Renames a symbol across the code base.
+ * The references to the symbol are found and checked by a RenameDialog, which
+ * shows the changes before writing them. Open editors of the changed files
+ * are reloaded, and the database is then rebuilt. Both Cscope and GNU Global
+ * only re-parse files that were modified since the last build.
+ */
+void MainWindow::promptRename()
+{
+	// Use the symbol under the cursor as the default.
+	QString oldName;
+	Editor::Editor* editor = editCont_->currentEditor();
+	if (editor)
+		oldName = editor->currentSymbol();
+
+	bool ok;
+	oldName = QInputDialog::getText(this, tr("Rename Symbol"),
+	                                tr("Symbol to rename"), QLineEdit::Normal,
+	                                oldName, &ok);
+	if (!ok || oldName.isEmpty())
+		return;
+
+	QString newName = QInputDialog::getText(this, tr("Rename Symbol"),
+	                                        tr("Rename '%1' to").arg(oldName),
+	                                        QLineEdit::Normal, oldName, &ok);
+	if (!ok || (newName == oldName))
+		return;
+
+	if (!Core::Rename::isValidName(oldName)
+	    || !Core::Rename::isValidName(newName)) {
+		QMessageBox::warning(this, tr("Rename Symbol"),
+		                     tr("Only symbol names can be renamed"));
+		return;
+	}
+
+	// Files with unsaved changes are not touched.
+	RenameDialog dlg(oldName, newName, editCont_->modifiedFiles(), this);
+	connect(&dlg, SIGNAL(locationRequested(const Core::Location&)),
+	        editCont_, SLOT(gotoLocation(const Core::Location&)));
+	dlg.start();
+	if (dlg.exec() != QDialog::Accepted)
+		return;
+
+	QStringList files = dlg.changedFiles();
+	if (files.isEmpty())
+		return;
+
+	editCont_->reloadFiles(files);
+	buildProject();
+}
+
 /**
  * Starts a build process for the current project's engine.
  * Provides progress information in either a modal dialogue or a progress-bar
@@ -243,11 +407,13 @@ void MainWindow::buildProject()
 
 /**
  * Opens the given file for editing.
- * @param  path  The path of the requested file
+ * @param  path    The path of the requested file
+ * @param  line    The line to go to (0 to keep the current position)
+ * @param  column  The column to go to
  */
-void MainWindow::openFile(const QString& path)
+void MainWindow::openFile(const QString& path, uint line, uint column)
 {
-	editCont_->gotoLocation(Core::Location(path));
+	editCont_->gotoLocation(Core::Location(path, line, column));
 }
 
 /**
@@ -268,16 +434,40 @@ void MainWindow::newProject()
 			return;
 	}
 
+	// Choose the indexing engine.
+	QStringList engineList;
+	engineList << Core::EngineConfig<Cscope::Crossref>::name()
+	           << Core::EngineConfig<Global::Crossref>::name();
+
+	bool ok;
+	QString engine = QInputDialog::getItem(this, tr("New Project"),
+	                                       tr("Indexing engine"), engineList,
+	                                       0, false, &ok);
+	if (!ok)
+		return;
+
+	if (engine == Core::EngineConfig<Global::Crossref>::name())
+		createProject<Global::ManagedProject>();
+	else
+		createProject<Cscope::ManagedProject>();
+}
+
+/**
+ * Prompts for the parameters of a new project, and creates it.
+ */
+template<class ProjectT>
+void MainWindow::createProject()
+{
 redo:
 	// Show the "New Project" dialogue.
 	ProjectDialog dlg(this);
-	dlg.setParamsForProject<Cscope::ManagedProject>(NULL);
+	dlg.setParamsForProject<ProjectT>(NULL);
 	if (dlg.exec() == QDialog::Rejected)
 		return;
 
 	// Get the new parameters from the dialogue.
 	Core::ProjectBase::Params params;
-	dlg.getParams<Cscope::ManagedProject>(params);
+	dlg.getParams<ProjectT>(params);
 
 	try {
         QDir dir(params.projPath_);
@@ -295,11 +485,11 @@ redo:
         }
 
 		// Create a project.
-		Cscope::ManagedProject proj;
+		ProjectT proj;
 		proj.create(params);
 
 		// Load the new project.
-		ProjectManager::load<Cscope::ManagedProject>(params.projPath_);
+		ProjectManager::load<ProjectT>(params.projPath_);
 	}
 	catch (Core::Exception* e) {
 		e->showMessage();
@@ -331,7 +521,7 @@ void MainWindow::openProject()
 	switch (dlg.exec()) {
 	case OpenProjectDialog::Open:
 		try {
-			ProjectManager::load<Cscope::ManagedProject>(dlg.path());
+			ProjectManager::load(dlg.path());
 		}
 		catch (Core::Exception* e) {
 			e->showMessage();
@@ -348,6 +538,61 @@ void MainWindow::openProject()
 	}
 }
 
+/**
+ * Handles the "Project->Add to Workspace..." action.
+ * Opens another project alongside the active one. Queries are then run on
+ * all projects.
+ */
+void MainWindow::addToWorkspace()
+{
+	OpenProjectDialog dlg(this);
+	if (dlg.exec() != OpenProjectDialog::Open)
+		return;
+
+	try {
+		ProjectManager::addProject(dlg.path());
+	}
+	catch (Core::Exception* e) {
+		e->showMessage();
+		delete e;
+	}
+}
+
+/**
+ * Handles the "Project->Create Snapshot" action.
+ * The snapshot is named after the commit checked out in the code base, if it
+ * is a git work tree, or after the current time otherwise.
+ */
+void MainWindow::createSnapshot()
+{
+	Core::GitIndex gitIndex;
+	QString name;
+	if (gitIndex.open(ProjectManager::project()->rootPath()))
+		name = gitIndex.head().left(12);
+
+	if (name.isEmpty())
+		name = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+
+	bool ok;
+	name = QInputDialog::getText(this, tr("Create Snapshot"),
+	                             tr("Snapshot name"), QLineEdit::Normal, name,
+	                             &ok).trimmed();
+	if (!ok || name.isEmpty())
+		return;
+
+	try {
+		if (!ProjectManager::engine().createSnapshot(name)) {
+			QMessageBox::warning(this, tr("Create Snapshot"),
+			                     tr("Failed to create a snapshot of the "
+			                        "database"));
+		}
+	}
+	catch (Core::Exception* e) {
+		e->showMessage();
+		delete e;
+	}
+}
+
 /**
  * Handles the "Project->Close" action.
  * Closes all editor windows, and saves the session (if it is part of a
@@ -365,6 +610,7 @@ bool MainWindow::closeProject()
 	if (ProjectManager::hasProject()) {
 		// Store session information.
 		Session session(ProjectManager::project()->path());
+		session.setWorkspace(ProjectManager::workspacePaths());
 		editCont_->saveSession(session);
 		queryDock_->saveSession(session);
 		queryDock_->closeAll();
@@ -400,12 +646,25 @@ void MainWindow::projectFiles()
 void MainWindow::projectProperties()
 {
 	// Get the active project.
-	const Cscope::ManagedProject* project
-		= dynamic_cast<const Cscope::ManagedProject*>
-			(ProjectManager::project());
-	if (project == NULL)
+	if (!ProjectManager::hasProject())
 		return;
 
+	const Core::ProjectBase* project = ProjectManager::project();
+	if (dynamic_cast<const Cscope::ManagedProject*>(project)) {
+		editProject(dynamic_cast<const Cscope::ManagedProject*>(project));
+	}
+	else if (dynamic_cast<const Global::ManagedProject*>(project)) {
+		editProject(dynamic_cast<const Global::ManagedProject*>(project));
+	}
+}
+
+/**
+ * Shows the "Project Properties" dialogue for a project of a specific type.
+ * @param  project  The active project
+ */
+template<class ProjectT>
+void MainWindow::editProject(const ProjectT* project)
+{
 	// Create the project properties dialogue.
 	ProjectDialog dlg(this);
 	dlg.setParamsForProject(project);
@@ -414,7 +673,7 @@ void MainWindow::projectProperties()
 
 	// Get the new parameters from the dialogue.
 	Core::ProjectBase::Params params;
-	dlg.getParams<Cscope::ManagedProject>(params);
+	dlg.getParams<ProjectT>(params);
 
 	bool rebuild = false;
 	try {
@@ -504,9 +763,14 @@ void MainWindow::readSettings()
 void MainWindow::setWindowTitle(bool hasProject)
 {
 	QString title = qApp->applicationName();
-	if (hasProject)
+	if (hasProject) {
 		title += " - " + ProjectManager::project()->name();
 
+		QStringList names = ProjectManager::workspaceNames();
+		if (!names.isEmpty())
+			title += " + " + names.join(" + ");
+	}
+
 	QMainWindow::setWindowTitle(title);
 }
 
@@ -531,6 +795,17 @@ void MainWindow::projectOpenedClosed(bool opened)
 	editCont_->loadSession(session);
 	queryDock_->loadSession(session);
 
+	// Re-open the other projects in the workspace.
+	foreach (QString path, session.workspace()) {
+		try {
+			ProjectManager::addProject(path);
+		}
+		catch (Core::Exception* e) {
+			e->showMessage();
+			delete e;
+		}
+	}
+
 	try {
 		// Show the project files dialogue if files need to be added to the
 		// project.
@@ -543,6 +818,14 @@ void MainWindow::projectOpenedClosed(bool opened)
 	}
 }
 
+/**
+ * Called when a project is added to the workspace.
+ */
+void MainWindow::workspaceChanged()
+{
+	setWindowTitle(true);
+}
+
 } // namespace App
 
 } // namespace KScope
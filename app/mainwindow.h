@@ -58,12 +58,18 @@ public slots:
 	void promptQuery(Core::Query::Type type = Core::Query::References);
 	void quickDefinition();
 	void promptCallTree();
+	void promptComposedQuery();
+	void promptSnapshotQuery();
+	void showMetrics(const QString&);
+	void promptRename();
 	void buildProject();
-	void openFile(const QString&);
+	void openFile(const QString&, uint line = 0, uint column = 0);
 
 	// Action handlers.
 	void newProject();
 	void openProject();
+	void addToWorkspace();
+	void createSnapshot();
 	bool closeProject();
 	void projectFiles();
 	void projectProperties();
@@ -102,10 +108,17 @@ private:
 
 	void readSettings();
 	void writeSettings();
+
+	template<class ProjectT>
+	void createProject();
+
+	template<class ProjectT>
+	void editProject(const ProjectT*);
 	void setWindowTitle(bool);
 
 private slots:
 	void projectOpenedClosed(bool);
+	void workspaceChanged();
 };
 
 } // namespace App
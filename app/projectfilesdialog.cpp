@@ -18,6 +18,7 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
+#include <QDir>
 #include <core/codebasemodel.h>
 #include "application.h"
 #include "projectfilesdialog.h"
@@ -42,6 +43,13 @@ ProjectFilesDialog::ProjectFilesDialog(QWidget* parent)
 		Core::CodebaseModel* model
 			= new Core::CodebaseModel(codebase, proj->rootPath(), this);
 		view_->setModel(model);
+
+		// Files taken from a compilation database cannot be edited.
+		bool canModify = ProjectManager::codebase().canModify();
+		addButton_->setEnabled(canModify);
+		removeButton_->setEnabled(canModify);
+
+		loadSnapshot();
 	}
 	catch (Core::Exception* e) {
 		e->showMessage();
@@ -63,7 +71,13 @@ void ProjectFilesDialog::accept()
 
 	// Update the code base.
 	try {
-		ProjectManager::codebase().setFiles(fileList);
+		if (ProjectManager::codebase().canModify()) {
+			ProjectManager::codebase().setFiles(fileList);
+
+			// The next scan only needs to read directories that changed
+			// since.
+			snapshot_.save();
+		}
 	}
 	catch (Core::Exception* e) {
 		e->showMessage();
@@ -75,15 +89,21 @@ void ProjectFilesDialog::accept()
 
 void ProjectFilesDialog::addFiles()
 {
-	AddFilesDialog dlg(this);
-	if (dlg.exec() == QDialog::Accepted) {
-		QStringList fileList;
-		dlg.fileList(fileList);
-
-		Core::CodebaseModel* model
-			= static_cast<Core::CodebaseModel*>(view_->model());
-		model->addFiles(fileList);
+	AddFilesDialog dlg(&snapshot_, this);
+	if (dlg.exec() != QDialog::Accepted) {
+		// Discard the listings of scans whose results were not used.
+		loadSnapshot();
+		return;
 	}
+
+	QStringList fileList, removedList;
+	dlg.fileList(fileList);
+	dlg.removedFiles(removedList);
+
+	Core::CodebaseModel* model
+		= static_cast<Core::CodebaseModel*>(view_->model());
+	model->removeFiles(removedList);
+	model->addFiles(fileList);
 }
 
 void ProjectFilesDialog::removeFiles()
@@ -91,6 +111,15 @@ void ProjectFilesDialog::removeFiles()
 	// TODO: Implement!
 }
 
+/**
+ * Reads the listings of the last scan of the project from its file.
+ */
+void ProjectFilesDialog::loadSnapshot()
+{
+	snapshot_.load(QDir(ProjectManager::project()->path())
+	               .filePath("dirsnapshot"));
+}
+
 }
 
 }
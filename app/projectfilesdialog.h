@@ -22,6 +22,7 @@
 #define __KSCOPE_PROJECTFILESDIALOG_H__
 
 #include <QDialog>
+#include <core/dirsnapshot.h>
 #include "ui_projectfilesdialog.h"
 
 namespace KScope
@@ -44,6 +45,16 @@ public slots:
 protected slots:
 	void addFiles();
 	void removeFiles();
+
+private:
+	/**
+	 * Listings of directories from the last scan of the project.
+	 * The snapshot is only saved once the code base is updated, so that it
+	 * always describes files that are in the project.
+	 */
+	Core::DirSnapshot snapshot_;
+
+	void loadSnapshot();
 };
 
 }
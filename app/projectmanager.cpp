@@ -18,7 +18,10 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
+#include <QDir>
 #include <core/exception.h>
+#include <cscope/managedproject.h>
+#include <global/managedproject.h>
 #include "projectmanager.h"
 
 namespace KScope
@@ -28,8 +31,17 @@ namespace App
 {
 
 Core::ProjectBase* ProjectManager::proj_ = NULL;
+QList<Core::ProjectBase*> ProjectManager::workspace_;
+Core::MultiEngine ProjectManager::multiEngine_;
+Core::CachedEngine ProjectManager::cachedEngine_;
+Core::CodebaseWatcher ProjectManager::watcher_;
 ProjectManagerSignals ProjectManager::signals_;
 
+/**
+ * The number of queries run in the background after a project is opened.
+ */
+static const int WarmQueries = 20;
+
 const Core::ProjectBase* ProjectManager::project()
 {
 	if (proj_ == NULL)
@@ -43,6 +55,10 @@ Core::Engine& ProjectManager::engine()
 	if (proj_ == NULL)
 		throw Core::Exception("No project is currently loaded");
 
+	// The cache is attached once the project is ready.
+	if (cachedEngine_.engine() != NULL)
+		return cachedEngine_;
+
 	Core::Engine* engine = proj_->engine();
 	if (engine == NULL)
 		throw new Core::Exception("No engine is available");
@@ -67,6 +83,58 @@ const ProjectManagerSignals* ProjectManager::signalProxy()
 	return &signals_;
 }
 
+/**
+ * Loads a project of the type matching the contents of the given directory.
+ * @param  projPath  The project directory
+ * @throw  Exception
+ */
+void ProjectManager::load(const QString& projPath)
+{
+	if (Global::ManagedProject::isProject(projPath))
+		load<Global::ManagedProject>(projPath);
+	else
+		load<Cscope::ManagedProject>(projPath);
+}
+
+/**
+ * Opens a project of the type matching the contents of the given directory,
+ * in addition to the active one.
+ * @param  projPath  The project directory
+ * @throw  Exception
+ */
+void ProjectManager::addProject(const QString& projPath)
+{
+	if (Global::ManagedProject::isProject(projPath))
+		addProject<Global::ManagedProject>(projPath);
+	else
+		addProject<Cscope::ManagedProject>(projPath);
+}
+
+/**
+ * @return The directories of the projects opened in addition to the active
+ *         one
+ */
+QStringList ProjectManager::workspacePaths()
+{
+	QStringList paths;
+	foreach (Core::ProjectBase* proj, workspace_)
+		paths.append(proj->path());
+
+	return paths;
+}
+
+/**
+ * @return The names of the projects opened in addition to the active one
+ */
+QStringList ProjectManager::workspaceNames()
+{
+	QStringList names;
+	foreach (Core::ProjectBase* proj, workspace_)
+		names.append(proj->name());
+
+	return names;
+}
+
 void ProjectManager::updateConfig(Core::ProjectBase::Params& params)
 {
 	// Make sure a project is loaded.
@@ -91,6 +159,22 @@ void ProjectManager::close()
 	if (proj_ == NULL)
 		return;
 
+	// Stop tracking the code base.
+	watcher_.stop();
+	QObject::disconnect(&watcher_, NULL, NULL, NULL);
+
+	// Remember which queries were used.
+	cachedEngine_.usage().save();
+	cachedEngine_.setEngine(NULL);
+
+	// Close additional projects.
+	multiEngine_.clear();
+	foreach (Core::ProjectBase* proj, workspace_) {
+		proj->close();
+		delete proj;
+	}
+	workspace_.clear();
+
 	// Close the project.
 	proj_->close();
 	delete proj_;
@@ -108,13 +192,74 @@ void ProjectManager::finishLoad()
 	// Does the database need to be rebuilt?
 	Core::Engine* engine = proj_->engine();
 	if (engine) {
+		// Answer queries through the cache, which becomes stale whenever the
+		// code base changes.
+		cachedEngine_.setEngine(engine);
+		QObject::connect(proj_->codebase(), SIGNAL(modified()), &cachedEngine_,
+		                 SLOT(clearCache()));
+		cachedEngine_.usage().load(QDir(proj_->path()).filePath("usage"));
+
+		// Keep the file list up to date as files are created and deleted,
+		// in the directories scanned when files were last added.
+		Core::Codebase* cbase = proj_->codebase();
+		if (cbase->canModify()) {
+			QString snapshotPath
+				= QDir(proj_->path()).filePath("dirsnapshot");
+			if (watcher_.start(cbase, snapshotPath)) {
+				QObject::connect(&watcher_,
+				                 SIGNAL(filesChanged(const QStringList&,
+				                                     const QStringList&)),
+				                 cbase,
+				                 SLOT(updateFiles(const QStringList&,
+				                                  const QStringList&)));
+				QObject::connect(cbase,
+				                 SIGNAL(filesChanged(const QStringList&,
+				                                     const QStringList&)),
+				                 &cachedEngine_, SLOT(clearCache()));
+				// Queued, so that the snapshot saved along with a new file
+				// list is read.
+				QObject::connect(cbase, SIGNAL(modified()), &watcher_,
+				                 SLOT(refresh()), Qt::QueuedConnection);
+			}
+		}
+
 		if ((engine->status() == Core::Engine::Build)
 		     || (engine->status() == Core::Engine::Rebuild)) {
 			signals_.emitBuildProject();
 		}
+		else {
+			cachedEngine_.warm(WarmQueries);
+		}
 	}
 }
 
+/**
+ * Adds a newly-opened project to the workspace.
+ * @param  proj  The project
+ */
+void ProjectManager::finishAdd(Core::ProjectBase* proj)
+{
+	// The active project may have been closed in the meantime.
+	if (!proj_) {
+		proj->close();
+		delete proj;
+		return;
+	}
+
+	// The first additional project turns queries into workspace queries.
+	if (workspace_.isEmpty())
+		multiEngine_.addEngine(proj_->name(), proj_->engine());
+
+	workspace_.append(proj);
+	multiEngine_.addEngine(proj->name(), proj->engine());
+
+	// Queries span all projects in a workspace.
+	cachedEngine_.setEngine(&multiEngine_);
+	QObject::connect(proj->codebase(), SIGNAL(modified()), &cachedEngine_,
+	                 SLOT(clearCache()));
+	signals_.emitWorkspaceChanged();
+}
+
 } // namespace App
 
 } // namespace KScope
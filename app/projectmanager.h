@@ -23,6 +23,9 @@
 
 #include <QObject>
 #include <core/project.h>
+#include <core/multiengine.h>
+#include <core/cachedengine.h>
+#include <core/codebasewatcher.h>
 #include "application.h"
 
 namespace KScope
@@ -44,6 +47,7 @@ class ProjectManagerSignals : public QObject
 signals:
 	void hasProject(bool has);
 	void buildProject();
+	void workspaceChanged();
 
 private:
 	ProjectManagerSignals() : QObject() {}
@@ -56,6 +60,10 @@ private:
 		emit buildProject();
 	}
 
+	void emitWorkspaceChanged() {
+		emit workspaceChanged();
+	}
+
 	friend class ProjectManager;
 };
 
@@ -64,6 +72,12 @@ private:
  * Maintains a ProjectBase object, which is the one and only active project in
  * the application. Also, provides safe access to the engine and code base
  * objects of the project.
+ * Additional projects can be opened alongside the active one, forming a
+ * workspace. While a workspace exists, engine() returns an engine that passes
+ * queries to all projects concurrently. The code base remains that of the
+ * active project.
+ * Queries are answered through a cache, which is warmed up with the queries
+ * used most in the active project as soon as that project is opened.
  * @author Elad Lahav
  */
 class ProjectManager
@@ -94,14 +108,65 @@ public:
 		Application::settings().addRecentProject(projPath, proj_->name());
 	}
 
+	/**
+	 * Opens a project in addition to the active one.
+	 * @param  projPath  The project directory
+	 * @throw  Exception
+	 */
+	template<class ProjectT>
+	static void addProject(const QString& projPath) {
+		// The first project becomes the active one.
+		if (!proj_) {
+			load<ProjectT>(projPath);
+			return;
+		}
+
+		// Do not open the same project twice, nor the active one again.
+		if ((projPath == proj_->path())
+		    || workspacePaths().contains(projPath)) {
+			return;
+		}
+
+		ProjectT* proj = NULL;
+		try {
+			proj = new ProjectT(projPath);
+			proj->open(new AddCallback(proj));
+		}
+		catch (Core::Exception* e) {
+			delete proj;
+			throw e;
+		}
+	}
+
+	static void load(const QString&);
+	static void addProject(const QString&);
+	static QStringList workspacePaths();
+	static QStringList workspaceNames();
 	static void updateConfig(Core::ProjectBase::Params&);
 	static void close();
 
 private:
 	static Core::ProjectBase* proj_;
+	static QList<Core::ProjectBase*> workspace_;
+	static Core::MultiEngine multiEngine_;
+	static Core::CachedEngine cachedEngine_;
+	static Core::CodebaseWatcher watcher_;
 	static ProjectManagerSignals signals_;
 
 	static void finishLoad();
+	static void finishAdd(Core::ProjectBase*);
+
+	struct AddCallback : public Core::Callback<>
+	{
+		AddCallback(Core::ProjectBase* proj) : proj_(proj) {}
+
+		void call() {
+			ProjectManager::finishAdd(proj_);
+			delete this;
+		}
+
+		Core::ProjectBase* proj_;
+	};
 
 	struct OpenCallback : public Core::Callback<>
 	{
@@ -0,0 +1,577 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+#include <core/corestrings.h>
+#include <core/exception.h>
+#include "batchquery.h"
+#include "querydaemon.h"
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Class constructor.
+ * @param  engine    The engine used to answer queries
+ * @param  codebase  The project's code base (used to invalidate cached
+ *                   results)
+ * @param  dbPath    The directory holding the database files (used to
+ *                   invalidate cached results)
+ * @param  parent    Parent object
+ */
+QueryDaemon::QueryDaemon(Core::Engine& engine, Core::Codebase& codebase,
+                         const QString& dbPath, QObject* parent)
+	: QObject(parent), engine_(engine), building_(NULL), dbPath_(dbPath)
+{
+	dbTime_ = databaseTime();
+
+	connect(&server_, SIGNAL(newConnection()), this, SLOT(newConnection()));
+	connect(&codebase, SIGNAL(modified()), this, SLOT(clearCache()));
+	connect(&engine_, SIGNAL(indicesChanged()), this, SLOT(clearCache()));
+	connect(&engine_, SIGNAL(indicesChanged()), this, SLOT(runWaiting()));
+}
+
+/**
+ * Class destructor.
+ */
+QueryDaemon::~QueryDaemon()
+{
+}
+
+/**
+ * Starts accepting clients.
+ * A socket left behind by a previous instance that did not exit cleanly is
+ * removed.
+ * @param  name  The server name (or the path of a Unix domain socket)
+ * @return true if successful, false otherwise
+ */
+bool QueryDaemon::listen(const QString& name)
+{
+	QLocalServer::removeServer(name);
+	server_.setSocketOptions(QLocalServer::UserAccessOption);
+	return server_.listen(name);
+}
+
+/**
+ * Creates an object for each new client.
+ * The client object deletes itself when the connection is closed.
+ */
+void QueryDaemon::newConnection()
+{
+	QLocalSocket* socket;
+	while ((socket = server_.nextPendingConnection()) != NULL)
+		new DaemonClient(*this, socket);
+}
+
+/**
+ * Invalidates all cached results.
+ */
+void QueryDaemon::clearCache()
+{
+	cache_.clear();
+}
+
+/**
+ * Discards cached results if the database files changed since the cache was
+ * last validated.
+ * Another process (e.g., a second KScope instance, or "cscope -b") may rebuild
+ * the database without the daemon's knowledge.
+ */
+void QueryDaemon::checkDatabase()
+{
+	QDateTime time = databaseTime();
+	if (time == dbTime_)
+		return;
+
+	qDebug() << "Database changed, clearing the cache";
+	dbTime_ = time;
+	cache_.clear();
+}
+
+/**
+ * Database files are usually replaced by renaming new ones over them, which
+ * updates the time of the directory, but may also be written in place.
+ * @return The latest modification time of the database directory and the
+ *         files in it
+ */
+QDateTime QueryDaemon::databaseTime() const
+{
+	QDateTime result = QFileInfo(dbPath_).lastModified();
+
+	QFileInfoList infos = QDir(dbPath_).entryInfoList(QDir::Files);
+	QFileInfoList::ConstIterator itr;
+	for (itr = infos.begin(); itr != infos.end(); ++itr) {
+		if ((*itr).lastModified() > result)
+			result = (*itr).lastModified();
+	}
+
+	return result;
+}
+
+/**
+ * Starts the queries that were waiting for the engine's indices.
+ * Queries that still cannot be answered are put back on the list.
+ */
+void QueryDaemon::runWaiting()
+{
+	QList<DaemonRequest*> waitList;
+	waitList.swap(waitList_);
+
+	QList<DaemonRequest*>::Iterator itr;
+	for (itr = waitList.begin(); itr != waitList.end(); ++itr)
+		(*itr)->run();
+}
+
+/**
+ * Class constructor.
+ * @param  daemon  The owning daemon
+ * @param  client  The client that sent the request
+ * @param  id      The client-assigned request ID
+ */
+DaemonRequest::DaemonRequest(QueryDaemon& daemon, DaemonClient* client,
+                             const QJsonValue& id)
+	: QObject(), Core::Engine::Connection(), daemon_(daemon), client_(client),
+	  id_(id), build_(false), waiting_(false)
+{
+	timer_.start();
+}
+
+/**
+ * Class destructor.
+ */
+DaemonRequest::~DaemonRequest()
+{
+}
+
+/**
+ * Answers a query, either from the cache or by passing it to the engine.
+ * Queries that read the current contents of files are never answered from
+ * the cache.
+ * @param  query  The query to run
+ */
+void DaemonRequest::query(const Core::Query& query)
+{
+	query_ = query;
+	fields_ = daemon_.engine_.queryFields(query.type_);
+
+	// Try the cache first.
+	daemon_.checkDatabase();
+	if (Core::QueryCache::isCacheable(query)
+	    && daemon_.cache_.find(query, locList_)) {
+		sendResults(locList_);
+		onFinished();
+		return;
+	}
+
+	run();
+}
+
+/**
+ * Passes the query to the engine, or holds it until the engine can answer
+ * it.
+ */
+void DaemonRequest::run()
+{
+	waiting_ = !daemon_.engine_.canQuery(query_);
+	if (waiting_) {
+		daemon_.waitList_.append(this);
+		return;
+	}
+
+	try {
+		daemon_.engine_.query(this, query_);
+	}
+	catch (Core::Exception* e) {
+		QJsonObject reply;
+		reply["error"] = e->reason();
+		delete e;
+		finish(reply);
+	}
+}
+
+/**
+ * Rebuilds the database.
+ * The request fails if another build is in progress.
+ */
+void DaemonRequest::build()
+{
+	build_ = true;
+
+	QJsonObject reply;
+	if (daemon_.building_ != NULL) {
+		reply["error"] = tr("A build is already in progress");
+		finish(reply);
+		return;
+	}
+
+	daemon_.building_ = this;
+	try {
+		daemon_.engine_.build(this);
+	}
+	catch (Core::Exception* e) {
+		reply["error"] = e->reason();
+		delete e;
+		finish(reply);
+	}
+}
+
+/**
+ * Stops the request, following the disconnection of its client.
+ */
+void DaemonRequest::detach()
+{
+	client_ = NULL;
+	stop();
+}
+
+/**
+ * Stops the request.
+ * A query that is waiting for the engine's indices is cancelled immediately.
+ */
+void DaemonRequest::stop()
+{
+	if (!waiting_) {
+		Core::Engine::Connection::stop();
+		return;
+	}
+
+	waiting_ = false;
+	daemon_.waitList_.removeAll(this);
+	onAborted();
+}
+
+/**
+ * Sends results to the client as they arrive.
+ * @param  locList  A list of results
+ */
+void DaemonRequest::onDataReady(const Core::LocationList& locList)
+{
+	if (build_)
+		return;
+
+	locList_ += locList;
+	sendResults(locList);
+}
+
+/**
+ * Completes the request.
+ * Query results are stored in the cache. A build invalidates the cache.
+ */
+void DaemonRequest::onFinished()
+{
+	if (build_)
+		daemon_.cache_.clear();
+	else if (Core::QueryCache::isCacheable(query_))
+		daemon_.cache_.insert(query_, locList_);
+
+	QJsonObject reply;
+	reply["done"] = true;
+	reply["count"] = locList_.size();
+	reply["ms"] = static_cast<double>(timer_.elapsed());
+	finish(reply);
+}
+
+/**
+ * Completes a request that was stopped or failed.
+ */
+void DaemonRequest::onAborted()
+{
+	QJsonObject reply;
+	reply["cancelled"] = true;
+	finish(reply);
+}
+
+/**
+ * Completes a query that ran past its deadline.
+ * Partial results were already sent, but are not cached.
+ */
+void DaemonRequest::onTimedOut()
+{
+	QJsonObject reply;
+	reply["timedOut"] = true;
+	reply["count"] = locList_.size();
+	reply["ms"] = static_cast<double>(timer_.elapsed());
+	finish(reply);
+}
+
+/**
+ * Progress is not reported to clients.
+ */
+void DaemonRequest::onProgress(const QString& text, uint cur, uint total)
+{
+	(void)text;
+	(void)cur;
+	(void)total;
+}
+
+/**
+ * Sends a batch of results to the client.
+ * @param  locList  The results to send
+ */
+void DaemonRequest::sendResults(const Core::LocationList& locList)
+{
+	if (!client_ || locList.isEmpty())
+		return;
+
+	QJsonArray results;
+	Core::LocationList::ConstIterator itr;
+	for (itr = locList.begin(); itr != locList.end(); ++itr) {
+		QJsonObject loc;
+
+		QList<Core::Location::Fields>::ConstIterator field;
+		for (field = fields_.begin(); field != fields_.end(); ++field) {
+			switch (*field) {
+			case Core::Location::File:
+				loc["file"] = (*itr).file_;
+				break;
+
+			case Core::Location::Line:
+				loc["line"] = static_cast<int>((*itr).line_);
+				break;
+
+			case Core::Location::Column:
+				loc["column"] = static_cast<int>((*itr).column_);
+				break;
+
+			case Core::Location::TagName:
+				loc["symbol"] = (*itr).tag_.name_;
+				break;
+
+			case Core::Location::TagType:
+				loc["type"] = Core::Strings::tagName((*itr).tag_.type_);
+				break;
+
+			case Core::Location::Scope:
+				loc["scope"] = (*itr).tag_.scope_;
+				break;
+
+			case Core::Location::Text:
+				loc["text"] = (*itr).text_;
+				break;
+
+			case Core::Location::Project:
+				loc["project"] = (*itr).project_;
+				break;
+
+			case Core::Location::Count:
+				loc["count"] = static_cast<int>((*itr).count_);
+				break;
+			}
+		}
+
+		results.append(loc);
+	}
+
+	QJsonObject reply;
+	reply["id"] = id_;
+	reply["results"] = results;
+	client_->send(reply);
+}
+
+/**
+ * Sends the final reply for the request, and schedules the object for
+ * deletion.
+ * Deletion is deferred, as the engine may still reference the connection
+ * when the termination callback returns.
+ * @param  reply  The final reply
+ */
+void DaemonRequest::finish(const QJsonObject& reply)
+{
+	if (daemon_.building_ == this)
+		daemon_.building_ = NULL;
+
+	if (client_) {
+		QJsonObject taggedReply(reply);
+		taggedReply["id"] = id_;
+		client_->send(taggedReply);
+		client_->requestDone(DaemonClient::requestKey(id_));
+	}
+
+	deleteLater();
+}
+
+/**
+ * Class constructor.
+ * @param  daemon  The owning daemon
+ * @param  socket  The connection to the client
+ */
+DaemonClient::DaemonClient(QueryDaemon& daemon, QLocalSocket* socket)
+	: QObject(&daemon), daemon_(daemon), socket_(socket)
+{
+	socket_->setParent(this);
+	connect(socket_, SIGNAL(readyRead()), this, SLOT(readRequests()));
+	connect(socket_, SIGNAL(disconnected()), this, SLOT(disconnected()));
+}
+
+/**
+ * Class destructor.
+ */
+DaemonClient::~DaemonClient()
+{
+}
+
+/**
+ * Writes a reply to the client.
+ * Replies carry the ID of the request they belong to.
+ * @param  reply  The reply to send
+ */
+void DaemonClient::send(const QJsonObject& reply)
+{
+	socket_->write(QJsonDocument(reply).toJson(QJsonDocument::Compact));
+	socket_->write("\n");
+	socket_->flush();
+}
+
+/**
+ * Called by a request object when it completes.
+ * @param  key  The request's key
+ */
+void DaemonClient::requestDone(const QString& key)
+{
+	requests_.remove(key);
+}
+
+/**
+ * Handles a single request line.
+ * @param  line  The JSON text of the request
+ */
+void DaemonClient::handle(const QByteArray& line)
+{
+	QJsonParseError parseError;
+	QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+	if (!doc.isObject()) {
+		error(QJsonValue(), parseError.errorString());
+		return;
+	}
+
+	QJsonObject request = doc.object();
+	QJsonValue id = request["id"];
+	QString key = requestKey(id);
+
+	if (request["shutdown"].toBool()) {
+		qApp->quit();
+		return;
+	}
+
+	if (request["cancel"].toBool()) {
+		DaemonRequest* req = requests_.value(key);
+		if (req)
+			req->stop();
+		return;
+	}
+
+	if (requests_.contains(key)) {
+		error(id, tr("Request ID is already in use"));
+		return;
+	}
+
+	DaemonRequest* req = new DaemonRequest(daemon_, this, id);
+	requests_[key] = req;
+
+	if (request["build"].toBool()) {
+		req->build();
+		return;
+	}
+
+	// Parse the query.
+	Core::Query::Type type;
+	QString pattern;
+	if (!BatchQuery::parseQuery(request["query"].toString(), type, pattern)) {
+		requests_.remove(key);
+		delete req;
+		error(id, tr("Invalid query"));
+		return;
+	}
+
+	uint flags = 0;
+	if (request["ignoreCase"].toBool())
+		flags |= Core::Query::IgnoreCase;
+	if (request["regexp"].toBool())
+		flags |= Core::Query::RegExp;
+
+	Core::Query query(type, pattern, flags);
+	query.timeout_ = request["timeout"].toInt();
+	QJsonArray scope = request["scope"].toArray();
+	QJsonArray::ConstIterator itr;
+	for (itr = scope.begin(); itr != scope.end(); ++itr)
+		query.pathPrefixes_.append((*itr).toString());
+
+	req->query(query);
+}
+
+/**
+ * Sends an error message for a request that could not be started.
+ * @param  id   The ID of the request
+ * @param  msg  The error message
+ */
+void DaemonClient::error(const QJsonValue& id, const QString& msg)
+{
+	QJsonObject reply;
+	reply["id"] = id;
+	reply["error"] = msg;
+	send(reply);
+}
+
+/**
+ * Converts a request ID to a key for the table of active requests.
+ * @param  id  The ID of the request
+ * @return The matching key
+ */
+QString DaemonClient::requestKey(const QJsonValue& id)
+{
+	return id.toVariant().toString();
+}
+
+/**
+ * Handles all complete request lines received from the client.
+ */
+void DaemonClient::readRequests()
+{
+	while (socket_->canReadLine()) {
+		QByteArray line = socket_->readLine().trimmed();
+		if (!line.isEmpty())
+			handle(line);
+	}
+}
+
+/**
+ * Stops all active requests once the client goes away.
+ */
+void DaemonClient::disconnected()
+{
+	QHash<QString, DaemonRequest*>::Iterator itr;
+	for (itr = requests_.begin(); itr != requests_.end(); ++itr)
+		(*itr)->detach();
+
+	requests_.clear();
+	deleteLater();
+}
+
+} // namespace App
+
+} // namespace KScope
@@ -0,0 +1,252 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __APP_QUERYDAEMON_H__
+#define __APP_QUERYDAEMON_H__
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <core/codebase.h>
+#include <core/engine.h>
+#include <core/querycache.h>
+
+namespace KScope
+{
+
+namespace App
+{
+
+class DaemonClient;
+class DaemonRequest;
+
+/**
+ * Serves queries to other processes over a local socket.
+ * The daemon keeps a single project open, so that the engine's indices and
+ * the cache of recent results are shared by all clients. Each client sends
+ * newline-delimited JSON requests:
+ * - {"id": ID, "query": "TYPE:PATTERN", "ignoreCase": BOOL, "regexp": BOOL,
+ *   "scope": [DIR, ...], "timeout": MS} runs a query;
+ * - {"id": ID, "cancel": true} stops the request with the given ID;
+ * - {"id": ID, "build": true} rebuilds the database;
+ * - {"id": ID, "shutdown": true} terminates the daemon.
+ * Responses are also newline-delimited JSON objects, tagged with the ID of
+ * the request. Query results are sent in batches as they arrive
+ * ({"id": ID, "results": [...]}), followed by a final
+ * {"id": ID, "done": true, "count": N, "ms": T}, {"id": ID, "cancelled": true},
+ * {"id": ID, "timedOut": true, "count": N, "ms": T} or
+ * {"id": ID, "error": MESSAGE} object.
+ * Queries that depend on indices the engine derives from the database in the
+ * background (e.g., right after the database is built) are held until the
+ * indices are ready.
+ * Only one build runs at a time: a build request made while another one is
+ * in progress is rejected with an error. Cached results are discarded when
+ * the code base changes, and when the files in the database directory change
+ * (e.g., the database was rebuilt by another process).
+ * @author Elad Lahav
+ */
+class QueryDaemon : public QObject
+{
+	Q_OBJECT
+
+public:
+	QueryDaemon(Core::Engine& engine, Core::Codebase& codebase,
+	            const QString& dbPath, QObject* parent = NULL);
+	~QueryDaemon();
+
+	bool listen(const QString& name);
+
+	/**
+	 * @return A description of the last error
+	 */
+	QString errorString() const { return server_.errorString(); }
+
+private:
+	/**
+	 * The engine used to answer queries.
+	 */
+	Core::Engine& engine_;
+
+	/**
+	 * Accepts client connections.
+	 */
+	QLocalServer server_;
+
+	/**
+	 * Results of recent queries, shared by all clients.
+	 */
+	Core::QueryCache cache_;
+
+	/**
+	 * Queries waiting for the engine's indices.
+	 */
+	QList<DaemonRequest*> waitList_;
+
+	/**
+	 * The running build request, NULL if none.
+	 */
+	DaemonRequest* building_;
+
+	/**
+	 * The directory holding the database files.
+	 */
+	QString dbPath_;
+
+	/**
+	 * The last modification time of the database files when the cache was
+	 * last validated.
+	 */
+	QDateTime dbTime_;
+
+	void checkDatabase();
+	QDateTime databaseTime() const;
+
+	friend class DaemonClient;
+	friend class DaemonRequest;
+
+private slots:
+	void newConnection();
+	void clearCache();
+	void runWaiting();
+};
+
+/**
+ * A single operation requested by a client.
+ * @author Elad Lahav
+ */
+class DaemonRequest : public QObject, public Core::Engine::Connection
+{
+public:
+	DaemonRequest(QueryDaemon& daemon, DaemonClient* client,
+	              const QJsonValue& id);
+	~DaemonRequest();
+
+	void query(const Core::Query& query);
+	void build();
+	void detach();
+	void run();
+	void stop();
+
+	// Core::Engine::Connection implementation.
+	void onDataReady(const Core::LocationList& locList);
+	void onFinished();
+	void onAborted();
+	void onTimedOut();
+	void onProgress(const QString& text, uint cur, uint total);
+
+private:
+	/**
+	 * The owning daemon.
+	 */
+	QueryDaemon& daemon_;
+
+	/**
+	 * The client that sent the request (NULL if disconnected).
+	 */
+	DaemonClient* client_;
+
+	/**
+	 * The client-assigned request ID.
+	 */
+	QJsonValue id_;
+
+	/**
+	 * The query, if this is a query request.
+	 */
+	Core::Query query_;
+
+	/**
+	 * Whether this is a build request.
+	 */
+	bool build_;
+
+	/**
+	 * Whether the query is waiting for the engine's indices.
+	 */
+	bool waiting_;
+
+	/**
+	 * Collects results for the cache.
+	 */
+	Core::LocationList locList_;
+
+	/**
+	 * The fields reported for the query.
+	 */
+	QList<Core::Location::Fields> fields_;
+
+	/**
+	 * Measures the time taken to answer the request.
+	 */
+	QElapsedTimer timer_;
+
+	void sendResults(const Core::LocationList& locList);
+	void finish(const QJsonObject& reply);
+};
+
+/**
+ * A connection to a single client process.
+ * @author Elad Lahav
+ */
+class DaemonClient : public QObject
+{
+	Q_OBJECT
+
+public:
+	DaemonClient(QueryDaemon& daemon, QLocalSocket* socket);
+	~DaemonClient();
+
+	void send(const QJsonObject& reply);
+	void requestDone(const QString& key);
+
+	static QString requestKey(const QJsonValue& id);
+
+private:
+	/**
+	 * The owning daemon.
+	 */
+	QueryDaemon& daemon_;
+
+	/**
+	 * The connection to the client.
+	 */
+	QLocalSocket* socket_;
+
+	/**
+	 * Active requests, indexed by their IDs.
+	 */
+	QHash<QString, DaemonRequest*> requests_;
+
+	void handle(const QByteArray& line);
+	void error(const QJsonValue& id, const QString& msg);
+
+private slots:
+	void readRequests();
+	void disconnected();
+};
+
+} // namespace App
+
+} // namespace KScope
+
+#endif // __APP_QUERYDAEMON_H__
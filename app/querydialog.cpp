@@ -21,9 +21,11 @@
 #include <QLineEdit>
 #include <QCompleter>
 #include <QMessageBox>
+#include <QAbstractItemView>
 #include <QDebug>
 #include "querydialog.h"
 #include "appstrings.h"
+#include "projectmanager.h"
 
 namespace KScope
 {
@@ -40,10 +42,17 @@ QueryDialog::QueryDialog(QWidget* parent)
 {
 	setupUi(this);
 
-	QCompleter *cmplter;
-	cmplter = patternCombo_->lineEdit()->completer();
-	if (cmplter)
-	    cmplter->setCaseSensitivity(Qt::CaseSensitive);
+	// Replace the history completer with one that also suggests symbols from
+	// the project's engine.
+	completionModel_ = new QStringListModel(this);
+	symbolCompleter_ = new QCompleter(completionModel_, this);
+	symbolCompleter_->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+	symbolCompleter_->setCaseSensitivity(Qt::CaseSensitive);
+	symbolCompleter_->setMaxVisibleItems(15);
+	patternCombo_->setCompleter(symbolCompleter_);
+
+	connect(patternCombo_->lineEdit(), SIGNAL(textEdited(const QString&)),
+	        this, SLOT(updateCompletions(const QString&)));
 }
 
 /**
@@ -72,7 +81,8 @@ int QueryDialog::exec(Core::Query::Type defType, const TypeList& typeList)
 		typeList << Core::Query::Text << Core::Query::References
 		         << Core::Query::Definition << Core::Query::CalledFunctions
 		         << Core::Query::CallingFunctions << Core::Query::FindFile
-		         << Core::Query::IncludingFiles;
+		         << Core::Query::IncludingFiles
+		         << Core::Query::IncludeClosure;
 
 		foreach (Core::Query::Type type, typeList)
 			typeCombo_->addItem(Strings::toString(type), type);
@@ -117,6 +127,14 @@ Core::Query::Type QueryDialog::type()
 	return static_cast<Core::Query::Type>(data.toUInt());
 }
 
+/**
+ * @return The directories to which the query should be restricted
+ */
+QStringList QueryDialog::pathPrefixes()
+{
+	return scopeEdit_->text().split(' ', QString::SkipEmptyParts);
+}
+
 /**
  * Deletes all items in the pattern combo-box.
  */
@@ -160,6 +178,51 @@ void QueryDialog::accept()
 	QDialog::accept();
 }
 
+/**
+ * Called whenever the user edits the pattern.
+ * Suggests matching entries from the history list, followed by symbol names,
+ * if the selected query type looks for a symbol.
+ * @param  text  The current pattern
+ */
+void QueryDialog::updateCompletions(const QString& text)
+{
+	QStringList list;
+
+	if (!text.isEmpty()) {
+		// Add history entries starting with the text.
+		for (int i = 0; i < patternCombo_->count(); i++) {
+			QString item = patternCombo_->itemText(i);
+			if (item.startsWith(text) && (item != text))
+				list << item;
+		}
+
+		// Add symbol names.
+		switch (type()) {
+		case Core::Query::Definition:
+		case Core::Query::References:
+		case Core::Query::CalledFunctions:
+		case Core::Query::CallingFunctions:
+			if (ProjectManager::hasProject()) {
+				foreach (QString name,
+				         ProjectManager::engine().complete(text, 50)) {
+					if (!list.contains(name))
+						list << name;
+				}
+			}
+			break;
+
+		default:
+			;
+		}
+	}
+
+	completionModel_->setStringList(list);
+	if (list.isEmpty())
+		symbolCompleter_->popup()->hide();
+	else
+		symbolCompleter_->complete();
+}
+
 } // namespace App
 
 } // namespace KScope
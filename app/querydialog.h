@@ -22,6 +22,8 @@
 #define __APP_QUERYDIALOG_H__
 
 #include <QDialog>
+#include <QCompleter>
+#include <QStringListModel>
 #include <core/engine.h>
 #include "ui_querydialog.h"
 
@@ -49,12 +51,27 @@ public:
 	QString pattern();
 	void setPattern(const QString&);
 	Core::Query::Type type();
+	QStringList pathPrefixes();
 	void clear();
 
 	bool caseless;
 	
 public slots:
 	void accept();
+
+private:
+	/**
+	 * Suggests symbol names as the pattern is typed.
+	 */
+	QCompleter* symbolCompleter_;
+
+	/**
+	 * Holds the current suggestions.
+	 */
+	QStringListModel* completionModel_;
+
+private slots:
+	void updateCompletions(const QString&);
 };
 
 } // namespace App
@@ -72,8 +72,46 @@ void QueryResultDock::query(const Core::Query& query, bool tree)
 	}
 }
 
+/**
+ * Combines the results of two queries, and displays them in a query view.
+ * @param  left   The first query
+ * @param  right  The second query
+ * @param  op     The set operation to apply to the results
+ * @param  key    Determines how results are compared
+ */
+void QueryResultDock::compose(const Core::Query& left,
+                              const Core::Query& right,
+                              Core::QueryComposer::Operation op,
+                              Core::QueryComposer::Key key)
+{
+	QString title = QString("(%1) %2 (%3)").arg(Strings::toString(left))
+	                                       .arg(Strings::toString(op))
+	                                       .arg(Strings::toString(right));
+	QueryView* view = addView(title, Core::QueryView::List);
+	view->compose(left, right, op, key);
+}
+
+/**
+ * Runs a query on both the current database and a snapshot, and displays
+ * the results found by only one of them.
+ * @param  query     The query to run
+ * @param  snapshot  The engine of the snapshot
+ * @param  name      The name of the snapshot
+ */
+void QueryResultDock::compare(const Core::Query& query,
+                              const Core::Engine& snapshot,
+                              const QString& name)
+{
+	QString title = QString("%1 (%2)").arg(Strings::toString(query))
+	                                  .arg(name);
+	QueryView* view = addView(title, Core::QueryView::List);
+	view->compare(query, snapshot, name, tr("Current"));
+}
+
 /**
  * Stores the open query views in a session object.
+ * Views of composed or compared results are not stored, as they cannot be
+ * restored from a single query.
  * @param  session The object to use for storing the views
  */
 void QueryResultDock::saveSession(Session& session)
@@ -81,7 +119,8 @@ void QueryResultDock::saveSession(Session& session)
 	QList<QWidget*> widgetList = tabWidget()->widgets();
 	foreach (QWidget* widget, widgetList) {
 		QueryView* view = static_cast<QueryView*>(widget);
-		session.addQueryView(view);
+		if (view->hasQuery())
+			session.addQueryView(view);
 	}
 }
 
@@ -45,6 +45,9 @@ public:
 	~QueryResultDock();
 
 	void query(const Core::Query&, bool);
+	void compose(const Core::Query&, const Core::Query&,
+	             Core::QueryComposer::Operation, Core::QueryComposer::Key);
+	void compare(const Core::Query&, const Core::Engine&, const QString&);
 	void saveSession(Session&);
 	void loadSession(Session&);
 
@@ -0,0 +1,283 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QSet>
+#include <core/exception.h>
+#include "renamedialog.h"
+#include "projectmanager.h"
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Class constructor.
+ * @param  oldName  The symbol to rename
+ * @param  newName  The new name of the symbol
+ * @param  exclude  Files that must not be changed (e.g., files with unsaved
+ *                  changes in an editor)
+ * @param  parent   Parent widget
+ */
+RenameDialog::RenameDialog(const QString& oldName, const QString& newName,
+                           const QStringList& exclude, QWidget* parent)
+	: QDialog(parent), Core::Engine::Connection(), Ui::RenameDialog(),
+	  state_(Searching), rename_(oldName, newName), exclude_(exclude),
+	  closing_(false), fileCount_(0)
+{
+	setupUi(this);
+
+	applyButton_ = buttonBox_->addButton(tr("&Rename"),
+	                                     QDialogButtonBox::AcceptRole);
+	applyButton_->setEnabled(false);
+	connect(buttonBox_, SIGNAL(accepted()), this, SLOT(apply()));
+
+	// Set up the result lists.
+	QList<Core::Location::Fields> fieldList;
+	fieldList << Core::Location::File
+	          << Core::Location::Line
+	          << Core::Location::Text;
+	editsView_->locationModel()->setColumns(fieldList);
+	problemsView_->locationModel()->setColumns(fieldList);
+	connect(editsView_, SIGNAL(locationRequested(const Core::Location&)), this,
+	        SIGNAL(locationRequested(const Core::Location&)));
+	connect(problemsView_, SIGNAL(locationRequested(const Core::Location&)),
+	        this, SIGNAL(locationRequested(const Core::Location&)));
+
+	// Show the progress of the verification and writing stages.
+	connect(&watcher_, SIGNAL(progressRangeChanged(int, int)), progressBar_,
+	        SLOT(setRange(int, int)));
+	connect(&watcher_, SIGNAL(progressValueChanged(int)), progressBar_,
+	        SLOT(setValue(int)));
+	connect(&watcher_, SIGNAL(finished()), this, SLOT(stageFinished()));
+
+	setWindowTitle(tr("Rename '%1' to '%2'").arg(oldName).arg(newName));
+}
+
+/**
+ * Class destructor.
+ */
+RenameDialog::~RenameDialog()
+{
+	watcher_.waitForFinished();
+}
+
+/**
+ * Starts looking for references to the symbol.
+ */
+void RenameDialog::start()
+{
+	statusLabel_->setText(tr("Looking for references to '%1'...")
+	                      .arg(rename_.oldName()));
+	progressBar_->setRange(0, 0);
+
+	try {
+		Core::Query query(Core::Query::References, rename_.oldName());
+		ProjectManager::engine().query(this, query);
+	}
+	catch (Core::Exception* e) {
+		e->showMessage();
+		delete e;
+		statusLabel_->setText(tr("The query failed"));
+		progressBar_->setRange(0, 1);
+	}
+}
+
+/**
+ * Collects the results of the References query.
+ * @param  locList  A list of results
+ */
+void RenameDialog::onDataReady(const Core::LocationList& locList)
+{
+	locList_ += locList;
+}
+
+/**
+ * Starts verifying the results once the query completes.
+ */
+void RenameDialog::onFinished()
+{
+	if (closing_) {
+		QDialog::reject();
+		return;
+	}
+
+	state_ = Verifying;
+	statusLabel_->setText(tr("Checking %1 references...")
+	                      .arg(locList_.size()));
+	watcher_.setFuture(rename_.verify(locList_, exclude_));
+}
+
+/**
+ * Called when the query is stopped or fails.
+ */
+void RenameDialog::onAborted()
+{
+	if (closing_) {
+		QDialog::reject();
+		return;
+	}
+
+	statusLabel_->setText(tr("The query was aborted"));
+	progressBar_->setRange(0, 1);
+}
+
+/**
+ * Shows the progress of the query.
+ * @param  text   A message describing the kind of progress made
+ * @param  cur    The current value
+ * @param  total  The expected final value
+ */
+void RenameDialog::onProgress(const QString& text, uint cur, uint total)
+{
+	(void)text;
+	progressBar_->setRange(0, total);
+	progressBar_->setValue(cur);
+}
+
+/**
+ * Closes the dialogue without making any changes.
+ * A running query is stopped first. Changes that are already being written
+ * cannot be cancelled.
+ */
+void RenameDialog::reject()
+{
+	switch (state_) {
+	case Searching:
+		if (ctrlObject_) {
+			closing_ = true;
+			stop();
+			return;
+		}
+		break;
+
+	case Verifying:
+		watcher_.cancel();
+		watcher_.waitForFinished();
+		break;
+
+	case Applying:
+		return;
+
+	case Done:
+		// Report the files that were changed.
+		accept();
+		return;
+
+	default:
+		;
+	}
+
+	QDialog::reject();
+}
+
+/**
+ * Writes the changes.
+ */
+void RenameDialog::apply()
+{
+	if (state_ != Ready)
+		return;
+
+	state_ = Applying;
+	applyButton_->setEnabled(false);
+	buttonBox_->button(QDialogButtonBox::Cancel)->setEnabled(false);
+	statusLabel_->setText(tr("Renaming '%1' to '%2'...")
+	                      .arg(rename_.oldName()).arg(rename_.newName()));
+	watcher_.setFuture(rename_.apply());
+}
+
+/**
+ * Called when the verification or the writing stage completes.
+ */
+void RenameDialog::stageFinished()
+{
+	switch (state_) {
+	case Verifying:
+		{
+			if (watcher_.isCanceled())
+				return;
+
+			// Show the changes.
+			Core::LocationList edits;
+			rename_.preview(edits);
+			editsView_->locationModel()->add(edits, QModelIndex());
+			editsView_->resizeColumns();
+
+			QSet<QString> files;
+			foreach (const Core::Location& loc, edits)
+				files.insert(loc.file_);
+
+			showProblems();
+
+			state_ = Ready;
+			fileCount_ = files.size();
+			statusLabel_->setText(tr("%1 lines in %2 files will be changed.")
+			                      .arg(edits.size()).arg(files.size()));
+			applyButton_->setEnabled(!edits.isEmpty());
+		}
+		break;
+
+	case Applying:
+		{
+			state_ = Done;
+			buttonBox_->button(QDialogButtonBox::Cancel)->setEnabled(true);
+
+			showProblems();
+			if (rename_.changedFiles().size() == fileCount_) {
+				accept();
+				return;
+			}
+
+			// Some files could not be written. Leave the dialogue open, so
+			// that the user can see which.
+			tabWidget_->setCurrentIndex(1);
+			statusLabel_->setText(tr("%1 files were changed. Some of the "
+			                         "changes could not be made.")
+			                      .arg(rename_.changedFiles().size()));
+			buttonBox_->button(QDialogButtonBox::Cancel)
+				->setText(tr("&Close"));
+		}
+		break;
+
+	default:
+		;
+	}
+}
+
+/**
+ * Fills the list of references that cannot be changed.
+ */
+void RenameDialog::showProblems()
+{
+	Core::LocationList problems;
+	rename_.problems(problems);
+
+	problemsView_->locationModel()->clear(QModelIndex());
+	problemsView_->locationModel()->add(problems, QModelIndex());
+	problemsView_->resizeColumns();
+
+	tabWidget_->setTabText(1, tr("Problems (%1)").arg(problems.size()));
+}
+
+} // namespace App
+
+} // namespace KScope
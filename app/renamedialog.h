@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __APP_RENAMEDIALOG_H__
+#define __APP_RENAMEDIALOG_H__
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QPushButton>
+#include <core/engine.h>
+#include <core/rename.h>
+#include "ui_renamedialog.h"
+
+namespace KScope
+{
+
+namespace App
+{
+
+/**
+ * Renames a symbol across the code base.
+ * The dialogue runs a References query for the old name, verifies the
+ * results against the files, and shows the resulting changes, along with any
+ * references that cannot be changed. The changes are only written once the
+ * user confirms them.
+ * @author Elad Lahav
+ */
+class RenameDialog : public QDialog, public Core::Engine::Connection,
+                     private Ui::RenameDialog
+{
+	Q_OBJECT
+
+public:
+	RenameDialog(const QString&, const QString&, const QStringList&,
+	             QWidget* parent = 0);
+	~RenameDialog();
+
+	void start();
+
+	/**
+	 * @return The files changed by the operation
+	 */
+	QStringList changedFiles() const { return rename_.changedFiles(); }
+
+	// Engine::Connection implementation.
+	virtual void onDataReady(const Core::LocationList&);
+	virtual void onFinished();
+	virtual void onAborted();
+	virtual void onProgress(const QString&, uint, uint);
+
+public slots:
+	void reject();
+
+signals:
+	/**
+	 * Emitted when a location in one of the lists is selected.
+	 * @param  loc  The location descriptor
+	 */
+	void locationRequested(const Core::Location& loc);
+
+private:
+	/**
+	 * The stages of the operation.
+	 */
+	enum State {
+		/** Waiting for References results. */
+		Searching,
+		/** Checking the results against the files. */
+		Verifying,
+		/** Waiting for the user to confirm the changes. */
+		Ready,
+		/** Writing the changes. */
+		Applying,
+		/** All changes were written. */
+		Done
+	};
+
+	/**
+	 * The current stage.
+	 */
+	State state_;
+
+	/**
+	 * Verifies and applies the changes.
+	 */
+	Core::Rename rename_;
+
+	/**
+	 * Files that must not be changed.
+	 */
+	QStringList exclude_;
+
+	/**
+	 * The results of the References query.
+	 */
+	Core::LocationList locList_;
+
+	/**
+	 * Monitors the progress of the verification and writing stages.
+	 */
+	QFutureWatcher<void> watcher_;
+
+	/**
+	 * Confirms the changes.
+	 */
+	QPushButton* applyButton_;
+
+	/**
+	 * Set when the dialogue is cancelled while the query is running, to close
+	 * it once the query is stopped.
+	 */
+	bool closing_;
+
+	/**
+	 * The number of files to be changed, as determined by the verification
+	 * stage.
+	 */
+	int fileCount_;
+
+	void showProblems();
+
+private slots:
+	void apply();
+	void stageFinished();
+};
+
+} // namespace App
+
+} // namespace KScope
+
+#endif // __APP_RENAMEDIALOG_H__
@@ -101,6 +101,11 @@ public:
 	 */
 	PROPERTY(bool, maxActiveEditor_, maxActiveEditor, setMaxActiveEditor);
 
+	/**
+	 * The directories of projects opened alongside this one.
+	 */
+	PROPERTY(QStringList, workspace_, workspace, setWorkspace);
+
 private:
 	/**
 	 * The path of the configuration directory holding session information.
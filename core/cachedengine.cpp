@@ -0,0 +1,434 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "cachedengine.h"
+#include "exception.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The time to wait before each warm-up query, in milliseconds.
+ * Gives the application (and the user) a chance to issue queries first.
+ */
+static const int WarmDelay = 500;
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+CachedEngine::CachedEngine(QObject* parent) : Engine(parent), engine_(NULL),
+	generation_(0), active_(0), warming_(false)
+{
+	warmTimer_.setSingleShot(true);
+	warmTimer_.setInterval(WarmDelay);
+	connect(&warmTimer_, SIGNAL(timeout()), this, SLOT(warmNext()));
+}
+
+/**
+ * Class destructor.
+ */
+CachedEngine::~CachedEngine()
+{
+}
+
+/**
+ * Sets the engine that handles queries.
+ * Cached results, as well as pending warm-up queries, are discarded.
+ * @param  engine  The target engine, or NULL to detach from the current one
+ */
+void CachedEngine::setEngine(Engine* engine)
+{
+	warmList_.clear();
+	warmTimer_.stop();
+	clearCache();
+
+	if (engine_)
+		disconnect(engine_, SIGNAL(indicesChanged()), this, NULL);
+
+	engine_ = engine;
+	if (engine_) {
+		// Results of queries answered from the indices (e.g., the include
+		// graph and the metrics) change when these are replaced, which may
+		// happen well after a build completes.
+		connect(engine_, SIGNAL(indicesChanged()), this, SLOT(clearCache()));
+		connect(engine_, SIGNAL(indicesChanged()), this,
+		        SIGNAL(indicesChanged()));
+	}
+}
+
+/**
+ * Runs the most-used queries in the background.
+ * @param  count  The maximal number of queries to run
+ */
+void CachedEngine::warm(int count)
+{
+	warmList_ = usage_.top(count);
+	if (!warmList_.isEmpty())
+		warmTimer_.start();
+}
+
+/**
+ * The target engine is opened by its project.
+ * @param  initString  Ignored
+ * @param  cb          Called immediately
+ */
+void CachedEngine::open(const QString& initString, Callback<>* cb)
+{
+	(void)initString;
+	if (cb)
+		cb->call();
+}
+
+/**
+ * @return The status of the target engine
+ */
+Engine::Status CachedEngine::status() const
+{
+	if (!engine_)
+		return Unknown;
+
+	return engine_->status();
+}
+
+/**
+ * @param  type  The requested query type
+ * @return The fields filled by the target engine for the given query type
+ */
+QList<Location::Fields> CachedEngine::queryFields(Query::Type type) const
+{
+	if (!engine_)
+		return QList<Location::Fields>();
+
+	return engine_->queryFields(type);
+}
+
+/**
+ * @param  text        The partial pattern
+ * @param  maxResults  The maximal number of suggestions
+ * @return The suggestions of the target engine
+ */
+QStringList CachedEngine::complete(const QString& text, int maxResults) const
+{
+	if (!engine_)
+		return QStringList();
+
+	return engine_->complete(text, maxResults);
+}
+
+/**
+ * @param  name  The name of the snapshot
+ * @return true if the target engine created the snapshot, false otherwise
+ * @throw  Exception
+ */
+bool CachedEngine::createSnapshot(const QString& name)
+{
+	if (!engine_)
+		return false;
+
+	return engine_->createSnapshot(name);
+}
+
+/**
+ * @return The snapshots of the target engine
+ */
+QStringList CachedEngine::snapshots() const
+{
+	if (!engine_)
+		return QStringList();
+
+	return engine_->snapshots();
+}
+
+/**
+ * @param  name  The name of the snapshot
+ * @return An engine for querying a snapshot of the target engine
+ */
+Engine* CachedEngine::openSnapshot(const QString& name) const
+{
+	if (!engine_)
+		return NULL;
+
+	return engine_->openSnapshot(name);
+}
+
+/**
+ * @param  query  The query to check
+ * @return Whether the target engine can start the query
+ */
+bool CachedEngine::canQuery(const Query& query) const
+{
+	if (!engine_)
+		return true;
+
+	return engine_->canQuery(query);
+}
+
+/**
+ * Answers a query from the cache, or passes it to the target engine.
+ * Cached results are delivered before this method returns. Queries that read
+ * the current contents of files are always passed to the target engine.
+ * @param  conn   Used for communication with the ongoing operation
+ * @param  query  The query to execute
+ * @throw  Exception
+ */
+void CachedEngine::query(Connection* conn, const Query& query) const
+{
+	// The Engine interface declares queries as const, but the cache and the
+	// usage counts are updated by each query.
+	CachedEngine* self = const_cast<CachedEngine*>(this);
+
+	if (!engine_)
+		throw new Exception("No engine is available");
+
+	self->usage_.record(query);
+
+	LocationList locList;
+	if (QueryCache::isCacheable(query) && self->cache_.find(query, locList)) {
+		if (!locList.isEmpty())
+			conn->onDataReady(locList);
+
+		conn->onFinished();
+		return;
+	}
+
+	self->start(conn, query);
+}
+
+/**
+ * Passes a build request to the target engine.
+ * The cache is cleared both when the build starts and when it completes, and
+ * again when the target engine replaces its indices.
+ * @param  conn  Used for communication with the ongoing operation
+ * @throw  Exception
+ */
+void CachedEngine::build(Connection* conn) const
+{
+	CachedEngine* self = const_cast<CachedEngine*>(this);
+
+	if (!engine_)
+		throw new Exception("No engine is available");
+
+	// Warm-up queries would only delay the build.
+	self->warmList_.clear();
+	self->clearCache();
+	self->start(conn, Query());
+}
+
+/**
+ * Discards all cached results.
+ */
+void CachedEngine::clearCache()
+{
+	cache_.clear();
+	generation_++;
+}
+
+/**
+ * Starts an operation on the target engine.
+ * @param  conn   The connection of the original operation, or NULL for a
+ *                warm-up query
+ * @param  query  The query to execute, or an invalid query for a build
+ * @throw  Exception
+ */
+void CachedEngine::start(Connection* conn, const Query& query)
+{
+	Request* req = new Request(this, conn, query);
+	if (conn)
+		active_++;
+	else
+		warming_ = true;
+
+	try {
+		if (query.type_ == Query::Invalid)
+			engine_->build(req);
+		else
+			engine_->query(req, query);
+	}
+	catch (Exception* e) {
+		req->done();
+		finished(req, false);
+		delete req;
+		throw e;
+	}
+}
+
+/**
+ * Called when an operation terminates.
+ * Stores the results of successful queries, and resumes warming up once no
+ * other query is running.
+ * @param  req        The request object of the operation
+ * @param  succeeded  Whether the operation terminated successfully
+ */
+void CachedEngine::finished(Request* req, bool succeeded)
+{
+	if (req->conn_)
+		active_--;
+	else
+		warming_ = false;
+
+	if (succeeded && req->generation_ == generation_) {
+		if (req->query_.type_ == Query::Invalid)
+			clearCache();
+		else if (QueryCache::isCacheable(req->query_))
+			cache_.insert(req->query_, req->locList_);
+	}
+
+	if (!warmList_.isEmpty() && !warming_ && active_ == 0)
+		warmTimer_.start();
+}
+
+/**
+ * Runs the next warm-up query.
+ * Queries already in the cache are skipped. Warming up is abandoned if the
+ * database cannot be queried.
+ */
+void CachedEngine::warmNext()
+{
+	if (warming_ || active_ > 0)
+		return;
+
+	if (!engine_ || engine_->status() == Unknown
+	    || engine_->status() == Build) {
+		warmList_.clear();
+		return;
+	}
+
+	LocationList locList;
+	while (!warmList_.isEmpty()) {
+		Query query = warmList_.takeFirst();
+		if (cache_.find(query, locList))
+			continue;
+
+		try {
+			start(NULL, query);
+			return;
+		}
+		catch (Exception* e) {
+			delete e;
+		}
+	}
+}
+
+/**
+ * Struct constructor.
+ * @param  owner  The owning engine
+ * @param  conn   The connection of the original operation (NULL for a warm-up
+ *                query)
+ * @param  query  The query (invalid for a build)
+ */
+CachedEngine::Request::Request(CachedEngine* owner, Connection* conn,
+                               const Query& query)
+	: QObject(), Connection(), owner_(owner), conn_(conn), query_(query),
+	  generation_(owner->generation_)
+{
+	if (conn_)
+		conn_->setCtrlObject(this);
+}
+
+/**
+ * Collects and forwards results.
+ * @param  locList  A list of results
+ */
+void CachedEngine::Request::onDataReady(const LocationList& locList)
+{
+	if (query_.type_ != Query::Invalid)
+		locList_ += locList;
+
+	if (conn_)
+		conn_->onDataReady(locList);
+}
+
+/**
+ * Called when the operation terminates successfully.
+ */
+void CachedEngine::Request::onFinished()
+{
+	owner_->finished(this, true);
+	done();
+	if (conn_)
+		conn_->onFinished();
+
+	deleteLater();
+}
+
+/**
+ * Called when the operation terminates abnormally.
+ */
+void CachedEngine::Request::onAborted()
+{
+	owner_->finished(this, false);
+	done();
+	if (conn_)
+		conn_->onAborted();
+
+	deleteLater();
+}
+
+/**
+ * Called when the operation is stopped by a time limit.
+ * Partial results are not cached.
+ */
+void CachedEngine::Request::onTimedOut()
+{
+	owner_->finished(this, false);
+	done();
+	if (conn_)
+		conn_->onTimedOut();
+
+	deleteLater();
+}
+
+/**
+ * Forwards progress information.
+ * @param  text   A message describing the kind of progress made
+ * @param  cur    The current value
+ * @param  total  The expected final value
+ */
+void CachedEngine::Request::onProgress(const QString& text, uint cur,
+                                       uint total)
+{
+	if (conn_)
+		conn_->onProgress(text, cur, total);
+}
+
+/**
+ * Stops the operation on behalf of the original connection.
+ */
+void CachedEngine::Request::stop()
+{
+	Connection::stop();
+}
+
+/**
+ * Detaches from the original connection.
+ */
+void CachedEngine::Request::done()
+{
+	if (conn_)
+		conn_->setCtrlObject(NULL);
+}
+
+} // namespace Core
+
+} // namespace KScope
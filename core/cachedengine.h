@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_CACHEDENGINE_H__
+#define __CORE_CACHEDENGINE_H__
+
+#include <QList>
+#include <QTimer>
+#include "engine.h"
+#include "querycache.h"
+#include "queryusage.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * An engine that keeps the results of recent queries.
+ * Queries are passed to a target engine, unless their results are found in
+ * the cache. The engine also counts how often each query is run, and can
+ * repeat the most-used ones in the background (e.g., right after a project
+ * is opened), so that the first look-ups of a session are answered from the
+ * cache, and the database files are already in the page cache for the rest.
+ * Warm-up queries run one at a time, and only while no other query is
+ * running.
+ * The target engine is not owned by this object.
+ * @author Elad Lahav
+ */
+class CachedEngine : public Engine
+{
+	Q_OBJECT
+
+public:
+	CachedEngine(QObject* parent = NULL);
+	~CachedEngine();
+
+	void setEngine(Engine* engine);
+	void warm(int count);
+
+	/**
+	 * @return The target engine
+	 */
+	Engine* engine() const { return engine_; }
+
+	/**
+	 * @return Usage counts for the queries run through this engine
+	 */
+	QueryUsage& usage() { return usage_; }
+
+	// Engine implementation.
+	void open(const QString& initString, Callback<>* cb);
+	Status status() const;
+	QList<Location::Fields> queryFields(Query::Type type) const;
+	QStringList complete(const QString& text, int maxResults) const;
+	bool createSnapshot(const QString& name);
+	QStringList snapshots() const;
+	Engine* openSnapshot(const QString& name) const;
+	bool canQuery(const Query& query) const;
+
+public slots:
+	void query(Connection* conn, const Query& query) const;
+	void build(Connection* conn) const;
+	void clearCache();
+
+private:
+	/**
+	 * Passes a single operation to the target engine.
+	 * Query results are stored in the cache when the query terminates
+	 * successfully, unless the cache was cleared in the meantime.
+	 * Deletes itself once the operation terminates.
+	 */
+	struct Request : public QObject, public Connection, public Controlled
+	{
+		Request(CachedEngine* owner, Connection* conn, const Query& query);
+
+		void onDataReady(const LocationList& locList);
+		void onFinished();
+		void onAborted();
+		void onTimedOut();
+		void onProgress(const QString& text, uint cur, uint total);
+		void stop();
+
+		void done();
+
+		/**
+		 * The owning engine.
+		 */
+		CachedEngine* owner_;
+
+		/**
+		 * The connection of the original operation, or NULL for a warm-up
+		 * query.
+		 */
+		Connection* conn_;
+
+		/**
+		 * The query (invalid for a build).
+		 */
+		Query query_;
+
+		/**
+		 * The results received so far.
+		 */
+		LocationList locList_;
+
+		/**
+		 * The cache generation at the time the operation started.
+		 */
+		uint generation_;
+	};
+
+	/**
+	 * The engine that handles queries.
+	 */
+	Engine* engine_;
+
+	/**
+	 * Recent results.
+	 */
+	QueryCache cache_;
+
+	/**
+	 * Usage counts.
+	 */
+	QueryUsage usage_;
+
+	/**
+	 * Incremented whenever the cache is cleared, so that results of queries
+	 * started before that are not stored.
+	 */
+	uint generation_;
+
+	/**
+	 * The number of queries currently running on behalf of callers.
+	 */
+	int active_;
+
+	/**
+	 * Warm-up queries that were not yet run.
+	 */
+	QList<Query> warmList_;
+
+	/**
+	 * Whether a warm-up query is currently running.
+	 */
+	bool warming_;
+
+	/**
+	 * Delays warm-up queries.
+	 */
+	QTimer warmTimer_;
+
+	void start(Connection* conn, const Query& query);
+	void finished(Request* req, bool succeeded);
+
+private slots:
+	void warmNext();
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_CACHEDENGINE_H__
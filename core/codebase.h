@@ -22,6 +22,7 @@
 #define __CORE_CODEBASE_H__
 
 #include <QStringList>
+#include <QSet>
 #include "globals.h"
 
 namespace KScope
@@ -39,6 +40,9 @@ namespace Core
  * a cscope.files file that is separate from the corss-reference database.
  * This class adds flexibility by allowing separate management of the set of
  * source files and their index.
+ * Small changes to the set of files are made with updateFiles(), which
+ * reports exactly which files were added and removed, so that listeners can
+ * avoid re-reading the entire set.
  * @author Elad Lahav
  */
 class Codebase : public QObject
@@ -56,9 +60,52 @@ public:
 	virtual bool canModify() = 0;
 	virtual bool needFiles() { return false; }
 
+public slots:
+	/**
+	 * Adds files to, and removes files from, the code base.
+	 * The default implementation replaces the entire list, which emits
+	 * modified(). Implementations that can do better should emit
+	 * filesChanged() instead.
+	 * @param  added    Files to add
+	 * @param  removed  Files to remove
+	 */
+	virtual void updateFiles(const QStringList& added,
+	                         const QStringList& removed) {
+		ListFilesCallback cb;
+		getFiles(cb);
+
+		QSet<QString> removedSet = removed.toSet();
+		QStringList fileList;
+		foreach (const QString& path, cb.fileList_) {
+			if (!removedSet.contains(path))
+				fileList.append(path);
+		}
+
+		setFiles(fileList + added);
+	}
+
 signals:
 	void loaded();
 	void modified();
+
+	/**
+	 * Emitted by updateFiles() implementations that change the list in
+	 * place.
+	 * @param  added    Files added to the code base
+	 * @param  removed  Files removed from the code base
+	 */
+	void filesChanged(const QStringList& added, const QStringList& removed);
+
+private:
+	/**
+	 * Collects the files of the code base.
+	 */
+	struct ListFilesCallback : public Callback<const QString&>
+	{
+		void call(const QString& path) { fileList_.append(path); }
+
+		QStringList fileList_;
+	};
 };
 
 }
@@ -20,6 +20,7 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QSet>
 #include "codebasemodel.h"
 
 namespace KScope
@@ -59,6 +60,30 @@ void CodebaseModel::addFiles(const QStringList& fileList)
         //reset();
 }
 
+/**
+ * Removes files from the model.
+ * @param  fileList  The files to remove
+ */
+void CodebaseModel::removeFiles(const QStringList& fileList)
+{
+	if (fileList.isEmpty())
+		return;
+
+	QSet<QString> removeSet = fileList.toSet();
+	QStringList keepList;
+	getFiles(keepList);
+
+	// Rebuild the tree from the remaining files, which drops directories
+	// that become empty.
+	beginResetModel();
+	root_.clear();
+	foreach (const QString& path, keepList) {
+		if (!removeSet.contains(path))
+			addFile(path);
+	}
+	endResetModel();
+}
+
 /**
  * Converts the model's tree-structured data into a list of file paths.
  * @param  fileList  The list object to fill
@@ -44,6 +44,7 @@ public:
 	~CodebaseModel();
 
 	void addFiles(const QStringList&);
+	void removeFiles(const QStringList&);
 	void getFiles(QStringList&) const;
 
 	virtual QModelIndex index(int row, int column,
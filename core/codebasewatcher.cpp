@@ -0,0 +1,504 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QDebug>
+#include <algorithm>
+#include "codebasewatcher.h"
+#include "dirsnapshot.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+namespace KScope
+{
+
+namespace Core
+{
+
+#ifdef Q_OS_LINUX
+/**
+ * The events of interest in watched directories.
+ * Changes to the contents of files are not reported, as they do not affect
+ * the membership of files in the code base.
+ */
+static const quint32 WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                 | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF
+                                 | IN_ONLYDIR;
+#endif
+
+/**
+ * Adds the files of a code base to the watcher.
+ */
+struct AddFileCallback : public Callback<const QString&>
+{
+	AddFileCallback(CodebaseWatcher* watcher) : watcher_(watcher) {}
+
+	void call(const QString& path) { watcher_->addFile(path); }
+
+	CodebaseWatcher* watcher_;
+};
+
+/**
+ * Orders directories by decreasing number of files.
+ */
+static bool moreFiles(const QPair<int, QString>& first,
+                      const QPair<int, QString>& second)
+{
+	return first.first > second.first;
+}
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+CodebaseWatcher::CodebaseWatcher(QObject* parent)
+	: QObject(parent), codebase_(NULL), fd_(-1), notifier_(NULL),
+	  watchCount_(0), maxWatches_(0)
+{
+	timer_.setSingleShot(true);
+	timer_.setInterval(BatchDelay);
+	connect(&timer_, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+/**
+ * Class destructor.
+ */
+CodebaseWatcher::~CodebaseWatcher()
+{
+	stop();
+}
+
+/**
+ * Starts watching the directories of a code base.
+ * The directory snapshot of the scan with which files were last added
+ * provides the filter applied to new files, as well as directories to watch
+ * that do not hold any files of the code base (e.g., a parent holding only
+ * sub-directories). If there is no snapshot, new files are matched by the
+ * extensions of the files already in the code base.
+ * @param  cbase         The code base
+ * @param  snapshotPath  The file holding the directory snapshot
+ * @return true if successful, false if directories cannot be watched
+ */
+bool CodebaseWatcher::start(const Codebase* cbase,
+                            const QString& snapshotPath)
+{
+	stop();
+	codebase_ = cbase;
+	snapshotPath_ = snapshotPath;
+
+	DirSnapshot snapshot;
+	snapshot.load(snapshotPath_);
+	filter_ = FileFilter(snapshot.filter());
+
+#ifdef Q_OS_LINUX
+	fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_ < 0)
+		return false;
+
+	notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+	connect(notifier_, SIGNAL(activated(int)), this, SLOT(readEvents()));
+
+	// Group the files of the code base by directory.
+	AddFileCallback cb(this);
+	codebase_->getFiles(cb);
+
+	// Add the scanned directories that hold no files.
+	QStringList scannedDirs = snapshot.dirs();
+	foreach (const QString& dirPath, scannedDirs) {
+		if (!dirMap_.contains(dirPath))
+			dirMap_.insert(dirPath, Dir());
+	}
+
+	// Create a filter from the extensions of the files.
+	if (filter_.isEmpty()) {
+		QSet<QString> extSet;
+		QHash<QString, Dir>::ConstIterator dirItr;
+		for (dirItr = dirMap_.begin(); dirItr != dirMap_.end(); ++dirItr) {
+			foreach (const QString& name, (*dirItr).files_) {
+				int dot = name.lastIndexOf('.');
+				if (dot > 0)
+					extSet.insert("*" + name.mid(dot));
+			}
+		}
+
+		filter_ = FileFilter(QStringList(extSet.toList()).join(";"));
+	}
+
+	// Watch the directories holding the most files first, in case the limit
+	// is reached.
+	QList< QPair<int, QString> > dirList;
+	QHash<QString, Dir>::ConstIterator itr;
+	for (itr = dirMap_.begin(); itr != dirMap_.end(); ++itr)
+		dirList.append(qMakePair((*itr).files_.size(), itr.key()));
+
+	std::sort(dirList.begin(), dirList.end(), moreFiles);
+
+	maxWatches_ = watchLimit();
+	for (int i = 0; i < dirList.size(); i++) {
+		if (!addWatch(dirList[i].second))
+			break;
+	}
+
+	qDebug() << "Watching" << watchCount_ << "of" << dirMap_.size()
+	         << "directories";
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Stops watching all directories.
+ * Changes that were not reported yet are discarded.
+ */
+void CodebaseWatcher::stop()
+{
+	timer_.stop();
+
+	delete notifier_;
+	notifier_ = NULL;
+
+#ifdef Q_OS_LINUX
+	// Closing the descriptor removes all watches.
+	if (fd_ >= 0)
+		close(fd_);
+#endif
+
+	fd_ = -1;
+	dirMap_.clear();
+	wdMap_.clear();
+	watchCount_ = 0;
+	added_.clear();
+	removed_.clear();
+}
+
+/**
+ * Reloads the file list of the code base and the directory snapshot.
+ * Should be called when the list is replaced.
+ */
+void CodebaseWatcher::refresh()
+{
+	if (codebase_ != NULL)
+		start(codebase_, snapshotPath_);
+}
+
+/**
+ * Adds a file of the code base to its directory.
+ * @param  path  The path of the file
+ */
+void CodebaseWatcher::addFile(const QString& path)
+{
+	int pos = path.lastIndexOf(QDir::separator());
+	if (pos < 0)
+		return;
+
+	dirMap_[path.left(pos + 1)].files_.insert(path.mid(pos + 1));
+}
+
+/**
+ * Starts watching a directory.
+ * @param  dirPath  The path of the directory, with a trailing separator
+ * @return true if successful, false if the watch limit was reached
+ */
+bool CodebaseWatcher::addWatch(const QString& dirPath)
+{
+#ifdef Q_OS_LINUX
+	if (watchCount_ >= maxWatches_)
+		return false;
+
+	int wd = inotify_add_watch(fd_, QFile::encodeName(dirPath).constData(),
+	                           WatchMask);
+	if (wd < 0) {
+		// Do not try again if the system ran out of watches.
+		if (errno == ENOSPC)
+			maxWatches_ = watchCount_;
+		return errno != ENOSPC;
+	}
+
+	dirMap_[dirPath].wd_ = wd;
+	wdMap_[wd] = dirPath;
+	watchCount_++;
+	return true;
+#else
+	(void)dirPath;
+	return false;
+#endif
+}
+
+/**
+ * Adds a new directory and its sub-directories.
+ * Each directory is watched before it is listed, so that files created in the
+ * meantime are not missed.
+ * @param  dirPath  The path of the directory, with a trailing separator
+ */
+void CodebaseWatcher::addTree(const QString& dirPath)
+{
+	// Directories excluded by the filter are not watched.
+	if (!filter_.match(dirPath, true) || dirMap_.contains(dirPath))
+		return;
+
+	dirMap_.insert(dirPath, Dir());
+	addWatch(dirPath);
+
+	QDir dir(dirPath);
+	QFileInfoList infos = dir.entryInfoList(QDir::Files | QDir::Dirs
+	                                        | QDir::NoDotAndDotDot);
+	QFileInfoList::Iterator itr;
+	for (itr = infos.begin(); itr != infos.end(); ++itr) {
+		if (!(*itr).isDir())
+			fileAdded(dirPath, (*itr).fileName());
+		else if (!(*itr).isSymLink())
+			addTree(dirPath + (*itr).fileName() + QDir::separator());
+	}
+}
+
+/**
+ * Removes a directory and all directories below it.
+ * All of their files are removed from the code base.
+ * @param  dirPath  The path of the directory, with a trailing separator
+ */
+void CodebaseWatcher::removeTree(const QString& dirPath)
+{
+	QHash<QString, Dir>::Iterator itr = dirMap_.begin();
+	while (itr != dirMap_.end()) {
+		if (!itr.key().startsWith(dirPath)) {
+			++itr;
+			continue;
+		}
+
+		foreach (const QString& name, (*itr).files_) {
+			QString path = itr.key() + name;
+			if (!added_.remove(path))
+				removed_.insert(path);
+		}
+
+#ifdef Q_OS_LINUX
+		if ((*itr).wd_ >= 0) {
+			wdMap_.remove((*itr).wd_);
+			inotify_rm_watch(fd_, (*itr).wd_);
+			watchCount_--;
+		}
+#endif
+
+		itr = dirMap_.erase(itr);
+	}
+
+	if (!timer_.isActive())
+		timer_.start();
+}
+
+/**
+ * Compares the contents of a directory with its files in the code base.
+ * Used when events were lost.
+ * @param  dirPath  The path of the directory, with a trailing separator
+ */
+void CodebaseWatcher::syncDir(const QString& dirPath)
+{
+	QDir dir(dirPath);
+	QSet<QString> names = dir.entryList(QDir::Files).toSet();
+
+	foreach (const QString& name, names)
+		fileAdded(dirPath, name);
+
+	foreach (const QString& name, dirMap_.value(dirPath).files_) {
+		if (!names.contains(name))
+			fileRemoved(dirPath, name);
+	}
+}
+
+/**
+ * Handles a file that appeared in a directory.
+ * @param  dirPath  The path of the directory, with a trailing separator
+ * @param  name     The name of the file
+ */
+void CodebaseWatcher::fileAdded(const QString& dirPath, const QString& name)
+{
+	QString path = dirPath + name;
+	if (!filter_.match(path, false))
+		return;
+
+	QSet<QString>& files = dirMap_[dirPath].files_;
+	if (files.contains(name))
+		return;
+
+	// A file that was removed and then created again (e.g., saved by
+	// renaming a temporary file over it) did not change its membership.
+	files.insert(name);
+	if (!removed_.remove(path))
+		added_.insert(path);
+
+	if (!timer_.isActive())
+		timer_.start();
+}
+
+/**
+ * Handles a file that disappeared from a directory.
+ * @param  dirPath  The path of the directory, with a trailing separator
+ * @param  name     The name of the file
+ */
+void CodebaseWatcher::fileRemoved(const QString& dirPath, const QString& name)
+{
+	QHash<QString, Dir>::Iterator itr = dirMap_.find(dirPath);
+	if ((itr == dirMap_.end()) || !(*itr).files_.remove(name))
+		return;
+
+	QString path = dirPath + name;
+	if (!added_.remove(path))
+		removed_.insert(path);
+
+	if (!timer_.isActive())
+		timer_.start();
+}
+
+/**
+ * Handles a single inotify event.
+ * @param  wd    The watch descriptor of the directory
+ * @param  mask  Describes the event
+ * @param  name  The name of the entry in the directory, if any
+ */
+void CodebaseWatcher::handleEvent(int wd, quint32 mask, const QString& name)
+{
+#ifdef Q_OS_LINUX
+	// Events were lost: compare all watched directories with their contents.
+	if (mask & IN_Q_OVERFLOW) {
+		QStringList dirList = wdMap_.values();
+		foreach (const QString& dirPath, dirList)
+			syncDir(dirPath);
+		return;
+	}
+
+	QHash<int, QString>::ConstIterator itr = wdMap_.find(wd);
+	if (itr == wdMap_.end())
+		return;
+
+	QString dirPath = *itr;
+
+	// The directory itself was deleted, moved or unmounted.
+	if (mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED | IN_UNMOUNT)) {
+		removeTree(dirPath);
+		return;
+	}
+
+	// Skip hidden entries, as does FileScanner.
+	if (name.isEmpty() || name.startsWith('.'))
+		return;
+
+	bool created = (mask & (IN_CREATE | IN_MOVED_TO));
+	if (mask & IN_ISDIR) {
+		QString path = dirPath + name + QDir::separator();
+		if (created)
+			addTree(path);
+		else
+			removeTree(path);
+	}
+	else if (created) {
+		fileAdded(dirPath, name);
+	}
+	else {
+		fileRemoved(dirPath, name);
+	}
+#else
+	(void)wd;
+	(void)mask;
+	(void)name;
+#endif
+}
+
+/**
+ * @return The maximal number of directories to watch
+ */
+int CodebaseWatcher::watchLimit()
+{
+	int limit = 8192;
+
+#ifdef Q_OS_LINUX
+	QFile file("/proc/sys/fs/inotify/max_user_watches");
+	if (file.open(QIODevice::ReadOnly)) {
+		bool ok;
+		int value = file.readAll().trimmed().toInt(&ok);
+		if (ok && (value > 0))
+			limit = value;
+	}
+#endif
+
+	// Leave room for other applications.
+	return limit / 2;
+}
+
+/**
+ * Reads pending events from the inotify descriptor.
+ */
+void CodebaseWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+	// The buffer is aligned for inotify_event structures.
+	quint64 buf[512];
+	char* data = reinterpret_cast<char*>(buf);
+
+	for (;;) {
+		ssize_t len = read(fd_, data, sizeof(buf));
+		if (len <= 0)
+			break;
+
+		char* ptr = data;
+		while (ptr < data + len) {
+			const struct inotify_event* event
+				= reinterpret_cast<const struct inotify_event*>(ptr);
+
+			QString name;
+			if (event->len > 0)
+				name = QFile::decodeName(event->name);
+
+			handleEvent(event->wd, event->mask, name);
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+	}
+#endif
+}
+
+/**
+ * Reports the changes collected since the last report.
+ */
+void CodebaseWatcher::flush()
+{
+	if (added_.isEmpty() && removed_.isEmpty())
+		return;
+
+	QStringList added = added_.toList();
+	QStringList removed = removed_.toList();
+	added.sort();
+	removed.sort();
+	added_.clear();
+	removed_.clear();
+
+	qDebug() << "Code base changed:" << added.size() << "added"
+	         << removed.size() << "removed";
+	emit filesChanged(added, removed);
+}
+
+} // namespace Core
+
+} // namespace KScope
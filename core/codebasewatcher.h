@@ -0,0 +1,194 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_CODEBASEWATCHER_H__
+#define __CORE_CODEBASEWATCHER_H__
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include "codebase.h"
+#include "filefilter.h"
+
+class QSocketNotifier;
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Tracks files created in and deleted from the directories of a code base.
+ * The watcher keeps the file list of the code base, grouped by directory,
+ * and watches each of these directories for files being created, deleted or
+ * renamed (using inotify, on Linux). Files that appear in a watched directory
+ * become members of the code base if they match the filter, and members that
+ * disappear are removed from it. Sub-directories created inside a watched
+ * directory (e.g., by a code generator or a branch switch) are scanned and
+ * watched as well, unless excluded by the filter.
+ * Changes are collected and reported in batches, through filesChanged(), so
+ * that a burst of activity results in a single update. Files created and
+ * deleted within the same batch are not reported at all.
+ * Only directories holding files of the code base, and those scanned when
+ * files were last added (as recorded in the directory snapshot), are watched,
+ * rather than the entire tree. Directories holding more files are watched
+ * first.
+ * The number of watches is capped at half of the system-wide limit, which
+ * is shared with other applications.
+ * @author Elad Lahav
+ */
+class CodebaseWatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	CodebaseWatcher(QObject* parent = NULL);
+	~CodebaseWatcher();
+
+	bool start(const Codebase*, const QString&);
+	void stop();
+
+	/**
+	 * @return The number of watched directories
+	 */
+	int watchCount() const { return watchCount_; }
+
+public slots:
+	void refresh();
+
+signals:
+	/**
+	 * Reports files added to and removed from the code base.
+	 * @param  added    New files matching the filter
+	 * @param  removed  Files of the code base that were deleted
+	 */
+	void filesChanged(const QStringList& added, const QStringList& removed);
+
+private:
+	/**
+	 * A directory holding files of the code base.
+	 */
+	struct Dir
+	{
+		Dir() : wd_(-1) {}
+
+		/**
+		 * The watch descriptor, -1 if the directory is not watched.
+		 */
+		int wd_;
+
+		/**
+		 * The names of the code base's files in the directory.
+		 */
+		QSet<QString> files_;
+	};
+
+	/**
+	 * The time, in milliseconds, changes are collected before being
+	 * reported.
+	 */
+	static const int BatchDelay = 1000;
+
+	/**
+	 * The watched code base.
+	 */
+	const Codebase* codebase_;
+
+	/**
+	 * The file holding the directory snapshot of the last scan.
+	 */
+	QString snapshotPath_;
+
+	/**
+	 * The filter applied to new files.
+	 */
+	FileFilter filter_;
+
+	/**
+	 * The inotify file descriptor, -1 if not watching.
+	 */
+	int fd_;
+
+	/**
+	 * Signals that events can be read from the descriptor.
+	 */
+	QSocketNotifier* notifier_;
+
+	/**
+	 * Directories, indexed by their path (with a trailing separator).
+	 */
+	QHash<QString, Dir> dirMap_;
+
+	/**
+	 * Maps watch descriptors to directory paths.
+	 */
+	QHash<int, QString> wdMap_;
+
+	/**
+	 * The number of watched directories.
+	 */
+	int watchCount_;
+
+	/**
+	 * The maximal number of watched directories.
+	 */
+	int maxWatches_;
+
+	/**
+	 * Files added since changes were last reported.
+	 */
+	QSet<QString> added_;
+
+	/**
+	 * Files removed since changes were last reported.
+	 */
+	QSet<QString> removed_;
+
+	/**
+	 * Delays the report of changes.
+	 */
+	QTimer timer_;
+
+	void addFile(const QString&);
+	bool addWatch(const QString&);
+	void addTree(const QString&);
+	void removeTree(const QString&);
+	void syncDir(const QString&);
+	void fileAdded(const QString&, const QString&);
+	void fileRemoved(const QString&, const QString&);
+	void handleEvent(int, quint32, const QString&);
+
+	static int watchLimit();
+
+	friend struct AddFileCallback;
+
+private slots:
+	void readEvents();
+	void flush();
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_CODEBASEWATCHER_H__
@@ -0,0 +1,448 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QObject>
+#include <QStringList>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include "codemetrics.h"
+#include "includegraph.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Maps report names, as given in query patterns, to reports.
+ */
+static const struct {
+	const char* name_;
+	CodeMetrics::Report report_;
+} ReportNames[] = {
+	{ "unused", CodeMetrics::UnusedFunctions },
+	{ "referenced", CodeMetrics::MostReferenced },
+	{ "fanin", CodeMetrics::FanIn },
+	{ "fanout", CodeMetrics::FanOut },
+	{ "includes", CodeMetrics::IncludeCost },
+	{ NULL, CodeMetrics::UnusedFunctions }
+};
+
+/**
+ * Computes the cost of a header file.
+ * Applied to all headers concurrently, as each requires a traversal of the
+ * include graph.
+ */
+struct ClosureSize
+{
+	ClosureSize(const IncludeGraph& graph) : graph_(graph) {}
+
+	void operator()(CodeMetrics::Header& header) const {
+		header.cost_ = graph_.includerClosureSize(header.node_);
+	}
+
+	const IncludeGraph& graph_;
+};
+
+/**
+ * Class constructor.
+ */
+CodeMetrics::CodeMetrics()
+{
+}
+
+/**
+ * Class destructor.
+ */
+CodeMetrics::~CodeMetrics()
+{
+}
+
+/**
+ * Records the definition of a symbol.
+ * @param  name  The symbol name
+ * @param  type  The type of the definition
+ * @param  file  The file holding the definition
+ * @param  line  The line number of the definition
+ * @return The index of the symbol, to be passed to addCall() for calls made
+ *         from a function definition
+ */
+int CodeMetrics::addDefinition(const QByteArray& name, Tag::Type type,
+                               const QString& file, uint line)
+{
+	Key key(file, name);
+	QHash<Key, int>::ConstIterator itr = symbolMap_.find(key);
+	if (itr != symbolMap_.end())
+		return *itr;
+
+	Symbol sym;
+	sym.name_ = name;
+	sym.type_ = type;
+	sym.file_ = file;
+	sym.line_ = line;
+	sym.references_ = 0;
+	sym.calls_ = 0;
+	sym.callers_ = 0;
+	sym.callees_ = 0;
+	symbolList_.append(sym);
+
+	int index = symbolList_.size() - 1;
+	symbolMap_.insert(key, index);
+	if (!nameMap_.contains(name))
+		nameMap_.insert(name, index);
+
+	return index;
+}
+
+/**
+ * Records a function call.
+ * @param  caller  The index of the calling function, or -1 for a call outside
+ *                 a function definition
+ * @param  file    The file holding the call
+ * @param  callee  The name of the called function
+ */
+void CodeMetrics::addCall(int caller, const QString& file,
+                          const QByteArray& callee)
+{
+	int index = use(file, callee);
+	useList_[index].references_++;
+	useList_[index].calls_++;
+
+	if (caller >= 0)
+		callSet_.insert((quint64(caller) << 32) | quint64(index));
+}
+
+/**
+ * Records an occurrence of a symbol, other than a definition or a call.
+ * @param  file  The file holding the occurrence
+ * @param  name  The symbol name
+ */
+void CodeMetrics::addReference(const QString& file, const QByteArray& name)
+{
+	useList_[use(file, name)].references_++;
+}
+
+/**
+ * Attributes all uses to definitions, and computes the call graph measures of
+ * all functions and the cost of all header files.
+ * Must be called once all symbols were recorded.
+ * @param  graph  The resolved include graph of the code base
+ */
+void CodeMetrics::finalize(const IncludeGraph& graph)
+{
+	// Find the definition of each use: the one in the same file, if any, or
+	// the first one otherwise. Names that are not defined in the code base
+	// are not reported.
+	QVector<int> useSymbols(useList_.size());
+	for (int i = 0; i < useList_.size(); i++) {
+		const Use& entry = useList_[i];
+		int index = symbolMap_.value(entry.key_,
+		                             nameMap_.value(entry.key_.second, -1));
+		useSymbols[i] = index;
+		if (index < 0)
+			continue;
+
+		symbolList_[index].references_ += entry.references_;
+		symbolList_[index].calls_ += entry.calls_;
+	}
+
+	// Count distinct callers and callees.
+	QSet<quint64> callSet;
+	QSet<quint64>::ConstIterator itr;
+	for (itr = callSet_.begin(); itr != callSet_.end(); ++itr) {
+		int callee = useSymbols[int(*itr & 0xffffffff)];
+		if (callee >= 0)
+			callSet.insert((*itr & ~quint64(0xffffffff)) | quint64(callee));
+	}
+
+	for (itr = callSet.begin(); itr != callSet.end(); ++itr) {
+		symbolList_[int(*itr >> 32)].callees_++;
+		symbolList_[int(*itr & 0xffffffff)].callers_++;
+	}
+
+	useList_.clear();
+	useMap_.clear();
+	callSet_.clear();
+
+	// Collect all files of the code base that are included by other files.
+	headerList_.clear();
+	for (int i = 0; i < graph.size(); i++) {
+		if (graph.isExternal(i) || (graph.includerCount(i) == 0))
+			continue;
+
+		Header header;
+		header.node_ = i;
+		header.path_ = graph.path(i);
+		header.includers_ = graph.includerCount(i);
+		header.cost_ = 0;
+		headerList_.append(header);
+	}
+
+	// Each header requires a traversal of the graph, so spread them over all
+	// available cores.
+	QtConcurrent::blockingMap(headerList_, ClosureSize(graph));
+	std::sort(headerList_.begin(), headerList_.end(), moreCostly);
+	if (headerList_.size() > MaxResults)
+		headerList_.resize(MaxResults);
+}
+
+/**
+ * Discards all recorded information.
+ */
+void CodeMetrics::clear()
+{
+	symbolList_.clear();
+	symbolMap_.clear();
+	nameMap_.clear();
+	useList_.clear();
+	useMap_.clear();
+	callSet_.clear();
+	headerList_.clear();
+}
+
+/**
+ * Generates a report.
+ * Ranked reports hold at most MaxResults locations, in decreasing order of
+ * the measure, which is also stored in the count field of each location.
+ * @param  rep      The requested report
+ * @param  locList  Holds the results
+ */
+void CodeMetrics::report(Report rep, LocationList& locList) const
+{
+	// Select the symbols to report.
+	QVector<const Symbol*> symbols;
+	QVector<Symbol>::ConstIterator itr;
+	for (itr = symbolList_.begin(); itr != symbolList_.end(); ++itr) {
+		bool function = ((*itr).type_ == Tag::Function);
+		switch (rep) {
+		case UnusedFunctions:
+			if (function && ((*itr).references_ == 0)
+			    && ((*itr).name_ != "main")) {
+				symbols.append(&*itr);
+			}
+			break;
+
+		case MostReferenced:
+			if ((*itr).references_ > 0)
+				symbols.append(&*itr);
+			break;
+
+		case FanIn:
+			if (function && ((*itr).callers_ > 0))
+				symbols.append(&*itr);
+			break;
+
+		case FanOut:
+			if (function && ((*itr).callees_ > 0))
+				symbols.append(&*itr);
+			break;
+
+		case IncludeCost:
+			break;
+		}
+	}
+
+	// Order the results.
+	// Only the highest-ranking symbols need to be sorted.
+	bool (*lessThan)(const Symbol*, const Symbol*) = NULL;
+	switch (rep) {
+	case UnusedFunctions:
+		std::sort(symbols.begin(), symbols.end(), earlierDefinition);
+		break;
+
+	case MostReferenced:
+		lessThan = moreReferenced;
+		break;
+
+	case FanIn:
+		lessThan = moreCallers;
+		break;
+
+	case FanOut:
+		lessThan = moreCallees;
+		break;
+
+	case IncludeCost:
+		foreach (const Header& header, headerList_) {
+			Location loc(header.path_);
+			loc.count_ = header.cost_;
+			loc.text_ = QObject::tr("Included by %1 files (%2 directly)")
+			            .arg(header.cost_).arg(header.includers_);
+			locList.append(loc);
+		}
+		return;
+	}
+
+	if (lessThan) {
+		if (symbols.size() > MaxResults) {
+			std::partial_sort(symbols.begin(), symbols.begin() + MaxResults,
+			                  symbols.end(), lessThan);
+			symbols.resize(MaxResults);
+		}
+		else {
+			std::sort(symbols.begin(), symbols.end(), lessThan);
+		}
+	}
+
+	// Create a location for each symbol.
+	foreach (const Symbol* sym, symbols) {
+		Location loc = location(*sym);
+		switch (rep) {
+		case UnusedFunctions:
+			loc.text_ = QObject::tr("Never called or referenced");
+			break;
+
+		case MostReferenced:
+			loc.count_ = sym->references_;
+			loc.text_ = QObject::tr("%1 references").arg(sym->references_);
+			break;
+
+		case FanIn:
+			loc.count_ = sym->callers_;
+			loc.text_ = QObject::tr("Called by %1 functions (%2 call sites)")
+			            .arg(sym->callers_).arg(sym->calls_);
+			break;
+
+		case FanOut:
+			loc.count_ = sym->callees_;
+			loc.text_ = QObject::tr("Calls %1 functions")
+			            .arg(sym->callees_);
+			break;
+
+		case IncludeCost:
+			break;
+		}
+
+		locList.append(loc);
+	}
+}
+
+/**
+ * @param  name  A report name, as given in a query pattern
+ * @param  rep   Holds the matching report, upon successful return
+ * @return true if the name is valid, false otherwise
+ */
+bool CodeMetrics::reportFromName(const QString& name, Report& rep)
+{
+	for (int i = 0; ReportNames[i].name_; i++) {
+		if (name == ReportNames[i].name_) {
+			rep = ReportNames[i].report_;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @return The names of all reports
+ */
+QStringList CodeMetrics::reportNames()
+{
+	QStringList names;
+	for (int i = 0; ReportNames[i].name_; i++)
+		names << ReportNames[i].name_;
+
+	return names;
+}
+
+/**
+ * Finds or creates the entry for the uses of a name in a file.
+ * @param  file  The file holding the uses
+ * @param  name  The symbol name
+ * @return The index of the entry in the use list
+ */
+int CodeMetrics::use(const QString& file, const QByteArray& name)
+{
+	Key key(file, name);
+	QHash<Key, int>::ConstIterator itr = useMap_.find(key);
+	if (itr != useMap_.end())
+		return *itr;
+
+	Use entry;
+	entry.key_ = key;
+	entry.references_ = 0;
+	entry.calls_ = 0;
+	useList_.append(entry);
+
+	int index = useList_.size() - 1;
+	useMap_.insert(key, index);
+	return index;
+}
+
+/**
+ * Sorting function for the most referenced symbols.
+ */
+bool CodeMetrics::moreReferenced(const Symbol* sym1, const Symbol* sym2)
+{
+	return sym1->references_ > sym2->references_;
+}
+
+/**
+ * Sorting function for the functions with the largest fan-in.
+ */
+bool CodeMetrics::moreCallers(const Symbol* sym1, const Symbol* sym2)
+{
+	return sym1->callers_ > sym2->callers_;
+}
+
+/**
+ * Sorting function for the functions with the largest fan-out.
+ */
+bool CodeMetrics::moreCallees(const Symbol* sym1, const Symbol* sym2)
+{
+	return sym1->callees_ > sym2->callees_;
+}
+
+/**
+ * Sorting function for the most expensive headers.
+ */
+bool CodeMetrics::moreCostly(const Header& header1, const Header& header2)
+{
+	return header1.cost_ > header2.cost_;
+}
+
+/**
+ * Sorting function for reports in code order.
+ */
+bool CodeMetrics::earlierDefinition(const Symbol* sym1, const Symbol* sym2)
+{
+	if (sym1->file_ != sym2->file_)
+		return sym1->file_ < sym2->file_;
+
+	return sym1->line_ < sym2->line_;
+}
+
+/**
+ * @param  sym  A symbol defined in the code base
+ * @return The location of the definition
+ */
+Location CodeMetrics::location(const Symbol& sym)
+{
+	Location loc(sym.file_, sym.line_);
+	loc.tag_.name_ = QString::fromLocal8Bit(sym.name_);
+	loc.tag_.type_ = sym.type_;
+	return loc;
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,255 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_CODEMETRICS_H__
+#define __CORE_CODEMETRICS_H__
+
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+class IncludeGraph;
+
+/**
+ * Project-wide measures of the code base.
+ * Answering questions such as "which functions are never called?" through
+ * regular queries would take a References query for every symbol in the code
+ * base. Instead, the metrics are gathered during the single pass over the
+ * database that builds the other in-memory indices: the reader reports every
+ * definition, call and reference through the add*() methods, after which
+ * finalize() derives the per-function call graph measures and the cost of
+ * each header file from the include graph.
+ * Symbols are identified by the file holding their definition and their
+ * name, so that static functions with the same name in different files are
+ * kept apart. The database records calls and references by name only: a use
+ * is attributed to a definition of the name in the same file, if there is
+ * one, or to the first definition of the name otherwise. As definitions may
+ * follow their uses, uses are only resolved by finalize().
+ * @author Elad Lahav
+ */
+class CodeMetrics
+{
+public:
+	CodeMetrics();
+	~CodeMetrics();
+
+	/**
+	 * Available reports.
+	 */
+	enum Report {
+		/** Functions that are neither called nor referenced. */
+		UnusedFunctions,
+		/** Symbols with the largest number of references. */
+		MostReferenced,
+		/** Functions called from the largest number of functions. */
+		FanIn,
+		/** Functions calling the largest number of functions. */
+		FanOut,
+		/** Headers included, directly or not, by the most files. */
+		IncludeCost
+	};
+
+	int addDefinition(const QByteArray&, Tag::Type, const QString&, uint);
+	void addCall(int, const QString&, const QByteArray&);
+	void addReference(const QString&, const QByteArray&);
+	void finalize(const IncludeGraph&);
+	void clear();
+	void report(Report, LocationList&) const;
+
+	/**
+	 * @return true if no symbols were recorded, false otherwise
+	 */
+	bool isEmpty() const { return symbolList_.isEmpty(); }
+
+	static bool reportFromName(const QString&, Report&);
+	static QStringList reportNames();
+
+	/**
+	 * The maximal number of results in ranked reports.
+	 */
+	static const int MaxResults = 500;
+
+private:
+	/**
+	 * Identifies a symbol by the file holding its definition and its name.
+	 */
+	typedef QPair<QString, QByteArray> Key;
+
+	/**
+	 * Information gathered for each defined symbol.
+	 */
+	struct Symbol
+	{
+		/**
+		 * The name of the symbol.
+		 */
+		QByteArray name_;
+
+		/**
+		 * The type of the first definition in the file.
+		 */
+		Tag::Type type_;
+
+		/**
+		 * The file holding the definition.
+		 */
+		QString file_;
+
+		/**
+		 * The line of the first definition in the file.
+		 */
+		uint line_;
+
+		/**
+		 * The number of occurrences, other than definitions.
+		 */
+		int references_;
+
+		/**
+		 * The number of call sites.
+		 */
+		int calls_;
+
+		/**
+		 * The number of distinct functions calling this one.
+		 */
+		int callers_;
+
+		/**
+		 * The number of distinct functions called by this one.
+		 */
+		int callees_;
+	};
+
+	/**
+	 * The uses of a name in a single file, before they are attributed to a
+	 * definition.
+	 */
+	struct Use
+	{
+		/**
+		 * The file and the name.
+		 */
+		Key key_;
+
+		/**
+		 * The number of occurrences, other than definitions.
+		 */
+		int references_;
+
+		/**
+		 * The number of call sites.
+		 */
+		int calls_;
+	};
+
+	/**
+	 * A header file and the number of files depending on it.
+	 */
+	struct Header
+	{
+		/**
+		 * The node of the file in the include graph.
+		 */
+		int node_;
+
+		/**
+		 * The path of the file.
+		 */
+		QString path_;
+
+		/**
+		 * The number of files including the header directly.
+		 */
+		int includers_;
+
+		/**
+		 * The number of files including the header, directly or not.
+		 */
+		int cost_;
+	};
+
+	/**
+	 * All recorded symbols.
+	 */
+	QVector<Symbol> symbolList_;
+
+	/**
+	 * Maps symbol keys to their indices in the symbol list.
+	 */
+	QHash<Key, int> symbolMap_;
+
+	/**
+	 * Maps names to the index of their first definition.
+	 */
+	QHash<QByteArray, int> nameMap_;
+
+	/**
+	 * Uses of names, per file.
+	 * Only kept until finalize() is called.
+	 */
+	QVector<Use> useList_;
+
+	/**
+	 * Maps use keys to their indices in the use list.
+	 * Only kept until finalize() is called.
+	 */
+	QHash<Key, int> useMap_;
+
+	/**
+	 * Distinct caller/callee pairs, each encoded as the index of the caller
+	 * symbol in the upper 32 bits, and the index of the callee's use in the
+	 * lower 32.
+	 * Only kept until finalize() is called.
+	 */
+	QSet<quint64> callSet_;
+
+	/**
+	 * Headers, most expensive first.
+	 */
+	QVector<Header> headerList_;
+
+	int use(const QString&, const QByteArray&);
+
+	static bool moreReferenced(const Symbol*, const Symbol*);
+	static bool moreCallers(const Symbol*, const Symbol*);
+	static bool moreCallees(const Symbol*, const Symbol*);
+	static bool moreCostly(const Header&, const Header&);
+	static bool earlierDefinition(const Symbol*, const Symbol*);
+	static Location location(const Symbol&);
+
+	friend struct ClosureSize;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_CODEMETRICS_H__
@@ -0,0 +1,509 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include "compiledb.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The number of bytes read from the database file at a time.
+ */
+static const qint64 ChunkSize = 64 * 1024;
+
+/**
+ * Limits the nesting of skipped values, to protect against malformed files.
+ */
+static const int MaxDepth = 64;
+
+/**
+ * Class constructor.
+ */
+CompileDb::CompileDb() : pos_(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+CompileDb::~CompileDb()
+{
+}
+
+/**
+ * Parses a compilation database.
+ * The callback is invoked once for each entry that names a source file, in the
+ * order in which entries appear in the file.
+ * @param  path  The path of the compile_commands.json file
+ * @param  cb    Receives the parsed entries
+ * @return true if successful, false if the file could not be read or is not a
+ *         valid compilation database (see errorString())
+ */
+bool CompileDb::read(const QString& path, Callback<const Entry&>& cb)
+{
+	file_.close();
+	file_.setFileName(path);
+	buf_.clear();
+	pos_ = 0;
+	error_.clear();
+
+	if (!file_.open(QIODevice::ReadOnly))
+		return fail(QString("Cannot open '%1' for reading").arg(path));
+
+	// The database is an array of objects.
+	if (!expect('['))
+		return false;
+
+	skipSpace();
+	if (peek() == ']')
+		return true;
+
+	while (true) {
+		Entry entry;
+		if (!readEntry(entry))
+			return false;
+
+		if (!entry.file_.isEmpty()) {
+			// File names may be relative to the working directory.
+			entry.file_ = QDir::cleanPath(QDir(entry.directory_)
+			                              .absoluteFilePath(entry.file_));
+			cb.call(entry);
+		}
+
+		skipSpace();
+		switch (next()) {
+		case ',':
+			break;
+
+		case ']':
+			file_.close();
+			return true;
+
+		default:
+			return fail("Expected ',' or ']' after an entry");
+		}
+	}
+}
+
+/**
+ * Splits a command line into arguments, following the quoting rules of a
+ * POSIX shell: white space separates arguments, single quotes protect all
+ * characters and double quotes protect all but escaped quotes and
+ * back-slashes.
+ * @param  command  The command line to split
+ * @return The list of arguments
+ */
+QStringList CompileDb::splitCommand(const QString& command)
+{
+	QStringList args;
+	QString arg;
+	bool inArg = false;
+	QChar quote;
+
+	for (int i = 0; i < command.length(); i++) {
+		QChar c = command[i];
+
+		if (quote == '\'') {
+			if (c == '\'')
+				quote = QChar();
+			else
+				arg += c;
+		}
+		else if (quote == '"') {
+			if (c == '"') {
+				quote = QChar();
+			}
+			else if (c == '\\' && (i + 1) < command.length()
+			         && (command[i + 1] == '"' || command[i + 1] == '\\')) {
+				arg += command[++i];
+			}
+			else {
+				arg += c;
+			}
+		}
+		else if (c.isSpace()) {
+			if (inArg) {
+				args.append(arg);
+				arg.clear();
+				inArg = false;
+			}
+		}
+		else {
+			inArg = true;
+			if (c == '\'' || c == '"')
+				quote = c;
+			else if (c == '\\' && (i + 1) < command.length())
+				arg += command[++i];
+			else
+				arg += c;
+		}
+	}
+
+	if (inArg)
+		args.append(arg);
+
+	return args;
+}
+
+/**
+ * Extracts the user include directories (-I and -iquote) from a compilation
+ * command.
+ * System directories (-isystem) are ignored, as these are not considered part
+ * of the code base.
+ * @param  entry  The compilation command
+ * @return A list of absolute, clean directory paths
+ */
+QStringList CompileDb::includeDirs(const Entry& entry)
+{
+	QStringList dirs;
+	QDir workDir(entry.directory_);
+
+	for (int i = 0; i < entry.arguments_.size(); i++) {
+		const QString& arg = entry.arguments_[i];
+		QString dir;
+
+		if (arg == "-I" || arg == "-iquote") {
+			if ((i + 1) < entry.arguments_.size())
+				dir = entry.arguments_[++i];
+		}
+		else if (arg.startsWith("-iquote")) {
+			dir = arg.mid(7);
+		}
+		else if (arg.startsWith("-I")) {
+			dir = arg.mid(2);
+		}
+
+		if (!dir.isEmpty())
+			dirs.append(QDir::cleanPath(workDir.absoluteFilePath(dir)));
+	}
+
+	return dirs;
+}
+
+/**
+ * @return The next byte in the file, without consuming it, or -1 at the end
+ *         of the file
+ */
+int CompileDb::peek()
+{
+	if (pos_ >= buf_.size()) {
+		buf_ = file_.read(ChunkSize);
+		pos_ = 0;
+		if (buf_.isEmpty())
+			return -1;
+	}
+
+	return static_cast<uchar>(buf_[pos_]);
+}
+
+/**
+ * @return The next byte in the file, or -1 at the end of the file
+ */
+int CompileDb::next()
+{
+	int c = peek();
+	if (c != -1)
+		pos_++;
+
+	return c;
+}
+
+/**
+ * Consumes white space.
+ */
+void CompileDb::skipSpace()
+{
+	int c;
+	while ((c = peek()) == ' ' || c == '\t' || c == '\n' || c == '\r')
+		pos_++;
+}
+
+/**
+ * Consumes the given character, following optional white space.
+ * @param  c  The expected character
+ * @return true if the character was found, false otherwise
+ */
+bool CompileDb::expect(char c)
+{
+	skipSpace();
+	if (next() != c)
+		return fail(QString("Expected '%1'").arg(c));
+
+	return true;
+}
+
+/**
+ * Parses a JSON string.
+ * The raw bytes are collected first and decoded as UTF-8 once the string is
+ * complete, so that multi-byte sequences split between chunks are handled
+ * correctly.
+ * @param  str  Holds the parsed string, upon successful return
+ * @return true if successful, false otherwise
+ */
+bool CompileDb::readString(QString& str)
+{
+	if (!expect('"'))
+		return false;
+
+	QByteArray bytes;
+	while (true) {
+		int c = next();
+		if (c == -1)
+			return fail("Unterminated string");
+
+		if (c == '"')
+			break;
+
+		if (c != '\\') {
+			bytes.append(static_cast<char>(c));
+			continue;
+		}
+
+		// Handle an escape sequence.
+		switch (c = next()) {
+		case 'b':
+			bytes.append('\b');
+			break;
+
+		case 'f':
+			bytes.append('\f');
+			break;
+
+		case 'n':
+			bytes.append('\n');
+			break;
+
+		case 'r':
+			bytes.append('\r');
+			break;
+
+		case 't':
+			bytes.append('\t');
+			break;
+
+		case 'u':
+			{
+				QString chars;
+				do {
+					QByteArray hex;
+					for (int i = 0; i < 4; i++)
+						hex.append(static_cast<char>(next()));
+
+					bool ok;
+					ushort code = hex.toUShort(&ok, 16);
+					if (!ok)
+						return fail("Invalid Unicode escape sequence");
+
+					chars.append(QChar(code));
+
+					// A high surrogate is followed by an escaped low
+					// surrogate.
+				} while (chars[chars.length() - 1].isHighSurrogate()
+				         && peek() == '\\' && next() == '\\'
+				         && next() == 'u');
+
+				bytes.append(chars.toUtf8());
+			}
+			break;
+
+		case -1:
+			return fail("Unterminated string");
+
+		default:
+			// '"', '\\' and '/' stand for themselves.
+			bytes.append(static_cast<char>(c));
+		}
+	}
+
+	str = QString::fromUtf8(bytes);
+	return true;
+}
+
+/**
+ * Parses an array of strings.
+ * @param  list  Holds the parsed strings, upon successful return
+ * @return true if successful, false otherwise
+ */
+bool CompileDb::readStringArray(QStringList& list)
+{
+	if (!expect('['))
+		return false;
+
+	skipSpace();
+	if (peek() == ']') {
+		pos_++;
+		return true;
+	}
+
+	while (true) {
+		QString str;
+		if (!readString(str))
+			return false;
+
+		list.append(str);
+
+		skipSpace();
+		switch (next()) {
+		case ',':
+			break;
+
+		case ']':
+			return true;
+
+		default:
+			return fail("Expected ',' or ']' in an array");
+		}
+	}
+}
+
+/**
+ * Parses a single entry in the database.
+ * @param  entry  Holds the parsed entry, upon successful return
+ * @return true if successful, false otherwise
+ */
+bool CompileDb::readEntry(Entry& entry)
+{
+	if (!expect('{'))
+		return false;
+
+	skipSpace();
+	if (peek() == '}') {
+		pos_++;
+		return true;
+	}
+
+	QString command;
+	while (true) {
+		QString key;
+		if (!readString(key) || !expect(':'))
+			return false;
+
+		skipSpace();
+		bool result;
+		if (key == "directory" && peek() == '"')
+			result = readString(entry.directory_);
+		else if (key == "file" && peek() == '"')
+			result = readString(entry.file_);
+		else if (key == "command" && peek() == '"')
+			result = readString(command);
+		else if (key == "arguments" && peek() == '[')
+			result = readStringArray(entry.arguments_);
+		else
+			result = skipValue();
+
+		if (!result)
+			return false;
+
+		skipSpace();
+		int c = next();
+		if (c == '}')
+			break;
+
+		if (c != ',')
+			return fail("Expected ',' or '}' in an entry");
+	}
+
+	// The "arguments" key takes precedence over "command".
+	if (entry.arguments_.isEmpty())
+		entry.arguments_ = splitCommand(command);
+
+	return true;
+}
+
+/**
+ * Consumes a JSON value of any type.
+ * @param  depth  The current nesting level
+ * @return true if successful, false otherwise
+ */
+bool CompileDb::skipValue(int depth)
+{
+	if (depth > MaxDepth)
+		return fail("Values are nested too deeply");
+
+	skipSpace();
+	int c = peek();
+	if (c == '"') {
+		QString str;
+		return readString(str);
+	}
+
+	if (c == '{' || c == '[') {
+		int close = (c == '{') ? '}' : ']';
+
+		pos_++;
+		skipSpace();
+		if (peek() == close) {
+			pos_++;
+			return true;
+		}
+
+		while (true) {
+			if (close == '}') {
+				QString key;
+				if (!readString(key) || !expect(':'))
+					return false;
+			}
+
+			if (!skipValue(depth + 1))
+				return false;
+
+			skipSpace();
+			c = next();
+			if (c == close)
+				return true;
+
+			if (c != ',')
+				return fail("Malformed object or array");
+		}
+	}
+
+	// Numbers and literals (true, false, null).
+	int len = 0;
+	while ((c = peek()) != -1 && c != ',' && c != ']' && c != '}' && c != ' '
+	       && c != '\t' && c != '\n' && c != '\r') {
+		pos_++;
+		len++;
+	}
+
+	if (len == 0)
+		return fail("Expected a value");
+
+	return true;
+}
+
+/**
+ * Records an error.
+ * @param  msg  The error message
+ * @return Always false
+ */
+bool CompileDb::fail(const QString& msg)
+{
+	error_ = msg;
+	file_.close();
+	return false;
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_COMPILEDB_H__
+#define __CORE_COMPILEDB_H__
+
+#include <QFile>
+#include <QStringList>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Reads a compile_commands.json compilation database.
+ * Compilation databases for large code bases can reach hundreds of megabytes,
+ * so the file is never loaded as a whole. Instead, a small tokeniser reads
+ * the file in fixed-size chunks and reports each entry through a callback
+ * as soon as it has been parsed. Only the "directory", "file", "command" and
+ * "arguments" keys are retained; all other values are skipped.
+ * @author Elad Lahav
+ */
+class CompileDb
+{
+public:
+	/**
+	 * A single compilation command.
+	 */
+	struct Entry
+	{
+		/**
+		 * The working directory of the command.
+		 */
+		QString directory_;
+
+		/**
+		 * The main translation unit, as an absolute, clean path.
+		 */
+		QString file_;
+
+		/**
+		 * The compiler command line, split into arguments.
+		 */
+		QStringList arguments_;
+	};
+
+	CompileDb();
+	~CompileDb();
+
+	bool read(const QString& path, Callback<const Entry&>& cb);
+
+	/**
+	 * @return A description of the last error encountered by read()
+	 */
+	const QString& errorString() const { return error_; }
+
+	static QStringList splitCommand(const QString& command);
+	static QStringList includeDirs(const Entry& entry);
+
+private:
+	/**
+	 * The database file.
+	 */
+	QFile file_;
+
+	/**
+	 * The current chunk of data read from the file.
+	 */
+	QByteArray buf_;
+
+	/**
+	 * The position of the next unread byte in buf_.
+	 */
+	int pos_;
+
+	/**
+	 * Describes the last error.
+	 */
+	QString error_;
+
+	int peek();
+	int next();
+	void skipSpace();
+	bool expect(char c);
+	bool readString(QString& str);
+	bool readStringArray(QStringList& list);
+	bool readEntry(Entry& entry);
+	bool skipValue(int depth = 0);
+	bool fail(const QString& msg);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_COMPILEDB_H__
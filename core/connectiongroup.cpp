@@ -0,0 +1,169 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "connectiongroup.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ * @param  conn   The connection of the original operation
+ * @param  count  The number of branches
+ */
+ConnectionGroup::ConnectionGroup(Engine::Connection* conn, int count)
+	: QObject(), conn_(conn), pending_(count), aborted_(false),
+	  timedOut_(false)
+{
+	for (int i = 0; i < count; i++)
+		branchList_.append(new Branch(this));
+
+	conn_->setCtrlObject(this);
+}
+
+/**
+ * Class destructor.
+ */
+ConnectionGroup::~ConnectionGroup()
+{
+	foreach (Branch* branch, branchList_)
+		delete branch;
+}
+
+/**
+ * @param  index  The index of the branch
+ * @return The connection object to attach to the sub-operation
+ */
+Engine::Connection* ConnectionGroup::branch(int index)
+{
+	return branchList_[index];
+}
+
+/**
+ * Marks all results produced by a branch with a project name.
+ * @param  index  The index of the branch
+ * @param  tag    The project name
+ */
+void ConnectionGroup::setTag(int index, const QString& tag)
+{
+	branchList_[index]->tag_ = tag;
+}
+
+/**
+ * Stops all running sub-operations.
+ */
+void ConnectionGroup::stop()
+{
+	foreach (Branch* branch, branchList_)
+		branch->stop();
+}
+
+/**
+ * Called whenever a branch terminates.
+ * When the last branch terminates, the original connection is notified.
+ * The operation is reported as timed-out only if no branch has aborted, so
+ * that the partial results of the timed-out branches are still considered.
+ * Deletion is deferred, since the sub-operation may still access its branch.
+ * @param  aborted  true if the branch terminated abnormally
+ */
+void ConnectionGroup::branchDone(bool aborted)
+{
+	if (aborted)
+		aborted_ = true;
+
+	if (--pending_ > 0)
+		return;
+
+	conn_->setCtrlObject(NULL);
+	if (aborted_)
+		conn_->onAborted();
+	else if (timedOut_)
+		conn_->onTimedOut();
+	else
+		conn_->onFinished();
+
+	deleteLater();
+}
+
+/**
+ * Forwards results to the original connection.
+ * @param  locList  A list of results
+ */
+void ConnectionGroup::Branch::onDataReady(const LocationList& locList)
+{
+	if (tag_.isEmpty()) {
+		group_->conn_->onDataReady(locList);
+		return;
+	}
+
+	LocationList taggedList(locList);
+	LocationList::Iterator itr;
+	for (itr = taggedList.begin(); itr != taggedList.end(); ++itr)
+		(*itr).project_ = tag_;
+
+	group_->conn_->onDataReady(taggedList);
+}
+
+/**
+ * Called when the sub-operation terminates successfully.
+ */
+void ConnectionGroup::Branch::onFinished()
+{
+	group_->branchDone(false);
+}
+
+/**
+ * Called when the sub-operation terminates abnormally.
+ */
+void ConnectionGroup::Branch::onAborted()
+{
+	group_->branchDone(true);
+}
+
+/**
+ * Called when the sub-operation is stopped by a time limit.
+ */
+void ConnectionGroup::Branch::onTimedOut()
+{
+	group_->timedOut_ = true;
+	group_->branchDone(false);
+}
+
+/**
+ * Forwards progress information from a single-branch group.
+ * Progress values of concurrent sub-operations cannot be combined in a
+ * meaningful way, and so are not reported.
+ * @param  text   A message describing the kind of progress made
+ * @param  cur    The current value
+ * @param  total  The expected final value
+ */
+void ConnectionGroup::Branch::onProgress(const QString& text, uint cur,
+                                         uint total)
+{
+	if (group_->branchList_.size() == 1)
+		group_->conn_->onProgress(text, cur, total);
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_CONNECTIONGROUP_H__
+#define __CORE_CONNECTIONGROUP_H__
+
+#include <QObject>
+#include <QList>
+#include "engine.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Splits a single engine operation into several concurrent ones.
+ * Each sub-operation is attached to one of the group's branches. Data
+ * produced by any branch is forwarded to the original connection, which is
+ * notified of termination only once all branches have terminated. Stopping
+ * the original connection stops all branches.
+ * Branches can be tagged, in which case their results are marked with the
+ * tag as the name of the project that produced them.
+ * The object deletes itself once all branches terminate.
+ * @author Elad Lahav
+ */
+class ConnectionGroup : public QObject, public Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	ConnectionGroup(Engine::Connection*, int);
+	~ConnectionGroup();
+
+	Engine::Connection* branch(int);
+	void setTag(int, const QString&);
+	void stop();
+
+private:
+	/**
+	 * A connection for a single sub-operation.
+	 */
+	struct Branch : public Engine::Connection
+	{
+		Branch(ConnectionGroup* group) : Engine::Connection(), group_(group) {}
+
+		void onDataReady(const LocationList& locList);
+		void onFinished();
+		void onAborted();
+		void onTimedOut();
+		void onProgress(const QString&, uint, uint);
+
+		/**
+		 * The owner of this branch.
+		 */
+		ConnectionGroup* group_;
+
+		/**
+		 * If not empty, the project name set on results from this branch.
+		 */
+		QString tag_;
+	};
+
+	/**
+	 * The connection of the original operation.
+	 */
+	Engine::Connection* conn_;
+
+	/**
+	 * The branches.
+	 */
+	QList<Branch*> branchList_;
+
+	/**
+	 * The number of branches that are still running.
+	 */
+	int pending_;
+
+	/**
+	 * Whether any of the branches terminated abnormally.
+	 */
+	bool aborted_;
+
+	/**
+	 * Whether any of the branches was stopped by a time limit.
+	 */
+	bool timedOut_;
+
+	void branchDone(bool);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_CONNECTIONGROUP_H__
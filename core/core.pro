@@ -2,6 +2,7 @@ include(../config)
 TEMPLATE = lib
 TARGET = kscope_core
 CONFIG += dll
+QT += concurrent
 
 # Input
 HEADERS += locationtreemodel.h \
@@ -24,7 +25,23 @@ HEADERS += locationtreemodel.h \
     engine.h \
     locationview.h \
     textfilterdialog.h \
-    fileutils.h
+    fileutils.h \
+    pathindex.h \
+    includegraph.h \
+    symbolindex.h \
+    connectiongroup.h \
+    textsearch.h \
+    querycomposer.h \
+    compiledb.h \
+    gitindex.h \
+    querycache.h \
+    multiengine.h \
+    queryusage.h \
+    cachedengine.h \
+    codemetrics.h \
+    rename.h \
+    dirsnapshot.h \
+    codebasewatcher.h
 FORMS += progressbar.ui \
     textfilterdialog.ui
 SOURCES += locationtreemodel.cpp \
@@ -37,7 +54,24 @@ SOURCES += locationtreemodel.cpp \
     progressbar.cpp \
     locationview.cpp \
     textfilterdialog.cpp \
-    fileutils.cpp
+    fileutils.cpp \
+    pathindex.cpp \
+    includegraph.cpp \
+    symbolindex.cpp \
+    connectiongroup.cpp \
+    textsearch.cpp \
+    querycomposer.cpp \
+    compiledb.cpp \
+    gitindex.cpp \
+    querycache.cpp \
+    multiengine.cpp \
+    queryusage.cpp \
+    cachedengine.cpp \
+    codemetrics.cpp \
+    rename.cpp \
+    filefilter.cpp \
+    dirsnapshot.cpp \
+    codebasewatcher.cpp
 RESOURCES = core.qrc
 target.path = $${INSTALL_PATH}/lib
 INSTALLS += target
@@ -0,0 +1,259 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSet>
+#include "dirsnapshot.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Identifies snapshot files.
+ */
+static const quint32 Magic = 0x4b534453;
+
+/**
+ * The version of the file format.
+ */
+static const quint32 Version = 1;
+
+/**
+ * Class constructor.
+ */
+DirSnapshot::DirSnapshot() : recursive_(false), incremental_(false),
+                             dirty_(false)
+{
+}
+
+/**
+ * Class destructor.
+ */
+DirSnapshot::~DirSnapshot()
+{
+}
+
+/**
+ * Reads a snapshot from a file.
+ * A missing file is not an error, as it is only created once a scan
+ * completes.
+ * @param  path  The path of the file
+ * @return true if successful, false otherwise
+ */
+bool DirSnapshot::load(const QString& path)
+{
+	path_ = path;
+	root_.clear();
+	filter_.clear();
+	recursive_ = false;
+	dirMap_.clear();
+	dirty_ = false;
+
+	QFile file(path_);
+	if (!file.exists())
+		return true;
+
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_5_0);
+
+	quint32 magic, version, count;
+	strm >> magic >> version;
+	if ((magic != Magic) || (version != Version))
+		return false;
+
+	strm >> root_ >> filter_ >> recursive_ >> count;
+	for (quint32 i = 0; (i < count) && (strm.status() == QDataStream::Ok);
+	     i++) {
+		QString dirPath;
+		Dir dir;
+		strm >> dirPath >> dir.mtime_ >> dir.addFiles_ >> dir.dirs_
+		     >> dir.files_;
+		dirMap_.insert(dirPath, dir);
+	}
+
+	// Do not use a partial snapshot.
+	if (strm.status() != QDataStream::Ok) {
+		root_.clear();
+		dirMap_.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Writes the snapshot to the file given to load().
+ * @return true if successful, false otherwise
+ */
+bool DirSnapshot::save()
+{
+	if (!dirty_ || path_.isEmpty())
+		return true;
+
+	QSaveFile file(path_);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream strm(&file);
+	strm.setVersion(QDataStream::Qt_5_0);
+	strm << Magic << Version << root_ << filter_ << recursive_
+	     << quint32(dirMap_.size());
+
+	QHash<QString, Dir>::ConstIterator itr;
+	for (itr = dirMap_.begin(); itr != dirMap_.end(); ++itr) {
+		strm << itr.key() << (*itr).mtime_ << (*itr).addFiles_
+		     << (*itr).dirs_ << (*itr).files_;
+	}
+
+	if (!file.commit())
+		return false;
+
+	dirty_ = false;
+	return true;
+}
+
+/**
+ * Prepares for a new scan.
+ * The listings of the current snapshot are kept for reuse if the scan has the
+ * same parameters. Otherwise, the snapshot is discarded.
+ * @param  root       The scanned directory
+ * @param  filter     The string representation of the filter
+ * @param  recursive  Whether the scan is recursive
+ */
+void DirSnapshot::begin(const QString& root, const QString& filter,
+                        bool recursive)
+{
+	added_.clear();
+	removed_.clear();
+	prevMap_.clear();
+
+	incremental_ = !dirMap_.isEmpty() && (root == root_)
+	               && (filter == filter_) && (recursive == recursive_);
+	if (incremental_)
+		prevMap_.swap(dirMap_);
+
+	dirMap_.clear();
+	root_ = root;
+	filter_ = filter;
+	recursive_ = recursive;
+	dirty_ = true;
+}
+
+/**
+ * Completes a scan.
+ * If the scan completed, the files of directories that were not scanned
+ * again (i.e., they were removed) are added to the list of removed files.
+ * Otherwise, the listings of the previous scan are restored.
+ * @param  completed  true if the scan completed, false if it was stopped
+ */
+void DirSnapshot::end(bool completed)
+{
+	if (!completed) {
+		dirMap_.swap(prevMap_);
+		if (!incremental_)
+			root_.clear();
+
+		added_.clear();
+		removed_.clear();
+		incremental_ = false;
+	}
+	else if (incremental_) {
+		QHash<QString, Dir>::ConstIterator itr;
+		for (itr = prevMap_.begin(); itr != prevMap_.end(); ++itr) {
+			if (dirMap_.contains(itr.key()))
+				continue;
+
+			foreach (const QString& name, (*itr).files_)
+				removed_.append(itr.key() + name);
+		}
+
+		added_.sort();
+		removed_.sort();
+	}
+
+	prevMap_.clear();
+}
+
+/**
+ * Looks up the listing of a directory in the previous scan.
+ * May be called concurrently by scanning threads.
+ * @param  path  The path of the directory
+ * @return The listing, or NULL if the directory was not scanned before
+ */
+const DirSnapshot::Dir* DirSnapshot::previous(const QString& path) const
+{
+	QHash<QString, Dir>::ConstIterator itr = prevMap_.find(path);
+	if (itr == prevMap_.end())
+		return NULL;
+
+	return &(*itr);
+}
+
+/**
+ * Stores the listing of a directory found by the current scan.
+ * Files that were added to or removed from the directory since the previous
+ * scan are recorded.
+ * May be called concurrently by scanning threads.
+ * @param  path  The path of the directory
+ * @param  dir   The listing
+ */
+void DirSnapshot::update(const QString& path, const Dir& dir)
+{
+	QMutexLocker locker(&lock_);
+	dirMap_.insert(path, dir);
+
+	if (!incremental_)
+		return;
+
+	const Dir* prev = previous(path);
+	if (prev == NULL) {
+		foreach (const QString& name, dir.files_)
+			added_.append(path + name);
+		return;
+	}
+
+	// Listings that were reused cannot have changed.
+	if (prev->files_ == dir.files_)
+		return;
+
+	QSet<QString> oldFiles = prev->files_.toSet();
+	QSet<QString> newFiles = dir.files_.toSet();
+	foreach (const QString& name, dir.files_) {
+		if (!oldFiles.contains(name))
+			added_.append(path + name);
+	}
+
+	foreach (const QString& name, prev->files_) {
+		if (!newFiles.contains(name))
+			removed_.append(path + name);
+	}
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,176 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_DIRSNAPSHOT_H__
+#define __CORE_DIRSNAPSHOT_H__
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Remembers the result of a directory scan between sessions.
+ * For each scanned directory, the snapshot holds the modification time of
+ * the directory, the sub-directories that were scanned and the files that
+ * matched the filter. Adding or removing an entry changes the modification
+ * time of its directory, so a later scan with the same parameters can reuse
+ * the listing of every directory whose time did not change, and only read
+ * the others. The differences between the old and new listings of these
+ * directories are collected as lists of added and removed files.
+ * The snapshot is stored in a binary file. A snapshot describes a single
+ * scan, identified by the scanned directory, the filter and the
+ * recursion flag, and is discarded when a scan with different parameters
+ * begins.
+ * @author Elad Lahav
+ */
+class DirSnapshot
+{
+public:
+	DirSnapshot();
+	~DirSnapshot();
+
+	/**
+	 * The listing of a single directory.
+	 */
+	struct Dir
+	{
+		/**
+		 * The modification time of the directory, in nanoseconds since the
+		 * epoch, or -1 if the listing needs to be read again regardless.
+		 */
+		qint64 mtime_;
+
+		/**
+		 * Whether files in the directory were matched against the filter.
+		 */
+		bool addFiles_;
+
+		/**
+		 * The names of the scanned sub-directories.
+		 */
+		QStringList dirs_;
+
+		/**
+		 * The names of the files that matched the filter.
+		 */
+		QStringList files_;
+	};
+
+	bool load(const QString& path);
+	bool save();
+	void begin(const QString&, const QString&, bool);
+	void end(bool);
+	const Dir* previous(const QString&) const;
+	void update(const QString&, const Dir&);
+
+	/**
+	 * @return The directory scanned by the last scan
+	 */
+	const QString& root() const { return root_; }
+
+	/**
+	 * @return The string representation of the filter used by the last scan
+	 */
+	const QString& filter() const { return filter_; }
+
+	/**
+	 * @return Whether the current scan uses the listings of a previous one
+	 */
+	bool isIncremental() const { return incremental_; }
+
+	/**
+	 * @return Files found by the last scan that were missing from the
+	 *         previous one
+	 */
+	const QStringList& added() const { return added_; }
+
+	/**
+	 * @return Files found by the previous scan that were missing from the
+	 *         last one
+	 */
+	const QStringList& removed() const { return removed_; }
+
+	/**
+	 * @return The paths of the directories scanned by the last scan, each
+	 *         with a trailing separator
+	 */
+	QStringList dirs() const { return dirMap_.keys(); }
+
+private:
+	/**
+	 * The file holding the snapshot.
+	 */
+	QString path_;
+
+	/**
+	 * The scanned directory.
+	 */
+	QString root_;
+
+	/**
+	 * The string representation of the filter used by the scan.
+	 */
+	QString filter_;
+
+	/**
+	 * Whether the scan was recursive.
+	 */
+	bool recursive_;
+
+	/**
+	 * Directory listings, indexed by the path of the directory.
+	 */
+	QHash<QString, Dir> dirMap_;
+
+	/**
+	 * The listings of the previous scan, while a scan is in progress.
+	 */
+	QHash<QString, Dir> prevMap_;
+
+	/**
+	 * Serialises updates made by concurrent scanning threads.
+	 */
+	QMutex lock_;
+
+	/**
+	 * Whether the current scan uses the listings of a previous one.
+	 */
+	bool incremental_;
+
+	/**
+	 * Whether the snapshot changed since it was loaded or saved.
+	 */
+	bool dirty_;
+
+	QStringList added_;
+	QStringList removed_;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_DIRSNAPSHOT_H__
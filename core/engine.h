@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include <QWidget>
+#include <QStringList>
 #include "globals.h"
 
 namespace KScope
@@ -103,6 +104,66 @@ public:
 	 */
 	virtual QList<Location::Fields> queryFields(Query::Type type) const = 0;
 
+	/**
+	 * Suggests symbol names for a partially-typed pattern.
+	 * Must return quickly, as it is called on every keystroke.
+	 * The default implementation provides no suggestions.
+	 * @param  text        The partial pattern
+	 * @param  maxResults  The maximal number of suggestions
+	 * @return Suggested names, best match first
+	 */
+	virtual QStringList complete(const QString& text, int maxResults) const {
+		(void)text;
+		(void)maxResults;
+		return QStringList();
+	}
+
+	/**
+	 * Saves the current version of the database, so that it can still be
+	 * queried after the database is rebuilt.
+	 * The default implementation does not support snapshots.
+	 * @param  name  The name of the snapshot
+	 * @return true if successful, false otherwise
+	 * @throw  Exception if the name is not valid for the engine
+	 */
+	virtual bool createSnapshot(const QString& name) {
+		(void)name;
+		return false;
+	}
+
+	/**
+	 * @return The names of existing snapshots, most recent first
+	 */
+	virtual QStringList snapshots() const { return QStringList(); }
+
+	/**
+	 * Creates an engine for querying a snapshot.
+	 * The returned object is owned by the caller. It does not need to outlive
+	 * the queries started through it.
+	 * @param  name  The name of the snapshot
+	 * @return The new engine, or NULL if the snapshot cannot be queried
+	 */
+	virtual Engine* openSnapshot(const QString& name) const {
+		(void)name;
+		return NULL;
+	}
+
+	/**
+	 * Determines whether a query can be answered now.
+	 * Some queries are answered from indices that are derived from the
+	 * database in the background, after it is opened or built. Such queries
+	 * fail until the indices are ready, which is signalled by
+	 * indicesChanged().
+	 * The default implementation has no such indices.
+	 * @param  query  The query to check
+	 * @return true if the query can be started, false if it needs to wait for
+	 *         indicesChanged()
+	 */
+	virtual bool canQuery(const Query& query) const {
+		(void)query;
+		return true;
+	}
+
 	/**
 	 * Abstract base class for a controllable object.
 	 * This allows an engine operation to be stopped.
@@ -160,6 +221,14 @@ public:
 		 */
 		virtual void onAborted() = 0;
 
+		/**
+		 * Called when an engine operation is killed for exceeding its
+		 * deadline, or for making no progress.
+		 * Any results produced before that are delivered through onDataReady()
+		 * first. By default, this is treated as an abnormal termination.
+		 */
+		virtual void onTimedOut() { onAborted(); }
+
 		/**
 		 * Called when an engine operation makes progress.
 		 * @param  text  A message describing the kind of progress made
@@ -188,6 +257,13 @@ public slots:
 	 * @param  conn    Used for communication with the ongoing operation
 	 */
 	virtual void build(Connection*) const = 0;
+
+signals:
+	/**
+	 * Emitted when a background pass that derives indices from the database
+	 * ends, whether or not the indices were replaced.
+	 */
+	void indicesChanged();
 };
 
 /**
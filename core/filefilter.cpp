@@ -0,0 +1,401 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QVarLengthArray>
+#include <algorithm>
+#include "filefilter.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Determines whether the given path is matched by the filter.
+ * The first rule whose pattern matches the path name is used to determine
+ * whether the path is accepted (including rule) or rejected (excluding rule).
+ * @param  path           The path name to check
+ * @param  noMatchResult  The value to return in case no rule matches the
+ *                        path
+ * @return true if the path is accepted by the filter, false otherwise
+ */
+bool FileFilter::match(const QString& path, bool noMatchResult) const
+{
+	// The index of the first matching rule found so far.
+	int best = ruleList_.size();
+
+	// Rules without wild cards.
+	QHash<QString, int>::ConstIterator exactItr = exactMap_.find(path);
+	if (exactItr != exactMap_.end())
+		best = *exactItr;
+
+	// Extension rules.
+	int dot = path.lastIndexOf('.');
+	if (dot >= 0) {
+		QHash< QString, QList<Suffix> >::ConstIterator suffixItr
+			= suffixMap_.find(path.mid(dot + 1));
+		if (suffixItr != suffixMap_.end()) {
+			QList<Suffix>::ConstIterator itr;
+			for (itr = (*suffixItr).begin(); itr != (*suffixItr).end(); ++itr) {
+				if ((*itr).rule_ >= best)
+					break;
+
+				if (path.endsWith((*itr).text_)) {
+					best = (*itr).rule_;
+					break;
+				}
+			}
+		}
+	}
+
+	// Prefix rules.
+	if (!trie_.isEmpty()) {
+		int node = 0;
+		for (int i = 0; node >= 0; i++) {
+			int rule = trie_[node].rule_;
+			if ((rule >= 0) && (rule < best))
+				best = rule;
+
+			if (i == path.size())
+				break;
+
+			node = trie_[node].children_.value(path[i], -1);
+		}
+	}
+
+	// All other rules.
+	best = matchPattern(path, best);
+
+	if (best == ruleList_.size())
+		return noMatchResult;
+
+	return ruleList_[best].type_ == Rule::Include;
+}
+
+/**
+ * Creates a semicolon delimited representation of the filter.
+ * @return The filter as a string
+ */
+QString FileFilter::toString() const
+{
+	QString result;
+	QList<Rule>::ConstIterator itr;
+
+	for (itr = ruleList_.begin(); itr != ruleList_.end(); ++itr) {
+		if ((*itr).type_ == Rule::Exclude)
+			result += "-";
+		result += (*itr).pattern_ + ";";
+	}
+
+	return result;
+}
+
+/**
+ * @param  c  A character
+ * @return true if the set matches the character, false otherwise
+ */
+bool FileFilter::CharSet::contains(QChar c) const
+{
+	QVector< QPair<QChar, QChar> >::ConstIterator itr;
+	for (itr = ranges_.begin(); itr != ranges_.end(); ++itr) {
+		if ((c >= (*itr).first) && (c <= (*itr).second))
+			return !negate_;
+	}
+
+	return negate_;
+}
+
+/**
+ * Converts a semicolon-delimited string into a list of rules.
+ * @param  filter  The filter string to parse
+ */
+void FileFilter::parse(const QString& filter)
+{
+	// Split the filter string to get a list of patterns.
+	QStringList patterns = filter.split(';', QString::SkipEmptyParts);
+
+	// Create a rule for each pattern.
+	QStringList::Iterator itr;
+	for (itr = patterns.begin(); itr != patterns.end(); ++itr)
+		ruleList_.append(Rule(*itr));
+}
+
+/**
+ * Builds the matcher out of the list of rules.
+ */
+void FileFilter::compile()
+{
+	for (int i = 0; i < ruleList_.size(); i++) {
+		const QString& pattern = ruleList_[i].pattern_;
+
+		// A pattern without wild cards matches a single path.
+		// Only the first rule for a path can ever match.
+		if (!hasWildCards(pattern)) {
+			if (!exactMap_.contains(pattern))
+				exactMap_.insert(pattern, i);
+			continue;
+		}
+
+		// Extension rules: a star followed by a fixed string with a dot.
+		QString tail = pattern.mid(1);
+		if (pattern.startsWith('*') && !hasWildCards(tail)
+		    && tail.contains('.')) {
+			Suffix suffix;
+			suffix.text_ = tail;
+			suffix.rule_ = i;
+			suffixMap_[tail.mid(tail.lastIndexOf('.') + 1)].append(suffix);
+			continue;
+		}
+
+		// Prefix rules: a fixed string followed by a star.
+		QString head = pattern.left(pattern.size() - 1);
+		if (pattern.endsWith('*') && !hasWildCards(head)) {
+			addPrefix(head, i);
+			continue;
+		}
+
+		addPattern(pattern, i);
+	}
+}
+
+/**
+ * Adds a prefix rule to the trie.
+ * @param  prefix  The fixed part of the rule's pattern
+ * @param  rule    The index of the rule
+ */
+void FileFilter::addPrefix(const QString& prefix, int rule)
+{
+	if (trie_.isEmpty())
+		trie_.append(TrieNode());
+
+	int node = 0;
+	for (int i = 0; i < prefix.size(); i++) {
+		int child = trie_[node].children_.value(prefix[i], -1);
+		if (child < 0) {
+			trie_.append(TrieNode());
+			child = trie_.size() - 1;
+			trie_[node].children_.insert(prefix[i], child);
+		}
+
+		node = child;
+	}
+
+	if (trie_[node].rule_ < 0)
+		trie_[node].rule_ = rule;
+}
+
+/**
+ * Adds a rule to the combined automaton.
+ * Patterns have the semantics of QRegExp::Wildcard, which the automaton
+ * replaces: a set is negated by a leading '^' (a '!' is a member), and a
+ * pattern with an unterminated set is invalid, and so never matches.
+ * @param  pattern  The rule's pattern
+ * @param  rule     The index of the rule
+ */
+void FileFilter::addPattern(const QString& pattern, int rule)
+{
+	int first = tokenList_.size();
+	startList_.append(qMakePair(first, rule));
+
+	for (int i = 0; i < pattern.size(); i++) {
+		Token token;
+		token.char_ = pattern[i];
+		token.index_ = -1;
+
+		switch (pattern[i].unicode()) {
+		case '*':
+			// Consecutive stars are equivalent to a single one.
+			if ((tokenList_.size() > first)
+			    && (tokenList_.last().type_ == Token::Star)) {
+				continue;
+			}
+
+			token.type_ = Token::Star;
+			break;
+
+		case '?':
+			token.type_ = Token::Any;
+			break;
+
+		case '[':
+			{
+				CharSet set;
+				set.negate_ = false;
+
+				int j = i + 1;
+				if ((j < pattern.size()) && (pattern[j] == '^')) {
+					set.negate_ = true;
+					j++;
+				}
+
+				// A closing bracket at the beginning of the set is a member.
+				int start = j;
+				while ((j < pattern.size())
+				       && ((pattern[j] != ']') || (j == start))) {
+					QChar low = pattern[j];
+					QChar high = low;
+					if ((j + 2 < pattern.size()) && (pattern[j + 1] == '-')
+					    && (pattern[j + 2] != ']')) {
+						high = pattern[j + 2];
+						j += 2;
+					}
+
+					set.ranges_.append(qMakePair(low, high));
+					j++;
+				}
+
+				// A pattern with an unterminated set matches nothing.
+				if (j == pattern.size()) {
+					tokenList_.resize(first);
+					startList_.removeLast();
+					return;
+				}
+
+				setList_.append(set);
+				token.type_ = Token::Set;
+				token.index_ = setList_.size() - 1;
+				i = j;
+			}
+			break;
+
+		default:
+			token.type_ = Token::Char;
+		}
+
+		tokenList_.append(token);
+	}
+
+	Token accept;
+	accept.type_ = Token::Accept;
+	accept.index_ = rule;
+	tokenList_.append(accept);
+}
+
+/**
+ * Runs the combined automaton on a path.
+ * The automaton is a non-deterministic one, with a state for each token, and
+ * is simulated by keeping the set of active states. Only rules preceding the
+ * first match found by the other methods are started.
+ * @param  path  The path name to check
+ * @param  best  The index of the first matching rule found so far
+ * @return The index of the first matching rule
+ */
+int FileFilter::matchPattern(const QString& path, int best) const
+{
+	int count = tokenList_.size();
+	if (count == 0)
+		return best;
+
+	QVarLengthArray<bool, 256> stateBuf1(count), stateBuf2(count);
+	bool* cur = stateBuf1.data();
+	bool* next = stateBuf2.data();
+	std::fill(cur, cur + count, false);
+
+	// Activate the first state of each rule that can still make a
+	// difference.
+	bool active = false;
+	QVector< QPair<int, int> >::ConstIterator itr;
+	for (itr = startList_.begin(); itr != startList_.end(); ++itr) {
+		if ((*itr).second >= best)
+			break;
+
+		cur[(*itr).first] = true;
+		active = true;
+	}
+
+	// A star can match an empty string, so the token following an active star
+	// is active as well.
+	for (int k = 0; k < count; k++) {
+		if (cur[k] && (tokenList_[k].type_ == Token::Star))
+			cur[k + 1] = true;
+	}
+
+	// Advance all rules on each character.
+	for (int i = 0; (i < path.size()) && active; i++) {
+		QChar c = path[i];
+
+		std::fill(next, next + count, false);
+		for (int k = 0; k < count; k++) {
+			if (!cur[k])
+				continue;
+
+			const Token& token = tokenList_[k];
+			switch (token.type_) {
+			case Token::Char:
+				if (c == token.char_)
+					next[k + 1] = true;
+				break;
+
+			case Token::Any:
+				next[k + 1] = true;
+				break;
+
+			case Token::Set:
+				if (setList_[token.index_].contains(c))
+					next[k + 1] = true;
+				break;
+
+			case Token::Star:
+				next[k] = true;
+				break;
+
+			case Token::Accept:
+				break;
+			}
+		}
+
+		active = false;
+		for (int k = 0; k < count; k++) {
+			if (next[k]) {
+				active = true;
+				if (tokenList_[k].type_ == Token::Star)
+					next[k + 1] = true;
+			}
+		}
+
+		std::swap(cur, next);
+	}
+
+	// Find the first rule whose pattern ended with the path.
+	for (int k = 0; k < count; k++) {
+		if (cur[k] && (tokenList_[k].type_ == Token::Accept)
+		    && (tokenList_[k].index_ < best)) {
+			best = tokenList_[k].index_;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * @param  pattern  A simplified regular expression
+ * @return true if the pattern contains wild cards, false if it matches a
+ *         fixed string
+ */
+bool FileFilter::hasWildCards(const QString& pattern)
+{
+	return pattern.contains('*') || pattern.contains('?')
+	       || pattern.contains('[');
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -22,6 +22,10 @@
 #define __CORE_FILEFILTER_H__
 
 #include <QList>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+#include <QStringList>
 
 namespace KScope
 {
@@ -40,6 +44,16 @@ namespace Core
  * - Each rule is given as a simplified (shell-style) regular expression
  * - By default a rule is classified as an inclusion one
  * - To create an exclusion rule, prefix the expression with a minus sign (-)
+ * Rather than trying each rule in turn, the rule list is compiled into a
+ * matcher when the filter is created. Rules without wild cards are kept in a
+ * hash of full paths, extension rules (e.g., "*.cpp") in a hash keyed by the
+ * extension, and prefix rules (e.g., "/usr/include/*") in a character trie.
+ * All other rules are combined into a single automaton, which advances the
+ * patterns of all rules in one pass over the path. Each of these yields the
+ * lowest-numbered rule it matches, and the lowest of these decides the
+ * result, which preserves the first-match semantics of the rule list.
+ * Matching does not modify the filter, and is therefore safe to perform
+ * concurrently from multiple threads.
  * @author Elad Lahav
  */
 class FileFilter
@@ -58,45 +72,16 @@ public:
 	 */
 	FileFilter(const QString& filter) {
 		parse(filter);
+		compile();
 	}
 
-	/**
-	 * Determines whether the given path is matched by the filter.
-	 * Iterates over the list of rules. The first rule whose pattern matches
-	 * the path name is used to determine whether the path is accepted
-	 * (including rule) or rejected (excluding rule).
-	 * @param  path           The path name to check
-	 * @param  noMatchResult  The value to return in case no rule matches the
-	 *                        path
-	 * @return true if the path is accepted by the filter, false otherwise
-	 */
-	bool match(const QString& path, bool noMatchResult) const {
-		QList<Rule>::ConstIterator itr;
-
-		for (itr = ruleList_.begin(); itr != ruleList_.end(); ++itr) {
-			if ((*itr).exp_.exactMatch(path))
-				return (((*itr).type_ == Rule::Include) ? true : false);
-		}
-
-		return noMatchResult;
-	}
+	bool match(const QString&, bool) const;
+	QString toString() const;
 
 	/**
-	 * Creates a semicolon delimited representation of the filter.
-	 * @return The filter as a string
+	 * @return true if the filter has no rules, false otherwise
 	 */
-	QString toString() const {
-		QString result;
-		QList<Rule>::ConstIterator itr;
-
-		for (itr = ruleList_.begin(); itr != ruleList_.end(); ++itr) {
-			if ((*itr).type_ == Rule::Exclude)
-				result += "-";
-			result += (*itr).exp_.pattern() + ";";
-		}
-
-		return result;
-	}
+	bool isEmpty() const { return ruleList_.isEmpty(); }
 
 private:
 	/**
@@ -107,19 +92,17 @@ private:
 
 		/**
 		 * Struct constructor.
-		 * Creates a simplified regular expression out of the given pattern,
-		 * and determines whether it is an inclusion or exclusion pattern based
+		 * Determines whether the rule is an inclusion or exclusion rule based
 		 * on the existence of a "-" prefix.
 		 * @param  pattern  Simplified regular expression pattern
 		 */
 		Rule(const QString& pattern) {
-			exp_.setPatternSyntax(QRegExp::Wildcard);
 			if (pattern.startsWith("-")) {
-				exp_.setPattern(pattern.mid(1));
+				pattern_ = pattern.mid(1);
 				type_ = Exclude;
 			}
 			else {
-				exp_.setPattern(pattern);
+				pattern_ = pattern;
 				type_ = Include;
 			}
 		}
@@ -127,7 +110,7 @@ private:
 		/**
 		 * The simplified regular expression to match against.
 		 */
-		QRegExp exp_;
+		QString pattern_;
 
 		/**
 		 * Whether this rule is for including or excluding files.
@@ -135,24 +118,132 @@ private:
 		Type type_;
 	};
 
+	/**
+	 * A rule matching paths ending with a fixed string that includes a dot.
+	 */
+	struct Suffix {
+		/**
+		 * The fixed string.
+		 */
+		QString text_;
+
+		/**
+		 * The index of the rule.
+		 */
+		int rule_;
+	};
+
+	/**
+	 * A node in the trie of prefix rules.
+	 */
+	struct TrieNode {
+		TrieNode() : rule_(-1) {}
+
+		/**
+		 * Maps the next character of a prefix to the index of a child node.
+		 */
+		QHash<QChar, int> children_;
+
+		/**
+		 * The index of the first rule whose prefix ends at this node, -1 if
+		 * none.
+		 */
+		int rule_;
+	};
+
+	/**
+	 * A single position in the combined automaton.
+	 */
+	struct Token {
+		enum Type {
+			/** Matches a single character. */
+			Char,
+			/** Matches any character ("?"). */
+			Any,
+			/** Matches any string, including an empty one ("*"). */
+			Star,
+			/** Matches a character in a set ("[...]"). */
+			Set,
+			/** Marks the end of a rule's pattern. */
+			Accept
+		};
+
+		Type type_;
+
+		/**
+		 * The character matched by a Char token.
+		 */
+		QChar char_;
+
+		/**
+		 * For a Set token, the index of the set in setList_. For an Accept
+		 * token, the index of the rule.
+		 */
+		int index_;
+	};
+
+	/**
+	 * The characters matched by a Set token.
+	 */
+	struct CharSet {
+		/**
+		 * Whether the set matches characters not in the ranges.
+		 */
+		bool negate_;
+
+		/**
+		 * Inclusive character ranges.
+		 */
+		QVector< QPair<QChar, QChar> > ranges_;
+
+		bool contains(QChar) const;
+	};
+
 	/**
 	 * The filter, represented as an ordered list of rules.
 	 */
 	QList<Rule> ruleList_;
 
 	/**
-	 * Converts a semicolon-delimited string into a list of rules.
-	 * @param  filter  The filter string to parse
+	 * Maps paths to rules without wild cards.
 	 */
-	void parse(const QString& filter) {
-		// Split the filter string to get a list of patterns.
-		QStringList patterns = filter.split(';', QString::SkipEmptyParts);
-
-		// Create a rule for each pattern.
-		QStringList::Iterator itr;
-		for (itr = patterns.begin(); itr != patterns.end(); ++itr)
-			ruleList_.append(Rule(*itr));
-	}
+	QHash<QString, int> exactMap_;
+
+	/**
+	 * Maps the text following the last dot in a path to suffix rules, sorted
+	 * by rule index.
+	 */
+	QHash< QString, QList<Suffix> > suffixMap_;
+
+	/**
+	 * The trie of prefix rules, rooted at the first node.
+	 */
+	QVector<TrieNode> trie_;
+
+	/**
+	 * The patterns of all other rules, one after the other, each terminated
+	 * by an Accept token.
+	 */
+	QVector<Token> tokenList_;
+
+	/**
+	 * The first token and the index of each rule in the automaton, sorted by
+	 * rule index.
+	 */
+	QVector< QPair<int, int> > startList_;
+
+	/**
+	 * Character sets used by Set tokens.
+	 */
+	QVector<CharSet> setList_;
+
+	void parse(const QString&);
+	void compile();
+	void addPrefix(const QString&, int);
+	void addPattern(const QString&, int);
+	int matchPattern(const QString&, int) const;
+
+	static bool hasWildCards(const QString&);
 };
 
 }
@@ -18,23 +18,82 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
-#include <QApplication>
+#include <QFile>
+#include <QTimer>
+#include <QDateTime>
+#include <QRunnable>
+#include <QThread>
 #include <QDebug>
 #include "filescanner.h"
 
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#endif
+
 namespace KScope
 {
 
 namespace Core
 {
 
+/**
+ * Scans directories in a pool thread.
+ * @author Elad Lahav
+ */
+class FileScanner::Worker : public QRunnable
+{
+public:
+	/**
+	 * Class constructor.
+	 * @param  scanner  The scanner object holding the shared state
+	 * @param  index    The index of the worker's queue
+	 */
+	Worker(FileScanner& scanner, int index)
+		: QRunnable(), scanner_(scanner), index_(index) {}
+
+	/**
+	 * Scans directories until none are left, or the scan is stopped.
+	 */
+	void run() {
+		QStringList batch;
+		Task task;
+
+		while (scanner_.nextTask(index_, task)) {
+			scanner_.scanDir(task, index_, batch);
+
+			// Wake up the idle workers if this was the last directory, so
+			// that they can exit.
+			if (!scanner_.pending_.deref()) {
+				QMutexLocker locker(&scanner_.idleLock_);
+				scanner_.idleCond_.wakeAll();
+			}
+
+			if (batch.size() >= BatchSize)
+				scanner_.post(batch);
+		}
+
+		scanner_.post(batch);
+		scanner_.running_.deref();
+	}
+
+private:
+	FileScanner& scanner_;
+	int index_;
+};
+
 /**
  * Class constructor.
  * @param  parent  Owner object
  */
 FileScanner::FileScanner(QObject* parent) : QObject(parent),
-                                            followSymLinks_(false)
+                                            followSymLinks_(false),
+                                            snapshot_(NULL), racyTime_(0),
+                                            completed_(false)
 {
+	connect(&timer_, SIGNAL(timeout()), this, SLOT(collect()));
 }
 
 /**
@@ -42,22 +101,35 @@ FileScanner::FileScanner(QObject* parent) : QObject(parent),
  */
 FileScanner::~FileScanner()
 {
+	stop();
+	pool_.waitForDone();
+	qDeleteAll(queueList_);
 }
 
 /**
  * Starts a scan on a directory, using the given filter.
+ * The scan runs in the background: matched files are reported through
+ * filesFound(), and finished() is emitted once the scan ends.
  * @param  dir        The directory to scan
  * @param  filter     The filter to use
  * @param  recursive  true for recursive scan, false otherwise
- * @return true if successful, false if the scan was aborted
+ * @return true if the scan was started, false if another scan is in progress
  */
-bool FileScanner::scan(const QDir& dir, const FileFilter& filter,
-	                   bool recursive)
+bool FileScanner::start(const QDir& dir, const FileFilter& filter,
+                        bool recursive)
 {
-	scanned_ = 0;
+	if (isRunning())
+		return false;
+
 	fileList_.clear();
+	results_.clear();
+	visitedDirs_.clear();
+	visitedPaths_.clear();
 	filter_ = filter;
-	stop_ = false;
+	recursive_ = recursive;
+	completed_ = false;
+	stop_.storeRelease(0);
+	scanned_.storeRelease(0);
 
 	// In a recursive scan, add only files under directories matching the filter
 	// (starting with this one).
@@ -66,98 +138,410 @@ bool FileScanner::scan(const QDir& dir, const FileFilter& filter,
 	if (!path.endsWith(QDir::separator()))
 		path += QDir::separator();
 
-	bool addFiles = recursive ? filter_.match(path, true) : true;
-	qDebug() << "Scanning" << path << recursive << addFiles;
-	return scan(dir, recursive, addFiles);
+	Task root;
+	root.path_ = path;
+	root.addFiles_ = recursive ? filter_.match(path, true) : true;
+	qDebug() << "Scanning" << path << recursive << root.addFiles_;
+
+	// Directories modified from a second before the scan onwards are not
+	// trusted to keep their listing in the snapshot.
+	if (snapshot_ != NULL) {
+		snapshot_->begin(path, filter_.toString(), recursive);
+		racyTime_ = (QDateTime::currentMSecsSinceEpoch() - 1000) * 1000000;
+	}
+
+	// Create a queue for each worker, and put the root directory in the
+	// first.
+	int workers = recursive ? qMax(QThread::idealThreadCount(), 1) : 1;
+	pool_.setMaxThreadCount(workers);
+	qDeleteAll(queueList_);
+	queueList_.clear();
+	for (int i = 0; i < workers; i++)
+		queueList_.append(new Queue());
+
+	pending_.storeRelease(0);
+	push(0, root);
+
+	// Start the workers.
+	running_.storeRelease(workers);
+	for (int i = 0; i < workers; i++)
+		pool_.start(new Worker(*this, i));
+
+	// Collect results periodically until all workers exit.
+	timer_.start(CollectInterval);
+	return true;
+}
+
+/**
+ * Adds a directory to a worker's queue.
+ * Called by the worker that found the directory, or by start() for the root
+ * directory.
+ * @param  index  The index of the queue
+ * @param  task   Describes the directory
+ */
+void FileScanner::push(int index, const Task& task)
+{
+	pending_.ref();
+
+	Queue* queue = queueList_[index];
+	queue->lock_.lock();
+	queue->tasks_.append(task);
+	queue->lock_.unlock();
+
+	QMutexLocker locker(&idleLock_);
+	idleCond_.wakeOne();
+}
+
+/**
+ * Gets the next directory to scan.
+ * Takes the most recently queued directory from the worker's own queue. If
+ * that queue is empty, steals the oldest directory from another queue. If
+ * all queues are empty, waits until either a directory is queued or the scan
+ * completes.
+ * @param  index  The index of the worker's queue
+ * @param  task   Holds the directory, on success
+ * @return true if a directory was found, false if the worker should exit
+ */
+bool FileScanner::nextTask(int index, Task& task)
+{
+	int count = queueList_.size();
+
+	while (stop_.loadAcquire() == 0) {
+		for (int i = 0; i < count; i++) {
+			Queue* queue = queueList_[(index + i) % count];
+			QMutexLocker locker(&queue->lock_);
+			if (!queue->tasks_.isEmpty()) {
+				task = (i == 0) ? queue->tasks_.takeLast()
+				                : queue->tasks_.takeFirst();
+				return true;
+			}
+		}
+
+		// No work is available.
+		// The timeout guards against a wake-up lost between checking the
+		// queues and starting to wait.
+		QMutexLocker locker(&idleLock_);
+		if (pending_.loadAcquire() == 0)
+			return false;
+
+		idleCond_.wait(&idleLock_, 10);
+	}
+
+	return false;
 }
 
 /**
- * Implements a directory scan.
- * @param dir        The directory to scan
- * @param recursive  true for recursive scan, false otherwise
- * @return true if successful, false if the scan was aborted
+ * Scans a single directory.
+ * Runs in a worker thread.
+ * @param  task    Describes the directory
+ * @param  index   The index of the worker's queue
+ * @param  batch   Collects matched files
  */
-bool FileScanner::scan(const QDir& dir, bool recursive, bool addFiles)
+void FileScanner::scanDir(const Task& task, int index, QStringList& batch)
 {
+#ifdef Q_OS_UNIX
+	QByteArray encodedPath = QFile::encodeName(task.path_);
+
+	// The directory's own attributes are only needed for detecting loops and
+	// for comparing it with the snapshot.
+	// The path is resolved, so that a linked directory is identified by its
+	// target.
+	struct stat st;
+	if ((followSymLinks_ || (snapshot_ != NULL))
+	    && (stat(encodedPath.constData(), &st) != 0)) {
+		return;
+	}
+
+	// Do not scan the same directory twice, if following symbolic links.
+	if (followSymLinks_) {
+		DirId id(st.st_dev, st.st_ino);
+		QMutexLocker locker(&visitedLock_);
+		if (visitedDirs_.contains(id))
+			return;
+
+		visitedDirs_.insert(id);
+	}
+
+	// Use the previous listing if the directory did not change.
+	qint64 mtime = -1;
+	if (snapshot_ != NULL) {
+#ifdef Q_OS_MAC
+		mtime = qint64(st.st_mtimespec.tv_sec) * 1000000000
+		        + st.st_mtimespec.tv_nsec;
+#else
+		mtime = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+		if (reuseDir(task, mtime, index, batch))
+			return;
+	}
+
+	DIR* dir = opendir(encodedPath.constData());
+	if (dir == NULL)
+		return;
+
+	DirSnapshot::Dir record;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (stop_.loadAcquire())
+			break;
+
+		// Skip hidden entries, as well as "." and "..".
+		if (entry->d_name[0] == '.')
+			continue;
+
+		// Get the type of the entry from the directory, if possible.
+		// Otherwise, stat the entry (without following links).
+		int type = DT_UNKNOWN;
+#ifdef _DIRENT_HAVE_D_TYPE
+		type = entry->d_type;
+#endif
+		struct stat entryStat;
+		if (type == DT_UNKNOWN) {
+			if (fstatat(dirfd(dir), entry->d_name, &entryStat,
+			            AT_SYMLINK_NOFOLLOW) != 0) {
+				continue;
+			}
+
+			type = IFTODT(entryStat.st_mode);
+		}
+
+		// Symbolic links are classified by their targets. Broken links are
+		// skipped.
+		bool isSymLink = (type == DT_LNK);
+		if (isSymLink) {
+			if (fstatat(dirfd(dir), entry->d_name, &entryStat, 0) != 0)
+				continue;
+
+			type = IFTODT(entryStat.st_mode);
+		}
+
+		// Skip special files.
+		if ((type != DT_DIR) && (type != DT_REG))
+			continue;
+
+		QString name = QFile::decodeName(entry->d_name);
+		QString path = task.path_ + name;
+		if (addEntry(task, index, path, type == DT_DIR, isSymLink, batch)
+		    && (snapshot_ != NULL)) {
+			if (type == DT_DIR)
+				record.dirs_.append(name);
+			else
+				record.files_.append(name);
+		}
+	}
+
+	closedir(dir);
+#else
+	QDir dir(task.path_);
+
+	// Do not scan the same directory twice, if following symbolic links.
+	if (followSymLinks_) {
+		QString canonPath = dir.canonicalPath();
+		QMutexLocker locker(&visitedLock_);
+		if (visitedPaths_.contains(canonPath))
+			return;
+
+		visitedPaths_.insert(canonPath);
+	}
+
+	// Use the previous listing if the directory did not change.
+	qint64 mtime = -1;
+	if (snapshot_ != NULL) {
+		mtime = QFileInfo(task.path_).lastModified().toMSecsSinceEpoch()
+		        * 1000000;
+		if (reuseDir(task, mtime, index, batch))
+			return;
+	}
+
+	DirSnapshot::Dir record;
+
 	// Get a list of all entries in the directory.
 	QFileInfoList infos = dir.entryInfoList(QDir::Files | QDir::Dirs
 	                                        | QDir::NoDotAndDotDot);
 
-	// Mark this directory as visited (if following symbolic links).
-	if (followSymLinks_)
-		visitedDirs_.insert(QDir::toNativeSeparators(dir.absolutePath()));
-
 	// Iterate over the list.
 	QFileInfoList::Iterator itr;
 	for (itr = infos.begin(); itr != infos.end(); ++itr) {
-		// Make sure event processing continues during a long scan.
-		qApp->processEvents();
-		if (stop_)
-			return false;
-
-		// Update and emit progress information.
-		scanned_++;
-		if ((scanned_ & 0xff) == 0) {
-			if (!progressMessage_.isEmpty()) {
-				QString msg = progressMessage_.arg(scanned_)
-				                              .arg(fileList_.size());
-				emit progress(msg);
-			}
-			else {
-				emit progress(scanned_, fileList_.size());
-			}
-		}
+		if (stop_.loadAcquire())
+			return;
 
-		// Get the file's path.
 		QString path = QDir::toNativeSeparators((*itr).filePath());
-		if ((*itr).isDir()) {
-			// Directory: scan recursively, if needed.
-			if (recursive) {
-				// Handle symbolic links.
-				if ((*itr).isSymLink()) {
-					qDebug() << __func__ << (*itr).absoluteFilePath();
-
-					// If symbolic links are followed, make sure we do not
-					// descend into an already-visited directory.
-					if (!followSymLinks_
-						|| visitedDirs_.contains(QDir::toNativeSeparators(
-												(*itr).absoluteFilePath()))) {
-							continue;
-					}
-				}
-
-				// Change directory.
-				QDir childDir(dir);
-				if (!childDir.cd((*itr).fileName()))
-					continue;
-
-				// Add a trailing "/" to directory names, so that the filter can
-				// distinguish those from regular files.
-				if (!path.endsWith(QDir::separator()))
-					path += QDir::separator();
-
-				// Scan recursively.
-				// Filter behaviour for sub-directories:
-				// 1. If an inclusion rule is matched, add files.
-				// 2. If an exclusion rule is matched, do not add files.
-				// 3. If no rule is matched, inherit the behaviour of the
-				//    current directory.
-				if (!scan(childDir, true, filter_.match(path, addFiles)))
-					return false;
-			}
-		}
-		else if (addFiles) {
-			// File: add to the file list if the path matches the filter.
-			// The default match is set to false, so that files not matched by
-			// any rule will not be added.
-			if (filter_.match(path, false))
-				fileList_.append(QDir::toNativeSeparators(path));
+		if (addEntry(task, index, path, (*itr).isDir(), (*itr).isSymLink(),
+		             batch)
+		    && (snapshot_ != NULL)) {
+			if ((*itr).isDir())
+				record.dirs_.append((*itr).fileName());
+			else
+				record.files_.append((*itr).fileName());
 		}
 	}
+#endif
+
+	// Store the new listing.
+	// A directory that changed during the last second may change again
+	// without its modification time changing, so its listing is marked to
+	// be read again by the next scan.
+	if ((snapshot_ != NULL) && !stop_.loadAcquire()) {
+		record.mtime_ = (mtime < racyTime_) ? mtime : -1;
+		record.addFiles_ = task.addFiles_;
+		snapshot_->update(task.path_, record);
+	}
+}
+
+/**
+ * Uses the listing of a directory from the previous scan, if the directory
+ * did not change since.
+ * Runs in a worker thread.
+ * @param  task   Describes the directory
+ * @param  mtime  The current modification time of the directory
+ * @param  index  The index of the worker's queue
+ * @param  batch  Collects matched files
+ * @return true if the previous listing was used, false if the directory needs
+ *         to be read
+ */
+bool FileScanner::reuseDir(const Task& task, qint64 mtime, int index,
+                           QStringList& batch)
+{
+	const DirSnapshot::Dir* prev = snapshot_->previous(task.path_);
+	if ((prev == NULL) || (prev->mtime_ < 0) || (prev->mtime_ != mtime)
+	    || (prev->addFiles_ != task.addFiles_)) {
+		return false;
+	}
+
+	foreach (const QString& name, prev->dirs_) {
+		QString path = task.path_ + name;
+		addEntry(task, index, path, true, false, batch);
+	}
+
+	foreach (const QString& name, prev->files_)
+		batch.append(task.path_ + name);
 
+	scanned_.fetchAndAddRelaxed(prev->files_.size());
+	snapshot_->update(task.path_, *prev);
 	return true;
 }
 
+/**
+ * Handles a single entry in a scanned directory.
+ * Runs in a worker thread.
+ * @param  task       Describes the directory holding the entry
+ * @param  index      The index of the worker's queue
+ * @param  path       The path of the entry
+ * @param  isDir      Whether the entry is a directory (or a link to one)
+ * @param  isSymLink  Whether the entry is a symbolic link
+ * @param  batch      Collects matched files
+ * @return true if the entry is a directory that was queued for scanning, or
+ *         a file that matched the filter, false otherwise
+ */
+bool FileScanner::addEntry(const Task& task, int index, QString& path,
+                           bool isDir, bool isSymLink, QStringList& batch)
+{
+	scanned_.ref();
+
+	if (isDir) {
+		// Directory: scan recursively, if needed.
+		// Symbolic links are only followed if requested, in which case
+		// loops are detected when the directory is scanned.
+		if (!recursive_ || (isSymLink && !followSymLinks_))
+			return false;
+
+		// Add a trailing "/" to directory names, so that the filter can
+		// distinguish those from regular files.
+		if (!path.endsWith(QDir::separator()))
+			path += QDir::separator();
+
+		// Filter behaviour for sub-directories:
+		// 1. If an inclusion rule is matched, add files.
+		// 2. If an exclusion rule is matched, do not add files.
+		// 3. If no rule is matched, inherit the behaviour of the
+		//    current directory.
+		Task child;
+		child.path_ = path;
+		child.addFiles_ = filter_.match(path, task.addFiles_);
+		push(index, child);
+		return true;
+	}
+
+	// File: add to the file list if the path matches the filter.
+	// The default match is set to false, so that files not matched by any
+	// rule will not be added.
+	if (task.addFiles_ && filter_.match(path, false)) {
+		batch.append(path);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Hands matched files over to the GUI thread.
+ * Runs in a worker thread.
+ * @param  batch  The matched files, cleared on return
+ */
+void FileScanner::post(QStringList& batch)
+{
+	if (batch.isEmpty())
+		return;
+
+	QMutexLocker locker(&resultLock_);
+	results_ += batch;
+	batch.clear();
+}
+
+/**
+ * Ends a scan once all workers have exited.
+ */
+void FileScanner::finish()
+{
+	timer_.stop();
+	pool_.waitForDone();
+	qDeleteAll(queueList_);
+	queueList_.clear();
+
+	completed_ = (stop_.loadAcquire() == 0);
+	if (snapshot_ != NULL)
+		snapshot_->end(completed_);
+
+	// Workers finish directories in no particular order.
+	fileList_.sort();
+	emit finished(completed_);
+}
+
+/**
+ * Called periodically in the GUI thread during a scan.
+ * Emits the files matched since the last call, along with progress
+ * information, and ends the scan once all workers exit.
+ */
+void FileScanner::collect()
+{
+	// Workers post their last batch before exiting, so all results are
+	// available once none is running.
+	bool done = (running_.loadAcquire() == 0);
+
+	QStringList files;
+	resultLock_.lock();
+	files.swap(results_);
+	resultLock_.unlock();
+
+	if (!files.isEmpty()) {
+		fileList_ += files;
+		emit filesFound(files);
+	}
+
+	// Update and emit progress information.
+	int scanned = scanned_.loadAcquire();
+	if (!progressMessage_.isEmpty()) {
+		QString msg = progressMessage_.arg(scanned).arg(fileList_.size());
+		emit progress(msg);
+	}
+	else {
+		emit progress(scanned, fileList_.size());
+	}
+
+	if (done)
+		finish();
+}
+
 }
 
 }
@@ -24,7 +24,16 @@
 #include <QObject>
 #include <QDir>
 #include <QSet>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QTimer>
 #include "filefilter.h"
+#include "dirsnapshot.h"
 
 namespace KScope
 {
@@ -39,6 +48,24 @@ namespace Core
  * is possible to set an option for following symbolic links, which somewhat
  * degrades performance (as the scanner needs to keep track of visited
  * directories to avoid loops).
+ * Directories are listed and filtered by a pool of worker threads. Each
+ * worker keeps its own queue of directories to scan: sub-directories found by
+ * a worker are pushed to the back of its queue, and the worker takes its
+ * next directory from the back as well, so that it descends depth-first into
+ * the part of the tree it is already working on. A worker whose queue is
+ * empty steals a directory from the front of another worker's queue, which
+ * holds the directories closest to the root, and thus the largest amount of
+ * remaining work.
+ * On Unix systems directories are read with readdir(), and the type of each
+ * entry is taken from the directory itself, where available, so that only
+ * symbolic links and entries of an unknown type need to be stat'ed.
+ * If a snapshot is attached to the scanner, directories whose modification
+ * time did not change since the snapshot was taken are not read at all: their
+ * listings are taken from the snapshot, which is then updated with the
+ * listings of directories that did change.
+ * Matched files are handed to the GUI thread in batches, which are emitted
+ * through filesFound(), along with progress information. The scan runs in
+ * the background, and reports its completion through finished().
  * @author Elad Lahav
  */
 class FileScanner : public QObject
@@ -49,7 +76,12 @@ public:
 	FileScanner(QObject* parent = NULL);
 	~FileScanner();
 
-	bool scan(const QDir&, const FileFilter&, bool recursive = false);
+	bool start(const QDir&, const FileFilter&, bool recursive = false);
+
+	/**
+	 * @return true while a scan is in progress, false otherwise
+	 */
+	bool isRunning() const { return timer_.isActive(); }
 
 	/**
 	 * Modifies the symbolic-link behaviour
@@ -59,6 +91,15 @@ public:
 		followSymLinks_ = follow;
 	}
 
+	/**
+	 * Attaches a snapshot of a previous scan.
+	 * The snapshot is updated by each scan.
+	 * @param  snapshot  The snapshot, NULL to scan all directories
+	 */
+	void setSnapshot(DirSnapshot* snapshot) {
+		snapshot_ = snapshot;
+	}
+
 	/**
 	 * Changes the type of progress signal emitted to be a formatted message.
 	 * The given string should include a '%1' marker to be replaced by the
@@ -80,25 +121,164 @@ public slots:
 	/**
 	 * Signals the scan process to stop.
 	 */
-	void stop() { stop_ = true; }
+	void stop() { stop_.storeRelease(1); }
 
 signals:
 	void progress(int scanned, int matched);
 	void progress(const QString& msg);
 
+	/**
+	 * Emitted periodically during a scan with the files matched since the
+	 * previous emission.
+	 * @param  files  The new matching files
+	 */
+	void filesFound(const QStringList& files);
+
+	/**
+	 * Emitted when a scan started with start() ends.
+	 * @param  completed  true if all directories were scanned, false if the
+	 *                    scan was stopped
+	 */
+	void finished(bool completed);
+
 private:
+	class Worker;
+
+	/**
+	 * A directory waiting to be scanned.
+	 */
+	struct Task
+	{
+		/**
+		 * The path of the directory, with a trailing separator.
+		 */
+		QString path_;
+
+		/**
+		 * Whether files in the directory should be matched against the
+		 * filter, or skipped.
+		 */
+		bool addFiles_;
+	};
+
+	/**
+	 * The directories waiting to be scanned by a single worker.
+	 */
+	struct Queue
+	{
+		QMutex lock_;
+		QList<Task> tasks_;
+	};
+
+	/**
+	 * The number of matched files a worker collects before handing them
+	 * over.
+	 */
+	static const int BatchSize = 256;
+
+	/**
+	 * The time, in milliseconds, between the collection of results from the
+	 * workers.
+	 */
+	static const int CollectInterval = 50;
+
 	/**
 	 * true to follow symbolic links, false (default) to skip them.
 	 */
 	bool followSymLinks_;
-	int scanned_;
+	bool recursive_;
 	QStringList fileList_;
 	FileFilter filter_;
-	bool stop_;
+	QAtomicInt stop_;
 	QString progressMessage_;
-	QSet<QString> visitedDirs_;
 
-	bool scan(const QDir&, bool, bool);
+	/**
+	 * Listings of a previous scan, NULL if not used.
+	 */
+	DirSnapshot* snapshot_;
+
+	/**
+	 * Directories modified after this time (in nanoseconds since the epoch)
+	 * are read again by the next scan.
+	 */
+	qint64 racyTime_;
+
+	/**
+	 * Runs the workers.
+	 */
+	QThreadPool pool_;
+
+	/**
+	 * A queue per worker.
+	 */
+	QVector<Queue*> queueList_;
+
+	/**
+	 * The number of directories that are either queued or being scanned.
+	 * The scan is complete when this number drops to 0.
+	 */
+	QAtomicInt pending_;
+
+	/**
+	 * The number of workers that have not exited yet.
+	 */
+	QAtomicInt running_;
+
+	/**
+	 * The number of directory entries examined so far.
+	 */
+	QAtomicInt scanned_;
+
+	/**
+	 * Idle workers wait on this condition for new directories.
+	 */
+	QWaitCondition idleCond_;
+	QMutex idleLock_;
+
+	/**
+	 * Matched files not yet collected by the GUI thread.
+	 */
+	QStringList results_;
+	QMutex resultLock_;
+
+	/**
+	 * Identifies a directory by its device and inode numbers.
+	 */
+	typedef QPair<quint64, quint64> DirId;
+
+	/**
+	 * Scanned directories, used to avoid loops when following symbolic
+	 * links.
+	 */
+	QSet<DirId> visitedDirs_;
+
+	/**
+	 * The canonical paths of scanned directories, used instead of
+	 * visitedDirs_ on systems without inode numbers.
+	 */
+	QSet<QString> visitedPaths_;
+	QMutex visitedLock_;
+
+	/**
+	 * Collects results from the workers while they scan.
+	 */
+	QTimer timer_;
+
+	/**
+	 * Whether the last scan ended before it was stopped.
+	 */
+	bool completed_;
+
+	void push(int, const Task&);
+	bool nextTask(int, Task&);
+	void scanDir(const Task&, int, QStringList&);
+	bool reuseDir(const Task&, qint64, int, QStringList&);
+	bool addEntry(const Task&, int, QString&, bool, bool, QStringList&);
+	void post(QStringList&);
+	void finish();
+
+private slots:
+	void collect();
 };
 
 }
@@ -0,0 +1,390 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <cstring>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDebug>
+#include "gitindex.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The size of the fixed part of an index entry, up to and including the
+ * flags field (assuming SHA-1 object names).
+ */
+static const int EntryHeaderSize = 62;
+
+/**
+ * Class constructor.
+ */
+GitIndex::GitIndex()
+{
+}
+
+/**
+ * Class destructor.
+ */
+GitIndex::~GitIndex()
+{
+}
+
+/**
+ * Locates the repository that contains the given path.
+ * Searches the path and its ancestors for a .git directory, or a .git file
+ * pointing to the actual repository (as used by work trees and sub-modules).
+ * The cached file list is discarded if the repository differs from the one
+ * previously opened.
+ * @param  path  A directory inside the work tree
+ * @return true if a repository was found, false otherwise
+ */
+bool GitIndex::open(const QString& path)
+{
+	QDir dir(QDir(path).canonicalPath());
+	if (!dir.exists())
+		return false;
+
+	QString gitDir;
+	do {
+		QFileInfo fi(dir, ".git");
+		if (fi.isDir()) {
+			gitDir = fi.filePath();
+			break;
+		}
+
+		if (fi.isFile()) {
+			// A "gitdir: <path>" redirection.
+			QFile file(fi.filePath());
+			if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+				return false;
+
+			QString line = QString::fromUtf8(file.readLine()).trimmed();
+			if (!line.startsWith("gitdir:"))
+				return false;
+
+			gitDir = dir.absoluteFilePath(line.mid(7).trimmed());
+			break;
+		}
+	} while (dir.cdUp());
+
+	if (gitDir.isEmpty())
+		return false;
+
+	QString indexPath = QDir(gitDir).filePath("index");
+	if (indexPath != indexPath_) {
+		root_ = dir.path();
+		gitDir_ = gitDir;
+		indexPath_ = indexPath;
+		mtime_ = QDateTime();
+		paths_.clear();
+	}
+
+	return true;
+}
+
+/**
+ * Determines the commit currently checked out in the work tree.
+ * @return The commit ID, or an empty string if it cannot be determined
+ */
+QString GitIndex::head() const
+{
+	if (gitDir_.isEmpty())
+		return QString();
+
+	QFile file(QDir(gitDir_).filePath("HEAD"));
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return QString();
+
+	QString line = QString::fromUtf8(file.readLine()).trimmed();
+	if (line.startsWith("ref:"))
+		return resolveRef(line.mid(4).trimmed());
+
+	// A detached head holds the commit ID itself.
+	return line;
+}
+
+/**
+ * Finds the commit to which a reference points.
+ * Loose references are looked up first in the repository directory and then
+ * in the common directory shared by linked work trees, followed by the
+ * packed references file.
+ * @param  ref  The name of the reference (e.g., "refs/heads/master")
+ * @return The commit ID, or an empty string if the reference is not found
+ */
+QString GitIndex::resolveRef(const QString& ref) const
+{
+	QStringList dirList;
+	dirList << gitDir_;
+
+	QFile commonFile(QDir(gitDir_).filePath("commondir"));
+	if (commonFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		QString common = QString::fromUtf8(commonFile.readLine()).trimmed();
+		dirList << QDir(gitDir_).absoluteFilePath(common);
+	}
+
+	foreach (const QString& dir, dirList) {
+		QFile file(QDir(dir).filePath(ref));
+		if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+			return QString::fromUtf8(file.readLine()).trimmed();
+	}
+
+	foreach (const QString& dir, dirList) {
+		QFile file(QDir(dir).filePath("packed-refs"));
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+			continue;
+
+		// Lines are of the form "<commit> <ref>".
+		while (!file.atEnd()) {
+			QString line = QString::fromUtf8(file.readLine()).trimmed();
+			int space = line.indexOf(' ');
+			if (space > 0 && line.mid(space + 1) == ref)
+				return line.left(space);
+		}
+	}
+
+	return QString();
+}
+
+/**
+ * Re-reads the index file if it was modified since the last time it was read.
+ * @return true if the cached list is valid, false otherwise
+ */
+bool GitIndex::refresh()
+{
+	QFileInfo fi(indexPath_);
+	if (!fi.exists())
+		return false;
+
+	if (fi.lastModified() == mtime_)
+		return true;
+
+	if (!read()) {
+		mtime_ = QDateTime();
+		paths_.clear();
+		return false;
+	}
+
+	mtime_ = fi.lastModified();
+	return true;
+}
+
+/**
+ * Generates a list of tracked files under the given directory that match a
+ * filter.
+ * The filter is applied the same way as by FileScanner: directories
+ * (identified by a trailing separator) matching an inclusion or exclusion
+ * rule turn the addition of files on or off, and other directories inherit the
+ * behaviour of their parent. Files are only added if they match an inclusion
+ * rule.
+ * @param  dir        The directory to list
+ * @param  filter     The filter to apply
+ * @param  recursive  true to include sub-directories, false otherwise
+ * @param  fileList   Holds the matched files, upon successful return
+ * @return true if successful, false if the directory is not in the work tree,
+ *         or holds no tracked files (e.g., it is untracked or ignored)
+ */
+bool GitIndex::files(const QString& dir, const FileFilter& filter,
+                     bool recursive, QStringList& fileList) const
+{
+	if (root_.isEmpty())
+		return false;
+
+	// Determine the location of the directory in the work tree.
+	QString rel = QDir(root_).relativeFilePath(QDir(dir).canonicalPath());
+	if (rel.startsWith(".."))
+		return false;
+
+	QString prefix;
+	if (!rel.isEmpty() && rel != ".")
+		prefix = rel + "/";
+
+	// Paths given to the filter are absolute, with native separators.
+	QString base = QDir::toNativeSeparators(root_);
+	if (!base.endsWith(QDir::separator()))
+		base += QDir::separator();
+
+	// Cache the decision for each directory, starting with the given one.
+	QHash<QString, bool> dirs;
+	QString dirPath = base + QDir::toNativeSeparators(prefix);
+	dirs.insert(prefix, recursive ? filter.match(dirPath, true) : true);
+
+	bool tracked = false;
+	QStringList::ConstIterator itr;
+	for (itr = paths_.begin(); itr != paths_.end(); ++itr) {
+		if (!(*itr).startsWith(prefix))
+			continue;
+
+		tracked = true;
+
+		// Skip files in sub-directories for a non-recursive listing.
+		int slash = (*itr).lastIndexOf('/');
+		if (!recursive && slash >= prefix.length())
+			continue;
+
+		if (!addFiles((*itr).left(slash + 1), base, filter, dirs))
+			continue;
+
+		QString path = base + QDir::toNativeSeparators(*itr);
+		if (filter.match(path, false))
+			fileList.append(path);
+	}
+
+	return tracked;
+}
+
+/**
+ * Parses the index file.
+ * @return true if successful, false otherwise
+ */
+bool GitIndex::read()
+{
+	QFile file(indexPath_);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	// Map the file, if possible, to avoid copying large indices.
+	qint64 size = file.size();
+	QByteArray data;
+	const uchar* buf = file.map(0, size);
+	if (!buf) {
+		data = file.readAll();
+		buf = reinterpret_cast<const uchar*>(data.constData());
+	}
+
+	// Check the header.
+	if (size < 12 || memcmp(buf, "DIRC", 4) != 0) {
+		qDebug() << "Not a git index" << indexPath_;
+		return false;
+	}
+
+	quint32 version = qFromBigEndian<quint32>(buf + 4);
+	quint32 count = qFromBigEndian<quint32>(buf + 8);
+	if (version < 2 || version > 4) {
+		qDebug() << "Unsupported git index version" << version;
+		return false;
+	}
+
+	paths_.clear();
+	paths_.reserve(count);
+
+	const uchar* end = buf + size;
+	const uchar* pos = buf + 12;
+	QByteArray name;
+	for (quint32 i = 0; i < count; i++) {
+		const uchar* entry = pos;
+		if ((end - pos) < EntryHeaderSize)
+			return false;
+
+		quint32 mode = qFromBigEndian<quint32>(pos + 24);
+		quint16 flags = qFromBigEndian<quint16>(pos + 60);
+		pos += EntryHeaderSize;
+
+		// Version 3 adds extended flags.
+		if ((flags & 0x4000) && version >= 3)
+			pos += 2;
+
+		if (version == 4) {
+			// The name is prefix-compressed: a variable-length integer gives
+			// the number of bytes to remove from the previous name, followed
+			// by the new suffix.
+			if (pos >= end)
+				return false;
+
+			uchar c = *pos++;
+			int strip = c & 0x7f;
+			while (c & 0x80) {
+				if (pos >= end)
+					return false;
+
+				c = *pos++;
+				strip = ((strip + 1) << 7) | (c & 0x7f);
+			}
+
+			if (strip > name.size())
+				return false;
+
+			name.chop(strip);
+		}
+		else {
+			name.clear();
+		}
+
+		if (pos >= end)
+			return false;
+
+		const uchar* nul = static_cast<const uchar*>(memchr(pos, 0, end - pos));
+		if (!nul)
+			return false;
+
+		name.append(reinterpret_cast<const char*>(pos), nul - pos);
+		pos = nul + 1;
+
+		// Versions 2 and 3 pad entries to a multiple of 8 bytes.
+		if (version < 4)
+			pos = entry + (((pos - entry) + 7) & ~7);
+
+		// Only add regular files and symbolic links, at stage 0 (i.e., skip
+		// sub-modules, sparse directories and duplicate entries for merge
+		// conflicts).
+		quint32 type = mode & 0170000;
+		if ((type == 0100000 || type == 0120000) && ((flags >> 12) & 3) == 0)
+			paths_.append(QString::fromUtf8(name));
+	}
+
+	return true;
+}
+
+/**
+ * Determines whether files in a directory should be added, creating and
+ * caching decisions for the directory's ancestors as necessary.
+ * @param  relDir  The directory, relative to the work tree root, with a
+ *                 trailing '/'
+ * @param  base    The absolute path of the root, with a trailing separator
+ * @param  filter  The filter to apply
+ * @param  dirs    Cached decisions
+ * @return true if files should be added, false otherwise
+ */
+bool GitIndex::addFiles(const QString& relDir, const QString& base,
+                        const FileFilter& filter,
+                        QHash<QString, bool>& dirs) const
+{
+	QHash<QString, bool>::ConstIterator itr = dirs.find(relDir);
+	if (itr != dirs.end())
+		return *itr;
+
+	// Inherit the decision of the parent directory.
+	int slash = relDir.lastIndexOf('/', -2);
+	bool parent = addFiles(relDir.left(slash + 1), base, filter, dirs);
+
+	QString path = base + QDir::toNativeSeparators(relDir);
+	bool result = filter.match(path, parent);
+	dirs.insert(relDir, result);
+	return result;
+}
+
+} // namespace Core
+
+} // namespace KScope
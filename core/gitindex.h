@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_GITINDEX_H__
+#define __CORE_GITINDEX_H__
+
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include "filefilter.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Lists the files tracked by a git repository.
+ * The list is read directly from the repository's index file (versions 2
+ * through 4 of the format), which is much faster than walking the work tree
+ * and naturally leaves out the .git directory, build output and other
+ * untracked files. The list is only re-read when the modification time of
+ * the index changes.
+ * @author Elad Lahav
+ */
+class GitIndex
+{
+public:
+	GitIndex();
+	~GitIndex();
+
+	bool open(const QString& path);
+	bool refresh();
+	bool files(const QString& dir, const FileFilter& filter, bool recursive,
+	           QStringList& fileList) const;
+	QString head() const;
+
+	/**
+	 * @return The root of the work tree
+	 */
+	const QString& root() const { return root_; }
+
+private:
+	/**
+	 * The root of the work tree.
+	 */
+	QString root_;
+
+	/**
+	 * The repository directory.
+	 */
+	QString gitDir_;
+
+	/**
+	 * The path of the index file.
+	 */
+	QString indexPath_;
+
+	/**
+	 * The modification time of the index file when it was last read.
+	 */
+	QDateTime mtime_;
+
+	/**
+	 * Tracked files, relative to the root of the work tree, in index order.
+	 */
+	QStringList paths_;
+
+	bool read();
+	QString resolveRef(const QString& ref) const;
+	bool addFiles(const QString& relDir, const QString& base,
+	              const FileFilter& filter, QHash<QString, bool>& dirs) const;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_GITINDEX_H__
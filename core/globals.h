@@ -22,6 +22,7 @@
 #define __CORE_GLOBALS_H__
 
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 
 namespace KScope
@@ -122,6 +123,18 @@ struct Location
 	 */
 	QString text_;
 
+	/**
+	 * The name of the project that produced the location (only set for
+	 * queries spanning several projects).
+	 */
+	QString project_;
+
+	/**
+	 * A numeric measure attached to the location by code metrics reports
+	 * (e.g., the number of references to a symbol).
+	 */
+	uint count_;
+
 	/**
 	 * Each member in the structure is assigned a numeric value. These can be
 	 * used for, e.g., creating lists of fields for displaying query results.
@@ -141,14 +154,18 @@ struct Location
 		/** Scope of the tag (function name, structure, global, etc.) */
 		Scope,
 		/** Line text. */
-		Text
+		Text,
+		/** Project name. */
+		Project,
+		/** Code metrics measure. */
+		Count
 	};
 
 	/**
 	 * Default constructor.
 	 * Creates an empty (invalid) location object.
 	 */
-	Location() : line_(0), column_(0) {}
+	Location() : line_(0), column_(0), count_(0) {}
 
 	/**
 	 * Convenience constructor.
@@ -157,7 +174,7 @@ struct Location
 	 * @param  column
 	 */
 	Location(const QString& file, uint line = 0, uint column = 0)
-		: file_(file), line_(line), column_(column) {}
+		: file_(file), line_(line), column_(column), count_(0) {}
 
 	/**
 	 * @return true if the object represents a valid location (at least the
@@ -210,7 +227,11 @@ struct Query
 		/** Search for files including a given file name */
 		IncludingFiles,
 		/** List all tags in the given file */
-		LocalTags
+		LocalTags,
+		/** Files related to a given file name through #include directives */
+		IncludeClosure,
+		/** A project-wide code metrics report (the pattern names the report) */
+		Metrics
 	};
 
 	/**
@@ -242,11 +263,25 @@ struct Query
 	 */
 	uint flags_;
 
+	/**
+	 * Restricts results to files under these directories.
+	 * An empty list means that the entire code base is searched.
+	 */
+	QStringList pathPrefixes_;
+
+	/**
+	 * The maximal time, in milliseconds, the query is allowed to run, or 0 for
+	 * no limit.
+	 * A query that runs past its deadline is stopped, and reported through
+	 * Engine::Connection::onTimedOut().
+	 */
+	int timeout_;
+
 	/**
 	 * Default constructor.
 	 * Creates an invalid query object.
 	 */
-	Query() : type_(Invalid) {}
+	Query() : type_(Invalid), flags_(0), timeout_(0) {}
 
 	/**
 	 * Struct constructor.
@@ -256,7 +291,54 @@ struct Query
 	 */
 	Query(Type type, const QString& pattern,
 	      uint flags = 0)
-		: type_(type), pattern_(pattern), flags_(flags) {}
+		: type_(type), pattern_(pattern), flags_(flags), timeout_(0) {}
+
+	/**
+	 * @param  path  A file path
+	 * @return true if the path is within the scope of the query, false
+	 *         otherwise
+	 */
+	bool matchesPath(const QString& path) const {
+		return matchesPath(pathPrefixes_, path);
+	}
+
+	/**
+	 * Determines whether a file is located under any of the given directories.
+	 * Absolute prefixes need to match the beginning of the path. Relative
+	 * ones may match after any directory separator, as the paths of the files
+	 * in the code base are not necessarily relative to the same directory.
+	 * @param  prefixes  A list of directory paths
+	 * @param  path      A file path
+	 * @return true if the list is empty or the path is under one of the
+	 *         directories, false otherwise
+	 */
+	static bool matchesPath(const QStringList& prefixes, const QString& path) {
+		if (prefixes.isEmpty())
+			return true;
+
+		foreach (QString prefix, prefixes) {
+			if (!prefix.endsWith('/'))
+				prefix += '/';
+
+			if (prefix.startsWith('/')) {
+				if (path.startsWith(prefix))
+					return true;
+				continue;
+			}
+
+			if (prefix.startsWith("./"))
+				prefix = prefix.mid(2);
+
+			int pos = path.indexOf(prefix);
+			while (pos >= 0) {
+				if ((pos == 0) || (path[pos - 1] == '/'))
+					return true;
+				pos = path.indexOf(prefix, pos + 1);
+			}
+		}
+
+		return false;
+	}
 };
 
 /**
@@ -0,0 +1,367 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QObject>
+#include <QDir>
+#include "includegraph.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ */
+IncludeGraph::IncludeGraph() : edgeCount_(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+IncludeGraph::~IncludeGraph()
+{
+}
+
+/**
+ * Adds a file of the code base to the graph.
+ * @param  path  The path of the file
+ * @return The index of the new node
+ */
+int IncludeGraph::addFile(const QString& path)
+{
+	return addNode(path, false);
+}
+
+/**
+ * Records an #include directive.
+ * The directive is not added to the graph until resolve() is called.
+ * @param  from    The node of the file holding the directive
+ * @param  name    The included name
+ * @param  system  true if the name was given in angle brackets, false if it
+ *                 was given in quotes
+ * @param  line    The line number of the directive
+ */
+void IncludeGraph::addInclude(int from, const QString& name, bool system,
+                              uint line)
+{
+	// Many files include the same names, so share the string data.
+	QHash<QString, QString>::ConstIterator itr = names_.find(name);
+	if (itr == names_.end())
+		itr = names_.insert(name, name);
+
+	Pending pending;
+	pending.from_ = from;
+	pending.name_ = *itr;
+	pending.system_ = system;
+	pending.line_ = line;
+	pendingList_.append(pending);
+}
+
+/**
+ * Turns all recorded #include directives into edges.
+ * A name given in quotes is first looked up relative to the directory of the
+ * including file. Otherwise, the name is matched against the end of the
+ * paths of all files with the same base name. If no file matches, the name is
+ * attached to an external node.
+ */
+void IncludeGraph::resolve()
+{
+	foreach (const Pending& pending, pendingList_) {
+		QVector<int> targets;
+
+		// Get all files with the same base name.
+		QString baseName = pending.name_.section('/', -1);
+		QVector<int> cands = baseNames_.value(baseName);
+
+		// Look for the file relative to the including one.
+		if (!pending.system_) {
+			QString from = nodeList_[pending.from_].path_;
+			QString local = QDir::cleanPath(from.left(from.lastIndexOf('/') + 1)
+			                                + pending.name_);
+			foreach (int node, cands) {
+				if (nodeList_[node].path_ == local) {
+					targets.append(node);
+					break;
+				}
+			}
+		}
+
+		// Match the end of the path.
+		if (targets.isEmpty()) {
+			QString suffix = pending.name_;
+			while (suffix.startsWith("./") || suffix.startsWith("../"))
+				suffix = suffix.section('/', 1);
+
+			foreach (int node, cands) {
+				const QString& path = nodeList_[node].path_;
+				if ((path == suffix) || path.endsWith('/' + suffix))
+					targets.append(node);
+			}
+		}
+
+		// Not part of the code base.
+		if (targets.isEmpty()) {
+			QHash<QString, int>::ConstIterator itr
+				= externals_.find(pending.name_);
+			if (itr == externals_.end())
+				itr = externals_.insert(pending.name_,
+				                        addNode(pending.name_, true));
+
+			targets.append(*itr);
+		}
+
+		// Create edges in both directions.
+		foreach (int target, targets) {
+			Edge edge;
+			edge.line_ = pending.line_;
+			edge.name_ = pending.name_;
+			edge.system_ = pending.system_;
+
+			edge.node_ = target;
+			nodeList_[pending.from_].includes_.append(edge);
+
+			edge.node_ = pending.from_;
+			nodeList_[target].includedBy_.append(edge);
+
+			edgeCount_++;
+		}
+	}
+
+	pendingList_.clear();
+	names_.clear();
+}
+
+/**
+ * Lists all files that directly include the given name.
+ * @param  name     The included file name
+ * @param  locList  A list to which the locations of #include directives are
+ *                  appended
+ */
+void IncludeGraph::includers(const QString& name, LocationList& locList) const
+{
+	QVector<int> roots;
+	findNodes(name, roots);
+
+	foreach (int root, roots) {
+		foreach (const Edge& edge, nodeList_[root].includedBy_) {
+			Location loc(nodeList_[edge.node_].path_, edge.line_);
+			loc.text_ = directive(edge);
+			locList.append(loc);
+		}
+	}
+}
+
+/**
+ * Lists all files related to the given name through #include directives.
+ * The result holds four groups of files, each labelled with its size in the
+ * Scope field:
+ * 1. Files including the name directly;
+ * 2. Files including the name through other files;
+ * 3. Files directly included by the name;
+ * 4. Files included by the name through other files.
+ * @param  name     The file name
+ * @param  locList  A list to which the results are appended
+ */
+void IncludeGraph::closure(const QString& name, LocationList& locList) const
+{
+	QVector<int> roots;
+	findNodes(name, roots);
+	if (roots.isEmpty())
+		return;
+
+	QVector<Visit> visits;
+	traverse(roots, true, visits);
+	addVisits(visits, true, locList);
+
+	visits.clear();
+	traverse(roots, false, visits);
+	addVisits(visits, false, locList);
+}
+
+/**
+ * Counts the files that include the given node, directly or indirectly.
+ * @param  node  The node index
+ * @return The size of the reverse-dependency closure of the node
+ */
+int IncludeGraph::includerClosureSize(int node) const
+{
+	QVector<Visit> visits;
+	traverse(QVector<int>() << node, true, visits);
+	return visits.size();
+}
+
+/**
+ * Creates a new node.
+ * @param  path      The path of the file represented by the node
+ * @param  external  Whether the node is outside the code base
+ * @return The index of the new node
+ */
+int IncludeGraph::addNode(const QString& path, bool external)
+{
+	Node node;
+	node.path_ = path;
+	node.external_ = external;
+	nodeList_.append(node);
+
+	int index = nodeList_.size() - 1;
+	if (!external)
+		baseNames_[path.section('/', -1)].append(index);
+
+	return index;
+}
+
+/**
+ * Finds the nodes corresponding to a file name.
+ * These are all files whose path is either equal to the name, or ends with it,
+ * as well as an external node by that name.
+ * @param  name   The name to look for
+ * @param  nodes  Holds the matching node indices
+ */
+void IncludeGraph::findNodes(const QString& name, QVector<int>& nodes) const
+{
+	QString suffix = name;
+	while (suffix.startsWith("./"))
+		suffix = suffix.mid(2);
+
+	foreach (int node, baseNames_.value(suffix.section('/', -1))) {
+		const QString& path = nodeList_[node].path_;
+		if ((path == suffix) || path.endsWith('/' + suffix))
+			nodes.append(node);
+	}
+
+	QHash<QString, int>::ConstIterator itr = externals_.find(name);
+	if (itr != externals_.end())
+		nodes.append(*itr);
+}
+
+/**
+ * Performs a breadth-first traversal of the graph.
+ * @param  roots   The nodes from which to start
+ * @param  up      true to follow edges towards including files, false to
+ *                 follow edges towards included files
+ * @param  visits  Holds the reached nodes (excluding the roots), in order of
+ *                 their distance from the roots
+ */
+void IncludeGraph::traverse(const QVector<int>& roots, bool up,
+                            QVector<Visit>& visits) const
+{
+	QVector<bool> visited(nodeList_.size(), false);
+	foreach (int root, roots)
+		visited[root] = true;
+
+	// Expand the search one level at a time.
+	int depth = 0;
+	QVector<int> level = roots;
+	while (!level.isEmpty()) {
+		QVector<int> nextLevel;
+		depth++;
+
+		foreach (int node, level) {
+			const QVector<Edge>& edges = up ? nodeList_[node].includedBy_
+			                                : nodeList_[node].includes_;
+			for (int i = 0; i < edges.size(); i++) {
+				int child = edges[i].node_;
+				if (visited[child])
+					continue;
+
+				visited[child] = true;
+				nextLevel.append(child);
+
+				Visit visit;
+				visit.node_ = child;
+				visit.parent_ = node;
+				visit.depth_ = depth;
+				visit.edge_ = &edges[i];
+				visits.append(visit);
+			}
+		}
+
+		level = nextLevel;
+	}
+}
+
+/**
+ * Converts the result of a traversal into a list of locations.
+ * @param  visits   The nodes reached by the traversal
+ * @param  up       The direction of the traversal
+ * @param  locList  A list to which the locations are appended
+ */
+void IncludeGraph::addVisits(const QVector<Visit>& visits, bool up,
+                             LocationList& locList) const
+{
+	int direct = 0;
+	foreach (const Visit& visit, visits) {
+		if (visit.depth_ == 1)
+			direct++;
+	}
+
+	QString directLabel, indirectLabel;
+	if (up) {
+		directLabel = QObject::tr("Direct includers (%1)").arg(direct);
+		indirectLabel = QObject::tr("Transitive includers (%1)")
+		                .arg(visits.size() - direct);
+	}
+	else {
+		directLabel = QObject::tr("Direct includes (%1)").arg(direct);
+		indirectLabel = QObject::tr("Transitive includes (%1)")
+		                .arg(visits.size() - direct);
+	}
+
+	foreach (const Visit& visit, visits) {
+		Location loc;
+		if (up) {
+			// Point at the directive in the including file.
+			loc.file_ = nodeList_[visit.node_].path_;
+			loc.line_ = visit.edge_->line_;
+			loc.text_ = directive(*visit.edge_);
+		}
+		else {
+			// Point at the included file, and show where it is included from.
+			loc.file_ = nodeList_[visit.node_].path_;
+			loc.line_ = 0;
+			loc.text_ = QObject::tr("%1 in %2")
+			            .arg(directive(*visit.edge_))
+			            .arg(nodeList_[visit.parent_].path_);
+		}
+
+		loc.tag_.scope_ = (visit.depth_ == 1) ? directLabel : indirectLabel;
+		locList.append(loc);
+	}
+}
+
+/**
+ * Reconstructs the text of an #include directive.
+ * @param  edge  The edge representing the directive
+ * @return The directive's text
+ */
+QString IncludeGraph::directive(const Edge& edge)
+{
+	if (edge.system_)
+		return QString("#include <%1>").arg(edge.name_);
+
+	return QString("#include \"%1\"").arg(edge.name_);
+}
+
+} // namespace Core
+
+} // namespace KScope
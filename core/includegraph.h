@@ -0,0 +1,220 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_INCLUDEGRAPH_H__
+#define __CORE_INCLUDEGRAPH_H__
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * A graph of #include relations between the files of a code base.
+ * Nodes are files, and an edge leads from each file to every file it
+ * includes. The graph is built in two stages: first, all files and the
+ * (textual) names they include are added; then, resolve() matches the names
+ * with the files in the graph. Names that do not correspond to any file in the
+ * code base (e.g., system headers) are represented by external nodes.
+ * Once resolved, the graph can answer questions about both direct and
+ * transitive relations (e.g., the set of all files that need to be recompiled
+ * if a header changes) with simple breadth-first traversals.
+ * @author Elad Lahav
+ */
+class IncludeGraph
+{
+public:
+	IncludeGraph();
+	~IncludeGraph();
+
+	int addFile(const QString&);
+	void addInclude(int, const QString&, bool, uint);
+	void resolve();
+	void includers(const QString&, LocationList&) const;
+	void closure(const QString&, LocationList&) const;
+
+	/**
+	 * @return true if the graph has no nodes, false otherwise
+	 */
+	bool isEmpty() const { return nodeList_.isEmpty(); }
+
+	/**
+	 * @return The number of nodes in the graph
+	 */
+	int size() const { return nodeList_.size(); }
+
+	/**
+	 * @return The number of #include directives in the graph
+	 */
+	int edgeCount() const { return edgeCount_; }
+
+	/**
+	 * @param  node  A node index
+	 * @return The path of the file represented by the node
+	 */
+	const QString& path(int node) const { return nodeList_[node].path_; }
+
+	/**
+	 * @param  node  A node index
+	 * @return true if the node is not a file in the code base
+	 */
+	bool isExternal(int node) const { return nodeList_[node].external_; }
+
+	/**
+	 * @param  node  A node index
+	 * @return The number of files directly included by the node
+	 */
+	int includeCount(int node) const {
+		return nodeList_[node].includes_.size();
+	}
+
+	/**
+	 * @param  node  A node index
+	 * @return The number of files directly including the node
+	 */
+	int includerCount(int node) const {
+		return nodeList_[node].includedBy_.size();
+	}
+
+	int includerClosureSize(int) const;
+
+private:
+	/**
+	 * An #include directive.
+	 */
+	struct Edge
+	{
+		/**
+		 * The node on the other side of the edge.
+		 */
+		int node_;
+
+		/**
+		 * The line of the directive in the including file.
+		 */
+		uint line_;
+
+		/**
+		 * The included name, as it appears in the directive.
+		 */
+		QString name_;
+
+		/**
+		 * Whether the name was given in angle brackets.
+		 */
+		bool system_;
+	};
+
+	/**
+	 * A file in the graph.
+	 */
+	struct Node
+	{
+		QString path_;
+		bool external_;
+		QVector<Edge> includes_;
+		QVector<Edge> includedBy_;
+	};
+
+	/**
+	 * An #include directive that was not yet resolved.
+	 */
+	struct Pending
+	{
+		int from_;
+		QString name_;
+		bool system_;
+		uint line_;
+	};
+
+	/**
+	 * The nodes of the graph.
+	 */
+	QVector<Node> nodeList_;
+
+	/**
+	 * Directives added since the last call to resolve().
+	 */
+	QVector<Pending> pendingList_;
+
+	/**
+	 * Maps file base names to nodes.
+	 */
+	QHash<QString, QVector<int> > baseNames_;
+
+	/**
+	 * Maps names that could not be resolved to external nodes.
+	 */
+	QHash<QString, int> externals_;
+
+	/**
+	 * Used to share the storage of identical included names.
+	 */
+	QHash<QString, QString> names_;
+
+	/**
+	 * The total number of edges.
+	 */
+	int edgeCount_;
+
+	/**
+	 * A node reached during a traversal of the graph.
+	 */
+	struct Visit
+	{
+		/**
+		 * The reached node.
+		 */
+		int node_;
+
+		/**
+		 * The node from which this node was reached.
+		 */
+		int parent_;
+
+		/**
+		 * The distance from the starting set.
+		 */
+		int depth_;
+
+		/**
+		 * The edge through which the node was reached.
+		 */
+		const Edge* edge_;
+	};
+
+	int addNode(const QString&, bool);
+	void findNodes(const QString&, QVector<int>&) const;
+	void traverse(const QVector<int>&, bool, QVector<Visit>&) const;
+	void addVisits(const QVector<Visit>&, bool, LocationList&) const;
+	static QString directive(const Edge&);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_INCLUDEGRAPH_H__
@@ -163,6 +163,14 @@ QVariant LocationModel::locationData(const Location& loc, uint col,
 	case Location::Text:
 		// Line text.
 		return loc.text_;
+
+	case Location::Project:
+		// Project name.
+		return loc.project_;
+
+	case Location::Count:
+		// Code metrics measure.
+		return loc.count_;
 	}
 
 	return QVariant();
@@ -196,6 +204,12 @@ QString LocationModel::columnText(Location::Fields col) const
 
 	case Location::Text:
 		return tr("Text");
+
+	case Location::Project:
+		return tr("Project");
+
+	case Location::Count:
+		return tr("Count");
 	}
 
 	return "";
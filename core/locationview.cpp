@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QHeaderView>
 #include "locationview.h"
 #include "locationlistmodel.h"
 #include "locationtreemodel.h"
@@ -58,6 +59,13 @@ LocationView::LocationView(QWidget* parent, Type type)
 		break;
 	}
 
+	// Lists can be sorted by any column, by clicking its header. Locations
+	// are initially shown in the order in which they were added.
+	if (type_ == List) {
+		header()->setSortIndicator(-1, Qt::AscendingOrder);
+		setSortingEnabled(true);
+	}
+
 	// Emit requests for locations when an item is double-clicked.
 	connect(this, SIGNAL(activated(const QModelIndex&)), this,
 	        SLOT(requestLocation(const QModelIndex&)));
@@ -260,6 +268,16 @@ void LocationView::locationToXML(QDomDocument& doc, QDomElement& parentElem,
 				name = "Text";
 				node = doc.createCDATASection(loc.text_);
 				break;
+
+			case Location::Project:
+				name = "Project";
+				node = doc.createTextNode(loc.project_);
+				break;
+
+			case Location::Count:
+				name = "Count";
+				node = doc.createTextNode(QString::number(loc.count_));
+				break;
 			}
 
 			QDomElement child = doc.createElement(name);
@@ -344,6 +362,10 @@ void LocationView::locationFromXML(const QDomElement& locListElem,
 				loc.tag_.scope_ = child.text();
 			else if (child.tagName() == "Text")
 				loc.text_ = child.firstChild().toCDATASection().data();
+			else if (child.tagName() == "Project")
+				loc.project_ = child.text();
+			else if (child.tagName() == "Count")
+				loc.count_ = child.text().toUInt();
 			else if (child.tagName() == "LocationList")
 				childLists.append(QPair<int, QDomElement>(i, child));
 		}
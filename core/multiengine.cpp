@@ -0,0 +1,256 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QSet>
+#include <QDebug>
+#include "connectiongroup.h"
+#include "exception.h"
+#include "multiengine.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+MultiEngine::MultiEngine(QObject* parent) : Engine(parent)
+{
+}
+
+/**
+ * Class destructor.
+ */
+MultiEngine::~MultiEngine()
+{
+}
+
+/**
+ * Adds an engine.
+ * Results are tagged with the name of the project, which therefore needs to
+ * be unique: a number is appended to a name already used by another member.
+ * @param  name    The name of the project to which the engine belongs
+ * @param  engine  The engine to add
+ */
+void MultiEngine::addEngine(const QString& name, Engine* engine)
+{
+	QSet<QString> names;
+	QList<Member>::ConstIterator itr;
+	for (itr = memberList_.begin(); itr != memberList_.end(); ++itr)
+		names.insert((*itr).name_);
+
+	QString uniqueName = name;
+	for (int i = 2; names.contains(uniqueName); i++)
+		uniqueName = QString("%1 (%2)").arg(name).arg(i);
+
+	Member member;
+	member.name_ = uniqueName;
+	member.engine_ = engine;
+	memberList_.append(member);
+
+	connect(engine, SIGNAL(indicesChanged()), this, SIGNAL(indicesChanged()));
+}
+
+/**
+ * Removes all engines.
+ */
+void MultiEngine::clear()
+{
+	QList<Member>::ConstIterator itr;
+	for (itr = memberList_.begin(); itr != memberList_.end(); ++itr)
+		disconnect((*itr).engine_, SIGNAL(indicesChanged()), this, NULL);
+
+	memberList_.clear();
+}
+
+/**
+ * Member engines are opened by their projects.
+ * @param  initString  Ignored
+ * @param  cb          Called immediately
+ */
+void MultiEngine::open(const QString& initString, Callback<>* cb)
+{
+	(void)initString;
+	if (cb)
+		cb->call();
+}
+
+/**
+ * The status of the combined engine is that of the least-ready member.
+ * @return The engine's status
+ */
+Engine::Status MultiEngine::status() const
+{
+	if (memberList_.isEmpty())
+		return Unknown;
+
+	Status result = Ready;
+	QList<Member>::ConstIterator itr;
+	for (itr = memberList_.begin(); itr != memberList_.end(); ++itr) {
+		Status status = (*itr).engine_->status();
+		if (status == Unknown || status == Build)
+			return status;
+
+		if (status == Rebuild)
+			result = Rebuild;
+	}
+
+	return result;
+}
+
+/**
+ * Returns the fields filled by the first member for the given query type,
+ * preceded by the name of the project.
+ * @param  type  The requested query type
+ * @return A list of Location fields
+ */
+QList<Location::Fields> MultiEngine::queryFields(Query::Type type) const
+{
+	QList<Location::Fields> fieldList;
+	if (memberList_.isEmpty())
+		return fieldList;
+
+	fieldList = memberList_.first().engine_->queryFields(type);
+	fieldList.prepend(Location::Project);
+	return fieldList;
+}
+
+/**
+ * Merges the suggestions of all members.
+ * @param  text        The partial pattern
+ * @param  maxResults  The maximal number of suggestions
+ * @return Suggested names
+ */
+QStringList MultiEngine::complete(const QString& text, int maxResults) const
+{
+	QStringList result;
+	QSet<QString> seen;
+
+	QList<Member>::ConstIterator itr;
+	for (itr = memberList_.begin(); itr != memberList_.end(); ++itr) {
+		QStringList names = (*itr).engine_->complete(text, maxResults);
+		QStringList::ConstIterator nameItr;
+		for (nameItr = names.begin(); nameItr != names.end(); ++nameItr) {
+			if (seen.contains(*nameItr))
+				continue;
+
+			seen.insert(*nameItr);
+			result.append(*nameItr);
+			if (result.size() >= maxResults)
+				return result;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * A query can start once all members can start it.
+ * @param  query  The query to check
+ * @return true if the query can be started, false otherwise
+ */
+bool MultiEngine::canQuery(const Query& query) const
+{
+	QList<Member>::ConstIterator itr;
+	for (itr = memberList_.begin(); itr != memberList_.end(); ++itr) {
+		if (!(*itr).engine_->canQuery(query))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Runs a query on all members concurrently.
+ * A member that fails to start the query (e.g., a project whose database was
+ * not built yet) is treated as having finished without results, so that the
+ * query completes normally with the results of the other members. If no
+ * member can start the query, an exception is thrown with the reasons given
+ * by all members.
+ * @param  conn   Used for communication with the ongoing operation
+ * @param  query  The query to execute
+ * @throw  Exception
+ */
+void MultiEngine::query(Connection* conn, const Query& query) const
+{
+	if (memberList_.isEmpty())
+		throw new Exception("No project is currently loaded");
+
+	ConnectionGroup* group = new ConnectionGroup(conn, memberList_.size());
+	for (int i = 0; i < memberList_.size(); i++)
+		group->setTag(i, memberList_[i].name_);
+
+	// Failed members are only marked as finished once all members were
+	// started, so that the group is still around if all of them fail.
+	QList<int> failedList;
+	QStringList reasons;
+	for (int i = 0; i < memberList_.size(); i++) {
+		try {
+			memberList_[i].engine_->query(group->branch(i), query);
+		}
+		catch (Exception* e) {
+			qDebug() << "Query failed for" << memberList_[i].name_ << ":"
+			         << e->reason();
+			failedList.append(i);
+			reasons.append(QString("%1: %2").arg(memberList_[i].name_)
+			                                .arg(e->reason()));
+			delete e;
+		}
+	}
+
+	if (failedList.size() == memberList_.size()) {
+		conn->setCtrlObject(NULL);
+		delete group;
+		throw new Exception(reasons.join("\n"));
+	}
+
+	QList<int>::ConstIterator itr;
+	for (itr = failedList.begin(); itr != failedList.end(); ++itr)
+		group->branch(*itr)->onFinished();
+}
+
+/**
+ * Builds the databases of all members concurrently.
+ * @param  conn  Used for communication with the ongoing operation
+ * @throw  Exception
+ */
+void MultiEngine::build(Connection* conn) const
+{
+	if (memberList_.isEmpty())
+		throw new Exception("No project is currently loaded");
+
+	ConnectionGroup* group = new ConnectionGroup(conn, memberList_.size());
+	for (int i = 0; i < memberList_.size(); i++) {
+		try {
+			memberList_[i].engine_->build(group->branch(i));
+		}
+		catch (Exception* e) {
+			delete e;
+			group->branch(i)->onAborted();
+		}
+	}
+}
+
+} // namespace Core
+
+} // namespace KScope
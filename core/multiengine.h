@@ -0,0 +1,95 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_MULTIENGINE_H__
+#define __CORE_MULTIENGINE_H__
+
+#include <QList>
+#include "engine.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * An engine that spans the engines of several projects.
+ * Queries and builds are passed to all member engines concurrently, and their
+ * results are merged into the original connection as they arrive. Each result
+ * is tagged with the name of the project whose engine produced it.
+ * The member engines are not owned by this object.
+ * @author Elad Lahav
+ */
+class MultiEngine : public Engine
+{
+	Q_OBJECT
+
+public:
+	MultiEngine(QObject* parent = NULL);
+	~MultiEngine();
+
+	void addEngine(const QString& name, Engine* engine);
+	void clear();
+
+	/**
+	 * @return The number of member engines
+	 */
+	int count() const { return memberList_.size(); }
+
+	// Engine implementation.
+	void open(const QString& initString, Callback<>* cb);
+	Status status() const;
+	QList<Location::Fields> queryFields(Query::Type type) const;
+	QStringList complete(const QString& text, int maxResults) const;
+	bool canQuery(const Query& query) const;
+
+public slots:
+	void query(Connection* conn, const Query& query) const;
+	void build(Connection* conn) const;
+
+private:
+	/**
+	 * A member engine.
+	 */
+	struct Member
+	{
+		/**
+		 * The name of the project to which the engine belongs.
+		 */
+		QString name_;
+
+		/**
+		 * The engine.
+		 */
+		Engine* engine_;
+	};
+
+	/**
+	 * The member engines.
+	 */
+	QList<Member> memberList_;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_MULTIENGINE_H__
@@ -0,0 +1,415 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QRegExp>
+#include <QSet>
+#include <algorithm>
+#include <iterator>
+#include "pathindex.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ */
+PathIndex::PathIndex()
+{
+}
+
+/**
+ * Class destructor.
+ */
+PathIndex::~PathIndex()
+{
+}
+
+/**
+ * Replaces the contents of the index with the files of the given code base.
+ * @param  cbase  The code base to index
+ */
+void PathIndex::build(const Codebase& cbase)
+{
+	clear();
+
+	AddPathCallback cb(this);
+	cbase.getFiles(cb);
+
+	// Release memory reserved by the growing posting lists.
+	QHash<quint64, QVector<int> >::Iterator itr;
+	for (itr = trigrams_.begin(); itr != trigrams_.end(); ++itr)
+		(*itr).squeeze();
+	foldedList_.squeeze();
+	baseNamePos_.squeeze();
+}
+
+/**
+ * Applies changes to the file list of the code base.
+ * New paths are appended to the index. The index is only rebuilt (from the
+ * paths it holds, rather than from the code base) if paths are removed.
+ * @param  added    Paths to add
+ * @param  removed  Paths to remove
+ */
+void PathIndex::update(const QStringList& added, const QStringList& removed)
+{
+	if (!removed.isEmpty()) {
+		QSet<QString> removedSet = removed.toSet();
+		QStringList pathList = pathList_;
+
+		clear();
+		foreach (const QString& path, pathList) {
+			if (!removedSet.contains(path))
+				addPath(path);
+		}
+	}
+
+	foreach (const QString& path, added)
+		addPath(path);
+}
+
+/**
+ * Removes all paths from the index.
+ */
+void PathIndex::clear()
+{
+	pathList_.clear();
+	foldedList_.clear();
+	baseNamePos_.clear();
+	trigrams_.clear();
+}
+
+/**
+ * Finds all indexed paths matching the given pattern.
+ * See the class description for the types of supported patterns.
+ * Paths outside the directories given by the query are discarded before
+ * ranking.
+ * @param  query       The query (only the pattern, the IgnoreCase flag and the
+ *                     path prefixes are considered)
+ * @param  locList     A list to which matching paths are appended, in order of
+ *                     relevance
+ * @param  maxResults  The maximal number of results to return
+ */
+void PathIndex::query(const Query& query, LocationList& locList,
+                      int maxResults) const
+{
+	const QString& pattern = query.pattern_;
+	if (pattern.isEmpty() || pathList_.isEmpty())
+		return;
+
+	bool ignoreCase = (query.flags_ & Query::IgnoreCase) != 0;
+
+	// Collect all matching paths, along with their ranks.
+	QVector<Match> matches;
+	if (pattern.contains(QRegExp("[*?[]"))) {
+		wildcardQuery(pattern, ignoreCase, matches);
+	}
+	else {
+		substringQuery(pattern, ignoreCase, matches);
+		if (matches.isEmpty())
+			fuzzyQuery(pattern.toLower(), matches);
+	}
+
+	// Apply the query's directory restrictions.
+	if (!query.pathPrefixes_.isEmpty()) {
+		QVector<Match> inScope;
+		foreach (const Match& match, matches) {
+			if (query.matchesPath(pathList_[match.index_]))
+				inScope.append(match);
+		}
+
+		matches = inScope;
+	}
+
+	// Only the best results need to be sorted.
+	int count = qMin(matches.size(), maxResults);
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+	                  matchLessThan);
+
+	for (int i = 0; i < count; i++) {
+		Location loc(pathList_[matches[i].index_]);
+		loc.tag_.type_ = Tag::UnknownTag;
+		locList.append(loc);
+	}
+}
+
+/**
+ * Adds a single path to the index.
+ * @param  path  The path to add
+ */
+void PathIndex::addPath(const QString& path)
+{
+	int index = pathList_.size();
+	QString folded = path.toLower();
+
+	pathList_.append(path);
+	foldedList_.append(folded);
+	baseNamePos_.append(path.lastIndexOf(QDir::separator()) + 1);
+
+	// Add the path to the posting list of each of its trigrams.
+	// Paths are added in increasing index order, so the lists remain sorted,
+	// and a duplicate can only be the last element.
+	const QChar* str = folded.constData();
+	for (int i = 0; i + 3 <= folded.length(); i++) {
+		QVector<int>& list = trigrams_[trigram(str + i)];
+		if (list.isEmpty() || list.last() != index)
+			list.append(index);
+	}
+}
+
+/**
+ * Computes the set of paths that may contain all of the given literals.
+ * @param  literals  Case-folded strings that must appear in matching paths
+ * @param  result    Holds the sorted list of candidate path indices
+ * @return true if the result is valid, false if the literals are too short
+ *         to filter the path list (i.e., all paths are candidates)
+ */
+bool PathIndex::candidates(const QStringList& literals,
+                           QVector<int>& result) const
+{
+	QList<const QVector<int>*> lists;
+
+	// Get the posting list of each trigram.
+	// If any trigram does not appear in the index, then there can be no match.
+	foreach (const QString& literal, literals) {
+		for (int i = 0; i + 3 <= literal.length(); i++) {
+			QHash<quint64, QVector<int> >::ConstIterator itr
+				= trigrams_.find(trigram(literal.constData() + i));
+			if (itr == trigrams_.end()) {
+				result.clear();
+				return true;
+			}
+
+			lists.append(&(*itr));
+		}
+	}
+
+	if (lists.isEmpty())
+		return false;
+
+	// Intersect the lists, starting with the shortest one, so that the
+	// intermediate result is kept as small as possible.
+	int shortest = 0;
+	for (int i = 1; i < lists.size(); i++) {
+		if (lists[i]->size() < lists[shortest]->size())
+			shortest = i;
+	}
+
+	result = *lists[shortest];
+	for (int i = 0; i < lists.size() && !result.isEmpty(); i++) {
+		if (i == shortest)
+			continue;
+
+		QVector<int> merged;
+		std::set_intersection(result.begin(), result.end(),
+		                      lists[i]->begin(), lists[i]->end(),
+		                      std::back_inserter(merged));
+		result = merged;
+	}
+
+	return true;
+}
+
+/**
+ * Finds all paths containing the given string.
+ * @param  needle      The string to look for
+ * @param  ignoreCase  Whether the comparison is case-insensitive
+ * @param  matches     Holds the matching paths
+ */
+void PathIndex::substringQuery(const QString& needle, bool ignoreCase,
+                               QVector<Match>& matches) const
+{
+	Qt::CaseSensitivity cs = ignoreCase ? Qt::CaseInsensitive
+	                                    : Qt::CaseSensitive;
+
+	QVector<int> cands;
+	bool filtered = candidates(QStringList() << needle.toLower(), cands);
+	int count = filtered ? cands.size() : pathList_.size();
+
+	for (int c = 0; c < count; c++) {
+		int i = filtered ? cands[c] : c;
+		const QString& path = pathList_[i];
+		if (!path.contains(needle, cs))
+			continue;
+
+		// Matches in the base name are preferred to matches in the directory
+		// part of the path.
+		QStringRef baseName = path.midRef(baseNamePos_[i]);
+		Match match;
+		if (baseName.compare(needle, cs) == 0)
+			match.rank_ = 0;
+		else if (baseName.startsWith(needle, cs))
+			match.rank_ = 1;
+		else if (baseName.contains(needle, cs))
+			match.rank_ = 2;
+		else
+			match.rank_ = 3;
+
+		match.length_ = path.length();
+		match.index_ = i;
+		matches.append(match);
+	}
+}
+
+/**
+ * Finds all paths matching the given shell-style wildcard pattern.
+ * If the pattern contains a directory separator, it is matched against the
+ * end of the path. Otherwise, it is matched against the base name only.
+ * @param  pattern     The wildcard pattern
+ * @param  ignoreCase  Whether the comparison is case-insensitive
+ * @param  matches     Holds the matching paths
+ */
+void PathIndex::wildcardQuery(const QString& pattern, bool ignoreCase,
+                              QVector<Match>& matches) const
+{
+	// Extract the literal parts of the pattern, which can be used to narrow
+	// down the set of candidates.
+	QStringList literals;
+	QString literal;
+	for (int i = 0; i < pattern.length(); i++) {
+		QChar c = pattern[i];
+		if ((c == '*') || (c == '?') || (c == '[')) {
+			if (literal.length() >= 3)
+				literals << literal.toLower();
+			literal.clear();
+
+			// Skip a character set.
+			if (c == '[') {
+				while ((i < pattern.length()) && (pattern[i] != ']'))
+					i++;
+			}
+		}
+		else {
+			literal += c;
+		}
+	}
+	if (literal.length() >= 3)
+		literals << literal.toLower();
+
+	bool matchPath = pattern.contains(QDir::separator());
+	QRegExp exp(matchPath ? QString("*") + pattern : pattern,
+	            ignoreCase ? Qt::CaseInsensitive : Qt::CaseSensitive,
+	            QRegExp::Wildcard);
+
+	QVector<int> cands;
+	bool filtered = candidates(literals, cands);
+	int count = filtered ? cands.size() : pathList_.size();
+
+	for (int c = 0; c < count; c++) {
+		int i = filtered ? cands[c] : c;
+		const QString& path = pathList_[i];
+		if (!exp.exactMatch(matchPath ? path : path.mid(baseNamePos_[i])))
+			continue;
+
+		Match match;
+		match.rank_ = 0;
+		match.length_ = path.length();
+		match.index_ = i;
+		matches.append(match);
+	}
+}
+
+/**
+ * Finds all paths whose base name contains the characters of the given
+ * string, in order.
+ * Such matches are always ranked below substring matches.
+ * @param  needle   The case-folded string to look for
+ * @param  matches  Holds the matching paths
+ */
+void PathIndex::fuzzyQuery(const QString& needle,
+                           QVector<Match>& matches) const
+{
+	for (int i = 0; i < foldedList_.size(); i++) {
+		int score = fuzzyScore(foldedList_[i], baseNamePos_[i], needle);
+		if (score < 0)
+			continue;
+
+		// Higher scores are better, so negate the score to get a rank.
+		// Offsetting the rank ensures fuzzy matches come after all other
+		// types.
+		Match match;
+		match.rank_ = 0x10000 - score;
+		match.length_ = foldedList_[i].length();
+		match.index_ = i;
+		matches.append(match);
+	}
+}
+
+/**
+ * Scores a fuzzy match of a string against the base name of a path.
+ * Consecutive characters and characters at the beginning of words increase
+ * the score, while long base names decrease it.
+ * @param  path     The case-folded path
+ * @param  basePos  The position of the base name in the path
+ * @param  needle   The case-folded string to look for
+ * @return The score of the match (higher is better), -1 if the characters of
+ *         the string do not appear in order in the base name
+ */
+int PathIndex::fuzzyScore(const QString& path, int basePos,
+                          const QString& needle) const
+{
+	int score = 0;
+	int prev = -2;
+	int j = 0;
+
+	for (int i = basePos; (i < path.length()) && (j < needle.length()); i++) {
+		if (path[i] != needle[j])
+			continue;
+
+		score++;
+		if (i == prev + 1)
+			score += 4;
+		if ((i == basePos) || !path[i - 1].isLetterOrNumber())
+			score += 2;
+
+		prev = i;
+		j++;
+	}
+
+	if (j < needle.length())
+		return -1;
+
+	return qMax(score - ((path.length() - basePos) / 4), 0);
+}
+
+/**
+ * Orders matches by rank, then by path length and finally by the order in
+ * which paths appear in the code base.
+ * @param  m1
+ * @param  m2
+ * @return true if m1 should come before m2, false otherwise
+ */
+bool PathIndex::matchLessThan(const Match& m1, const Match& m2)
+{
+	if (m1.rank_ != m2.rank_)
+		return m1.rank_ < m2.rank_;
+
+	if (m1.length_ != m2.length_)
+		return m1.length_ < m2.length_;
+
+	return m1.index_ < m2.index_;
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,145 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_PATHINDEX_H__
+#define __CORE_PATHINDEX_H__
+
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "globals.h"
+#include "codebase.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * An in-memory index of the file paths in a code base.
+ * Used to answer file-name queries without running an external process.
+ * Each path is broken into overlapping trigrams (case-folded), and every
+ * trigram keeps a sorted list of the paths in which it appears. A query is
+ * answered by intersecting the lists for the trigrams of the pattern's
+ * literal parts, and then verifying the (usually small) candidate set.
+ * Three kinds of patterns are supported:
+ * - Substrings (the default), matched anywhere in the path;
+ * - Shell-style wildcards (if the pattern contains any of '*', '?' or '['),
+ *   matched against the base name, or against the path suffix if the pattern
+ *   contains a directory separator;
+ * - Fuzzy base names, used when a substring search yields no results: the
+ *   characters of the pattern need to appear in order in the base name.
+ * Results are ranked, such that exact base name matches come first, followed
+ * by base name prefixes, base name substrings and finally matches elsewhere in
+ * the path.
+ * @author Elad Lahav
+ */
+class PathIndex
+{
+public:
+	PathIndex();
+	~PathIndex();
+
+	void build(const Codebase&);
+	void update(const QStringList&, const QStringList&);
+	void clear();
+	void query(const Query&, LocationList&, int maxResults = 1000) const;
+
+	/**
+	 * @return true if no paths are indexed, false otherwise
+	 */
+	bool isEmpty() const { return pathList_.isEmpty(); }
+
+	/**
+	 * @return The number of indexed paths
+	 */
+	int size() const { return pathList_.size(); }
+
+	/**
+	 * @return All indexed paths
+	 */
+	const QStringList& paths() const { return pathList_; }
+
+private:
+	/**
+	 * The indexed paths, as given by the code base.
+	 */
+	QStringList pathList_;
+
+	/**
+	 * Case-folded copies of the indexed paths.
+	 */
+	QVector<QString> foldedList_;
+
+	/**
+	 * For each path, the position of the first character of the base name.
+	 */
+	QVector<int> baseNamePos_;
+
+	/**
+	 * Maps each trigram to a sorted list of path indices.
+	 */
+	QHash<quint64, QVector<int> > trigrams_;
+
+	/**
+	 * A candidate result, used for ranking.
+	 */
+	struct Match
+	{
+		int rank_;
+		int length_;
+		int index_;
+	};
+
+	void addPath(const QString&);
+	bool candidates(const QStringList&, QVector<int>&) const;
+	void substringQuery(const QString&, bool, QVector<Match>&) const;
+	void wildcardQuery(const QString&, bool, QVector<Match>&) const;
+	void fuzzyQuery(const QString&, QVector<Match>&) const;
+	int fuzzyScore(const QString&, int, const QString&) const;
+
+	static inline quint64 trigram(const QChar* str) {
+		return (quint64(str[0].unicode()) << 32)
+		       | (quint64(str[1].unicode()) << 16)
+		       | quint64(str[2].unicode());
+	}
+
+	static bool matchLessThan(const Match&, const Match&);
+
+	struct AddPathCallback : public Callback<const QString&>
+	{
+		PathIndex* index_;
+
+		AddPathCallback(PathIndex* index) : index_(index) {}
+
+		void call(const QString& path) {
+			index_->addPath(path);
+		}
+	};
+
+	friend struct AddPathCallback;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_PATHINDEX_H__
@@ -18,6 +18,7 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  ***************************************************************************/
 
+#include <QDebug>
 #include "process.h"
 
 namespace KScope
@@ -26,8 +27,20 @@ namespace KScope
 namespace Core
 {
 
-Process::Process(QObject* parent) : QProcess(parent)
+/**
+ * The default number of milliseconds a process may run without producing
+ * output before it is killed.
+ */
+int Process::defaultIdleTimeout_ = 120000;
+
+Process::Process(QObject* parent) : QProcess(parent), deleteOnExit_(false),
+	cancelled_(false), timedOut_(false), idleTimeout_(defaultIdleTimeout_)
 {
+	deadlineTimer_.setSingleShot(true);
+	idleTimer_.setSingleShot(true);
+	connect(&deadlineTimer_, SIGNAL(timeout()), this, SLOT(deadlineExpired()));
+	connect(&idleTimer_, SIGNAL(timeout()), this, SLOT(idleExpired()));
+
 	connect(this, SIGNAL(readyReadStandardOutput()), this,
 	        SLOT(readStandardOutput()));
 	connect(this, SIGNAL(finished(int, QProcess::ExitStatus)), this,
@@ -47,10 +60,83 @@ void Process::setDeleteOnExit()
 	deleteOnExit_ = true;
 }
 
+/**
+ * Limits the time the process is allowed to run.
+ * Must be called before the process is started.
+ * @param  msec  The maximal run time, in milliseconds, or 0 for no limit
+ */
+void Process::setDeadline(int msec)
+{
+	deadlineTimer_.setInterval(msec);
+}
+
+/**
+ * Sets the time the process may run without producing output.
+ * Must be called before the process is started.
+ * @param  msec  The idle time limit, in milliseconds, or 0 for no limit
+ */
+void Process::setIdleTimeout(int msec)
+{
+	idleTimeout_ = msec;
+}
+
+/**
+ * Stops the process at the request of the user.
+ * Output that was not yet parsed is discarded.
+ */
+void Process::cancel()
+{
+	if (state() == QProcess::NotRunning)
+		return;
+
+	cancelled_ = true;
+	kill();
+}
+
+/**
+ * Kills a process that has exceeded one of its time limits.
+ * @param  reason  A description of the limit, for the log
+ */
+void Process::timeOut(const char* reason)
+{
+	if (state() == QProcess::NotRunning || cancelled_)
+		return;
+
+	qWarning() << "Killing" << program() << arguments() << reason;
+	timedOut_ = true;
+	kill();
+}
+
+/**
+ * Called when the process runs past its deadline.
+ */
+void Process::deadlineExpired()
+{
+	timeOut("(deadline expired)");
+}
+
+/**
+ * Called when the process does not produce output for too long.
+ */
+void Process::idleExpired()
+{
+	timeOut("(no progress)");
+}
+
 void Process::readStandardOutput()
 {
 	// Read from standard output.
-	stdOut_ += readAllStandardOutput();
+	QByteArray data = readAllStandardOutput();
+
+	// Stop parsing once the process is being killed.
+	if (cancelled_ || timedOut_)
+		return;
+
+	// Any output is considered progress.
+	if (idleTimer_.isActive())
+		idleTimer_.start();
+
+	stdOut_ += data;
 
 	//Have to remove CR, otherwise cscope result parser would fail
 	stdOut_.remove("\r", Qt::CaseSensitive);
@@ -80,8 +166,20 @@ void Process::handleError(QProcess::ProcessError code)
 void Process::handleStateChange(QProcess::ProcessState state)
 {
 	qDebug() << "Process state" << state;
-	if (state == QProcess::NotRunning && deleteOnExit_)
-		deleteLater();
+	if (state == QProcess::Running) {
+		// Arm the watchdog.
+		if (deadlineTimer_.interval() > 0)
+			deadlineTimer_.start();
+
+		if (idleTimeout_ > 0)
+			idleTimer_.start(idleTimeout_);
+	}
+	else if (state == QProcess::NotRunning) {
+		deadlineTimer_.stop();
+		idleTimer_.stop();
+		if (deleteOnExit_)
+			deleteLater();
+	}
 }
 
 }
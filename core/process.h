@@ -22,6 +22,7 @@
 #define __CORE_PROCESS_H
 
 #include <QProcess>
+#include <QTimer>
 #include "statemachine.h"
 
 namespace KScope
@@ -32,6 +33,12 @@ namespace Core
 
 /**
  * A process with a state-machine parser.
+ * The process is watched by two timers: an optional deadline, after which it
+ * is killed regardless of its progress, and an idle timer, which kills a
+ * process that has not produced any output for a while (e.g., a hung Cscope).
+ * In both cases the process is reported as timed-out, and its remaining output
+ * is ignored. The idle timer should be disabled for processes that may be
+ * silent for long periods while still making progress, such as text searches.
  * @author  Elad Lahav
  */
 class Process : public QProcess, public Parser::StateMachine
@@ -43,6 +50,21 @@ public:
 	~Process();
 
 	void setDeleteOnExit();
+	void setDeadline(int msec);
+	void setIdleTimeout(int msec);
+	void cancel();
+
+	/**
+	 * @return true if the process was stopped by cancel()
+	 */
+	bool cancelled() const { return cancelled_; }
+
+	/**
+	 * @return true if the process was killed by the deadline or idle timers
+	 */
+	bool timedOut() const { return timedOut_; }
+
+	static int defaultIdleTimeout_;
 
 signals:
 	void parseError();
@@ -55,10 +77,19 @@ protected slots:
 private:
 	QString stdOut_;
 	bool deleteOnExit_;
+	bool cancelled_;
+	bool timedOut_;
+	int idleTimeout_;
+	QTimer deadlineTimer_;
+	QTimer idleTimer_;
+
+	void timeOut(const char* reason);
 
 private slots:
 	void readStandardOutput();
 	void readStandardError();
+	void deadlineExpired();
+	void idleExpired();
 };
 
 }
@@ -0,0 +1,126 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "querycache.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ * @param  maxLocations  The total number of locations kept in the cache
+ */
+QueryCache::QueryCache(int maxLocations) : cache_(maxLocations)
+{
+}
+
+/**
+ * Class destructor.
+ */
+QueryCache::~QueryCache()
+{
+}
+
+/**
+ * Looks up the results of a query.
+ * @param  query    The query to look for
+ * @param  locList  Holds the results, if found
+ * @return true if the query is in the cache, false otherwise
+ */
+bool QueryCache::find(const Query& query, LocationList& locList) const
+{
+	LocationList* cached = cache_.object(key(query));
+	if (!cached)
+		return false;
+
+	locList = *cached;
+	return true;
+}
+
+/**
+ * Stores the results of a query.
+ * Results larger than the capacity of the cache are not stored.
+ * @param  query    The query
+ * @param  locList  The complete list of results
+ */
+void QueryCache::insert(const Query& query, const LocationList& locList)
+{
+	// An empty result still costs an entry.
+	int cost = qMax(locList.size(), 1);
+	cache_.insert(key(query), new LocationList(locList), cost);
+}
+
+/**
+ * Removes all results from the cache.
+ */
+void QueryCache::clear()
+{
+	cache_.clear();
+}
+
+/**
+ * Generates a string that uniquely identifies a query.
+ * @param  query  The query
+ * @return The identifying string
+ */
+QString QueryCache::key(const Query& query)
+{
+	QString result = QString("%1:%2:").arg(query.type_).arg(query.flags_);
+
+	// Prefixes are sorted, as their order does not affect the results.
+	QStringList prefixes = query.pathPrefixes_;
+	prefixes.sort();
+	result += prefixes.join("\n") + ":" + query.pattern_;
+	return result;
+}
+
+/**
+ * Determines whether the results of a query may be cached.
+ * Only queries answered from the database (or from indices derived from it)
+ * are cached, as their results change only when the database does. Text
+ * searches and local tags read the current contents of files, which may be
+ * modified at any time.
+ * @param  query  The query to check
+ * @return true if the results can be cached, false otherwise
+ */
+bool QueryCache::isCacheable(const Query& query)
+{
+	switch (query.type_) {
+	case Query::Definition:
+	case Query::References:
+	case Query::CalledFunctions:
+	case Query::CallingFunctions:
+	case Query::FindFile:
+	case Query::IncludingFiles:
+	case Query::IncludeClosure:
+	case Query::Metrics:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_QUERYCACHE_H__
+#define __CORE_QUERYCACHE_H__
+
+#include <QCache>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Keeps the results of recent queries.
+ * Results are stored with a cost equal to the number of locations they hold,
+ * and the least-recently used ones are evicted once the total exceeds the
+ * cache's capacity. The cache has no notion of the database's state: owners
+ * need to clear it whenever the database or the code base changes.
+ * @author Elad Lahav
+ */
+class QueryCache
+{
+public:
+	QueryCache(int maxLocations = 200000);
+	~QueryCache();
+
+	bool find(const Query& query, LocationList& locList) const;
+	void insert(const Query& query, const LocationList& locList);
+	void clear();
+
+	static QString key(const Query& query);
+	static bool isCacheable(const Query& query);
+
+private:
+	/**
+	 * Query results, indexed by the query key.
+	 */
+	QCache<QString, LocationList> cache_;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_QUERYCACHE_H__
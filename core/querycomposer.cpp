@@ -0,0 +1,287 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QSet>
+#include <QPair>
+#include "querycomposer.h"
+#include "exception.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * @param  loc  A query result
+ * @return The file and line of the result
+ */
+static QPair<QString, uint> locationKey(const Location& loc)
+{
+	return qMakePair(loc.file_, loc.line_);
+}
+
+/**
+ * @param  loc  A query result
+ * @return The scope of the result
+ */
+static QString scopeKey(const Location& loc)
+{
+	return loc.tag_.scope_;
+}
+
+/**
+ * @param  loc  A query result
+ * @return The file and the text of the line of the result
+ */
+static QPair<QString, QString> textKey(const Location& loc)
+{
+	return qMakePair(loc.file_, loc.text_.simplified());
+}
+
+/**
+ * Marks a list of locations with a label.
+ * @param  locList  The list to mark
+ * @param  label    The label, shown as the project of each location
+ */
+static void setLabel(LocationList& locList, const QString& label)
+{
+	LocationList::Iterator itr;
+	for (itr = locList.begin(); itr != locList.end(); ++itr)
+		(*itr).project_ = label;
+}
+
+/**
+ * Performs a set operation on two lists of locations.
+ * @param  op      The operation
+ * @param  left    The first set
+ * @param  right   The second set
+ * @param  key     Extracts the comparison key from a location
+ * @param  result  Holds the result of the operation
+ */
+template<class KeyT>
+static void join(QueryComposer::Operation op, const LocationList& left,
+                 const LocationList& right, KeyT (*key)(const Location&),
+                 LocationList& result)
+{
+	QSet<KeyT> keys;
+
+	switch (op) {
+	case QueryComposer::Intersection:
+	case QueryComposer::Difference:
+		// Hash the keys of the second set, and probe with the first.
+		keys.reserve(right.size());
+		foreach (const Location& loc, right)
+			keys.insert(key(loc));
+
+		foreach (const Location& loc, left) {
+			if (keys.contains(key(loc)) == (op == QueryComposer::Intersection))
+				result.append(loc);
+		}
+		break;
+
+	case QueryComposer::Changes:
+		// Handled by two Difference operations.
+		break;
+
+	case QueryComposer::Union:
+		// Add rows from both sets, skipping keys that were already seen.
+		keys.reserve(left.size() + right.size());
+		foreach (const Location& loc, left + right) {
+			KeyT k = key(loc);
+			if (!keys.contains(k)) {
+				keys.insert(k);
+				result.append(loc);
+			}
+		}
+		break;
+	}
+}
+
+/**
+ * Class constructor.
+ * @param  engine  The engine used to run the sub-queries
+ * @param  parent  Parent object
+ */
+QueryComposer::QueryComposer(const Engine& engine, QObject* parent)
+	: QObject(parent), leftEngine_(engine), rightEngine_(engine), conn_(NULL),
+	  left_(this), right_(this), op_(Intersection), key_(LocationKey),
+	  pending_(0), aborted_(false)
+{
+}
+
+/**
+ * Class constructor.
+ * @param  leftEngine   The engine used to run the first sub-query
+ * @param  rightEngine  The engine used to run the second sub-query
+ * @param  parent       Parent object
+ */
+QueryComposer::QueryComposer(const Engine& leftEngine,
+                             const Engine& rightEngine, QObject* parent)
+	: QObject(parent), leftEngine_(leftEngine), rightEngine_(rightEngine),
+	  conn_(NULL), left_(this), right_(this), op_(Intersection),
+	  key_(LocationKey), pending_(0), aborted_(false)
+{
+}
+
+/**
+ * Class destructor.
+ */
+QueryComposer::~QueryComposer()
+{
+}
+
+/**
+ * Sets the labels used to mark the results of a Changes operation.
+ * @param  left   The label of rows found only by the first query
+ * @param  right  The label of rows found only by the second query
+ */
+void QueryComposer::setLabels(const QString& left, const QString& right)
+{
+	leftLabel_ = left;
+	rightLabel_ = right;
+}
+
+/**
+ * Starts both sub-queries.
+ * @param  conn   Receives the combined results
+ * @param  left   The first query
+ * @param  right  The second query
+ * @param  op     The set operation to perform
+ * @param  key    The row comparison key
+ * @throw  Exception
+ */
+void QueryComposer::compose(Engine::Connection* conn, const Query& left,
+                            const Query& right, Operation op, Key key)
+{
+	conn_ = conn;
+	conn_->setCtrlObject(this);
+	op_ = op;
+	key_ = key;
+	pending_ = 2;
+
+	try {
+		leftEngine_.query(&left_, left);
+	}
+	catch (Exception* e) {
+		// Nothing was started.
+		conn_->setCtrlObject(NULL);
+		deleteLater();
+		throw e;
+	}
+
+	try {
+		rightEngine_.query(&right_, right);
+	}
+	catch (Exception* e) {
+		// Wait for the first query to terminate before deleting the object,
+		// but do not report anything.
+		conn_->setCtrlObject(NULL);
+		conn_ = NULL;
+		left_.stop();
+		branchDone(true);
+		throw e;
+	}
+}
+
+/**
+ * Stops both sub-queries.
+ */
+void QueryComposer::stop()
+{
+	left_.stop();
+	right_.stop();
+}
+
+/**
+ * Called whenever a sub-query terminates.
+ * Once both sub-queries terminate, the results are combined and delivered.
+ * @param  aborted  true if the sub-query terminated abnormally
+ */
+void QueryComposer::branchDone(bool aborted)
+{
+	if (aborted)
+		aborted_ = true;
+
+	if (--pending_ > 0)
+		return;
+
+	if (conn_) {
+		conn_->setCtrlObject(NULL);
+
+		if (aborted_) {
+			conn_->onAborted();
+		}
+		else {
+			LocationList result;
+			if (op_ == Changes) {
+				// Rows missing from either side, marked by their origin.
+				LocationList removed, added;
+				joinByKey(Difference, left_.locList_, right_.locList_,
+				          removed);
+				joinByKey(Difference, right_.locList_, left_.locList_, added);
+				setLabel(removed, leftLabel_);
+				setLabel(added, rightLabel_);
+				result = removed + added;
+			}
+			else {
+				joinByKey(op_, left_.locList_, right_.locList_, result);
+			}
+
+			if (!result.isEmpty())
+				conn_->onDataReady(result);
+
+			conn_->onFinished();
+		}
+	}
+
+	// The sub-query may still access its branch, so deletion is deferred.
+	deleteLater();
+}
+
+/**
+ * Performs the set operation using the selected key.
+ * @param  op      The operation
+ * @param  left    The first set
+ * @param  right   The second set
+ * @param  result  Holds the result of the operation
+ */
+void QueryComposer::joinByKey(Operation op, const LocationList& left,
+                              const LocationList& right,
+                              LocationList& result) const
+{
+	switch (key_) {
+	case LocationKey:
+		join(op, left, right, locationKey, result);
+		break;
+
+	case ScopeKey:
+		join(op, left, right, scopeKey, result);
+		break;
+
+	case TextKey:
+		join(op, left, right, textKey, result);
+		break;
+	}
+}
+
+} // namespace Core
+
+} // namespace KScope
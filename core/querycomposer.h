@@ -0,0 +1,181 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_QUERYCOMPOSER_H__
+#define __CORE_QUERYCOMPOSER_H__
+
+#include <QObject>
+#include "engine.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Combines the results of two queries.
+ * Both queries are started concurrently, either on the same engine or on two
+ * different ones (e.g., the current database and a snapshot). Once both
+ * terminate, the result sets are joined, and the combined result is delivered
+ * to the connection object, as if it came from a single query.
+ * Rows are compared by a key, which is either the location of the result
+ * (file and line), or its scope (e.g., the calling function). Joins are done
+ * by hashing the keys of the second set, so the cost is linear in the size of
+ * the inputs.
+ * The object deletes itself once the operation terminates.
+ * @author Elad Lahav
+ */
+class QueryComposer : public QObject, public Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	/**
+	 * Set operations.
+	 */
+	enum Operation {
+		/** Rows of the first set with a key that appears in the second. */
+		Intersection,
+		/** Rows of both sets, with each key appearing only once. */
+		Union,
+		/** Rows of the first set with a key that does not appear in the
+		    second. */
+		Difference,
+		/** Rows of either set with a key that does not appear in the other.
+		    Each row is marked with the label of the set it came from. */
+		Changes
+	};
+
+	/**
+	 * Row comparison keys.
+	 */
+	enum Key {
+		/** File path and line number. */
+		LocationKey,
+		/** Scope (function) name. */
+		ScopeKey,
+		/** File path and the text of the line, which is not affected by
+		    changes that only move lines. */
+		TextKey
+	};
+
+	QueryComposer(const Engine&, QObject* parent = 0);
+	QueryComposer(const Engine&, const Engine&, QObject* parent = 0);
+	~QueryComposer();
+
+	void setLabels(const QString&, const QString&);
+	void compose(Engine::Connection*, const Query&, const Query&, Operation,
+	             Key);
+	void stop();
+
+private:
+	/**
+	 * Collects the results of one of the sub-queries.
+	 */
+	struct Branch : public Engine::Connection
+	{
+		Branch(QueryComposer* composer) : Engine::Connection(),
+			composer_(composer) {}
+
+		void onDataReady(const LocationList& locList) {
+			locList_ += locList;
+		}
+
+		void onFinished() { composer_->branchDone(false); }
+		void onAborted() { composer_->branchDone(true); }
+		void onProgress(const QString&, uint, uint) {}
+
+		/**
+		 * The owner of this branch.
+		 */
+		QueryComposer* composer_;
+
+		/**
+		 * Results received so far.
+		 */
+		LocationList locList_;
+	};
+
+	/**
+	 * The engine used to run the first sub-query.
+	 */
+	const Engine& leftEngine_;
+
+	/**
+	 * The engine used to run the second sub-query.
+	 */
+	const Engine& rightEngine_;
+
+	/**
+	 * Marks rows of the first set in the results of a Changes operation.
+	 */
+	QString leftLabel_;
+
+	/**
+	 * Marks rows of the second set in the results of a Changes operation.
+	 */
+	QString rightLabel_;
+
+	/**
+	 * The connection to which combined results are delivered.
+	 */
+	Engine::Connection* conn_;
+
+	/**
+	 * Receives the results of the first query.
+	 */
+	Branch left_;
+
+	/**
+	 * Receives the results of the second query.
+	 */
+	Branch right_;
+
+	/**
+	 * The set operation to perform.
+	 */
+	Operation op_;
+
+	/**
+	 * The row comparison key.
+	 */
+	Key key_;
+
+	/**
+	 * The number of sub-queries that are still running.
+	 */
+	int pending_;
+
+	/**
+	 * Whether any of the sub-queries terminated abnormally.
+	 */
+	bool aborted_;
+
+	void branchDone(bool);
+	void joinByKey(Operation, const LocationList&, const LocationList&,
+	               LocationList&) const;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_QUERYCOMPOSER_H__
@@ -0,0 +1,202 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <QFile>
+#include <QTextStream>
+#include "querycache.h"
+#include "queryusage.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * The number of entries kept in the file.
+ * Rarely-used queries beyond this number are forgotten.
+ */
+static const int MaxEntries = 500;
+
+/**
+ * Class constructor.
+ */
+QueryUsage::QueryUsage() : dirty_(false)
+{
+}
+
+/**
+ * Class destructor.
+ */
+QueryUsage::~QueryUsage()
+{
+}
+
+/**
+ * Reads usage counts from a file.
+ * A missing file is not an error, as it is only created once a query is run.
+ * @param  path  The path of the file
+ * @return true if successful, false otherwise
+ */
+bool QueryUsage::load(const QString& path)
+{
+	entryMap_.clear();
+	path_ = path;
+	dirty_ = false;
+
+	QFile file(path_);
+	if (!file.exists())
+		return true;
+
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	QTextStream strm(&file);
+	while (!strm.atEnd()) {
+		QStringList fields = strm.readLine().split('\t');
+		if (fields.size() != 4)
+			continue;
+
+		Entry entry;
+		entry.count_ = fields[0].toUInt();
+		entry.query_ = Query(static_cast<Query::Type>(fields[1].toInt()),
+		                     fields[3], fields[2].toUInt());
+		if (entry.count_ == 0 || !isCounted(entry.query_))
+			continue;
+
+		entryMap_[QueryCache::key(entry.query_)] = entry;
+	}
+
+	return true;
+}
+
+/**
+ * Writes usage counts to the file given to load().
+ * Only the most-used entries are kept.
+ * @return true if successful, false otherwise
+ */
+bool QueryUsage::save()
+{
+	if (!dirty_ || path_.isEmpty())
+		return true;
+
+	QFile file(path_);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate
+	               | QIODevice::Text)) {
+		return false;
+	}
+
+	QList<Entry> entryList = entryMap_.values();
+	std::sort(entryList.begin(), entryList.end(), moreUsed);
+
+	QTextStream strm(&file);
+	for (int i = 0; i < entryList.size() && i < MaxEntries; i++) {
+		const Entry& entry = entryList[i];
+		strm << entry.count_ << '\t' << entry.query_.type_ << '\t'
+		     << entry.query_.flags_ << '\t' << entry.query_.pattern_ << '\n';
+	}
+
+	dirty_ = false;
+	return true;
+}
+
+/**
+ * Counts a query.
+ * @param  query  The query that was run
+ */
+void QueryUsage::record(const Query& query)
+{
+	if (!isCounted(query))
+		return;
+
+	QString key = QueryCache::key(query);
+	QHash<QString, Entry>::Iterator itr = entryMap_.find(key);
+	if (itr == entryMap_.end()) {
+		Entry entry;
+		entry.query_ = query;
+		entry.count_ = 1;
+		entryMap_.insert(key, entry);
+	}
+	else {
+		(*itr).count_++;
+	}
+
+	dirty_ = true;
+}
+
+/**
+ * @param  count  The maximal number of queries to return
+ * @return The most-used queries, in descending order of use
+ */
+QList<Query> QueryUsage::top(int count) const
+{
+	QList<Entry> entryList = entryMap_.values();
+	std::sort(entryList.begin(), entryList.end(), moreUsed);
+
+	QList<Query> queryList;
+	for (int i = 0; i < entryList.size() && i < count; i++)
+		queryList.append(entryList[i].query_);
+
+	return queryList;
+}
+
+/**
+ * Determines whether a query is counted.
+ * Text searches and local tags are not, as the former are expensive to repeat
+ * and the latter depend on the contents of a single file. Restricted queries
+ * are rare, and would rarely be repeated with the same restrictions.
+ * @param  query  The query to check
+ * @return true if the query is counted, false otherwise
+ */
+bool QueryUsage::isCounted(const Query& query)
+{
+	switch (query.type_) {
+	case Query::Definition:
+	case Query::References:
+	case Query::CalledFunctions:
+	case Query::CallingFunctions:
+	case Query::FindFile:
+	case Query::IncludingFiles:
+	case Query::IncludeClosure:
+		break;
+
+	default:
+		return false;
+	}
+
+	return !query.pattern_.isEmpty() && query.pathPrefixes_.isEmpty()
+	       && !query.pattern_.contains('\t') && !query.pattern_.contains('\n');
+}
+
+/**
+ * Sorting function for entries.
+ * @param  entry1  The first entry to compare
+ * @param  entry2  The second entry to compare
+ * @return true if the first entry was used more often than the second
+ */
+bool QueryUsage::moreUsed(const Entry& entry1, const Entry& entry2)
+{
+	return entry1.count_ > entry2.count_;
+}
+
+} // namespace Core
+
+} // namespace KScope
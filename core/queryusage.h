@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_QUERYUSAGE_H__
+#define __CORE_QUERYUSAGE_H__
+
+#include <QHash>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Counts how often each query is run in a project.
+ * Only symbol and file look-ups that cover the entire code base are counted,
+ * as these are the queries worth repeating ahead of time. The counts are
+ * stored in a text file, one query per line, holding the count, the query
+ * type, the query flags and the pattern, separated by tabs.
+ * @author Elad Lahav
+ */
+class QueryUsage
+{
+public:
+	QueryUsage();
+	~QueryUsage();
+
+	bool load(const QString& path);
+	bool save();
+	void record(const Query& query);
+	QList<Query> top(int count) const;
+
+	static bool isCounted(const Query& query);
+
+private:
+	/**
+	 * The number of times a single query was run.
+	 */
+	struct Entry
+	{
+		Query query_;
+		uint count_;
+	};
+
+	/**
+	 * Usage counts, indexed by the query key.
+	 */
+	QHash<QString, Entry> entryMap_;
+
+	/**
+	 * The file holding the counts.
+	 */
+	QString path_;
+
+	/**
+	 * Whether any count has changed since the file was last read or written.
+	 */
+	bool dirty_;
+
+	static bool moreUsed(const Entry& entry1, const Entry& entry2);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_QUERYUSAGE_H__
@@ -78,6 +78,38 @@ void QueryView::query(const Query& query)
 	}
 }
 
+/**
+ * Displays the combined results of two queries.
+ * Composed queries cannot be re-run from the view.
+ * @param  left   The first query
+ * @param  right  The second query
+ * @param  op     The set operation to apply to the results
+ * @param  key    Determines how results are compared
+ */
+void QueryView::compose(const Query& left, const Query& right,
+                        QueryComposer::Operation op, QueryComposer::Key key)
+{
+	// Delete the model data.
+	locationModel()->clear(QModelIndex());
+
+	try {
+		// Get an engine for running the queries.
+		Engine* eng;
+		if ((eng = engine()) != NULL) {
+			// The results have the fields of the first query.
+			query_ = Query();
+			locationModel()->setColumns(eng->queryFields(left.type_));
+
+			QueryComposer* composer = new QueryComposer(*eng);
+			composer->compose(this, left, right, op, key);
+		}
+	}
+	catch (Exception* e) {
+		e->showMessage();
+		delete e;
+	}
+}
+
 /**
  * Creates an XML representation of the view, which can be used for storing the
  * model's data in a file.
@@ -93,6 +125,11 @@ void QueryView::toXML(QDomDocument& doc, QDomElement& viewElem) const
 	queryElem.setAttribute("type", QString::number(query_.type_));
 	queryElem.setAttribute("flags", QString::number(query_.flags_));
 	queryElem.appendChild(doc.createCDATASection(query_.pattern_));
+	foreach (const QString& prefix, query_.pathPrefixes_) {
+		QDomElement scopeElem = doc.createElement("Scope");
+		scopeElem.appendChild(doc.createTextNode(prefix));
+		queryElem.appendChild(scopeElem);
+	}
 	viewElem.appendChild(queryElem);
 
 	LocationView::toXML(doc, viewElem);
@@ -115,6 +152,12 @@ void QueryView::fromXML(const QDomElement& viewElem)
 	query_.flags_ = queryElem.attribute("flags").toUInt();
 	query_.pattern_ = queryElem.childNodes().at(0).toCDATASection().data();
 
+	// Get the directories to which the query is restricted.
+	query_.pathPrefixes_.clear();
+	QDomNodeList scopeNodes = queryElem.elementsByTagName("Scope");
+	for (int i = 0; i < scopeNodes.size(); i++)
+		query_.pathPrefixes_ << scopeNodes.at(i).toElement().text();
+
 	LocationView::fromXML(viewElem);
 }
 
@@ -151,6 +194,44 @@ void QueryView::onProgress(const QString& text, uint cur, uint total)
 		emit needToShow();
 }
 
+/**
+ * Displays the results that differ between two versions of the database.
+ * Results are compared by file and line text, so that lines that were only
+ * moved are not reported. Each result is marked with the version in which it
+ * was found.
+ * @param  query       The query to run
+ * @param  oldEngine   The engine of the older version
+ * @param  oldLabel    Marks results found only in the older version
+ * @param  newLabel    Marks results found only in the current version
+ */
+void QueryView::compare(const Query& query, const Engine& oldEngine,
+                        const QString& oldLabel, const QString& newLabel)
+{
+	// Delete the model data.
+	locationModel()->clear(QModelIndex());
+
+	try {
+		// Get an engine for running the query on the current version.
+		Engine* eng;
+		if ((eng = engine()) != NULL) {
+			query_ = Query();
+			QList<Location::Fields> fieldList = eng->queryFields(query.type_);
+			if (!fieldList.contains(Location::Project))
+				fieldList.prepend(Location::Project);
+			locationModel()->setColumns(fieldList);
+
+			QueryComposer* composer = new QueryComposer(oldEngine, *eng);
+			composer->setLabels(oldLabel, newLabel);
+			composer->compose(this, query, query, QueryComposer::Changes,
+			                  QueryComposer::TextKey);
+		}
+	}
+	catch (Exception* e) {
+		e->showMessage();
+		delete e;
+	}
+}
+
 /**
  * Called by the engine when a query terminates normally.
  */
@@ -182,6 +263,19 @@ void QueryView::onFinished()
 	}
 }
 
+/**
+ * Called by the engine when a query is stopped by a time limit.
+ * The partial results are shown, but a single result is not selected
+ * automatically, as it may not be the only match.
+ */
+void QueryView::onTimedOut()
+{
+	bool autoSelect = autoSelectSingleResult_;
+	autoSelectSingleResult_ = false;
+	onFinished();
+	autoSelectSingleResult_ = autoSelect;
+}
+
 /**
  * Called by the engine when a query terminates abnormally.
  */
@@ -225,7 +319,9 @@ void QueryView::queryTreeItem(const QModelIndex& index)
 		Engine* eng;
 		if ((eng = engine()) != NULL) {
 			queryIndex_ = srcIndex;
-			eng->query(this, Query(query_.type_, loc.tag_.scope_));
+			Query subQuery(query_.type_, loc.tag_.scope_);
+			subQuery.pathPrefixes_ = query_.pathPrefixes_;
+			eng->query(this, subQuery);
 		}
 	}
 	catch (Exception* e) {
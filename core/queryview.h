@@ -24,6 +24,7 @@
 #include "locationview.h"
 #include "globals.h"
 #include "engine.h"
+#include "querycomposer.h"
 
 namespace KScope
 {
@@ -62,9 +63,19 @@ public:
 	~QueryView();
 
 	void query(const Query&);
+	void compose(const Query&, const Query&, QueryComposer::Operation,
+	             QueryComposer::Key);
+	void compare(const Query&, const Engine&, const QString&, const QString&);
 	virtual void toXML(QDomDocument&, QDomElement&) const;
 	virtual void fromXML(const QDomElement&);
 
+	/**
+	 * Composed and compared results are not associated with a single query,
+	 * and so cannot be stored in a session.
+	 * @return true if the view holds the results of a single query
+	 */
+	bool hasQuery() const { return query_.type_ != Query::Invalid; }
+
 	/**
 	 * In the case the query returns only a single location, determines whether
 	 * this location should be selected automatically.
@@ -78,6 +89,7 @@ public:
 	virtual void onDataReady(const LocationList&);
 	virtual void onFinished();
 	virtual void onAborted();
+	virtual void onTimedOut();
 	virtual void onProgress(const QString&, uint, uint);
 
 protected:
@@ -0,0 +1,405 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QObject>
+#include <QFile>
+#include <QSaveFile>
+#include <QHash>
+#include <QRegExp>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include "rename.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Verifies the results in a single file.
+ * Used for handling all files concurrently.
+ */
+struct VerifyFile
+{
+	VerifyFile(const Rename& rename) : rename_(rename) {}
+
+	void operator()(Rename::FileEdit& file) const {
+		rename_.verifyFile(file);
+	}
+
+	const Rename& rename_;
+};
+
+/**
+ * Writes the edits to a single file.
+ * Used for handling all files concurrently.
+ */
+struct ApplyFile
+{
+	ApplyFile(const Rename& rename) : rename_(rename) {}
+
+	void operator()(Rename::FileEdit& file) const {
+		rename_.applyFile(file);
+	}
+
+	const Rename& rename_;
+};
+
+/**
+ * @param  c  A character
+ * @return true if the character can be a part of a symbol name, false
+ *         otherwise
+ */
+static inline bool isNameChar(char c)
+{
+	return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))
+	       || ((c >= '0') && (c <= '9')) || (c == '_');
+}
+
+/**
+ * Class constructor.
+ * @param  oldName  The name to replace
+ * @param  newName  The replacement name
+ */
+Rename::Rename(const QString& oldName, const QString& newName)
+	: oldName_(oldName), newName_(newName), oldBytes_(oldName.toLocal8Bit()),
+	  newBytes_(newName.toLocal8Bit())
+{
+}
+
+/**
+ * Class destructor.
+ */
+Rename::~Rename()
+{
+}
+
+/**
+ * Starts checking the results of a References query.
+ * The returned future must finish before any other method is called.
+ * @param  locList  The query results
+ * @param  exclude  Files that must not be changed (e.g., files with unsaved
+ *                  changes in an editor)
+ * @return A future for monitoring the progress of the operation
+ */
+QFuture<void> Rename::verify(const LocationList& locList,
+                             const QStringList& exclude)
+{
+	// Group the results by file.
+	QHash<QString, int> fileMap;
+	fileList_.clear();
+	foreach (const Location& loc, locList) {
+		if (!loc.isValid() || (loc.line_ == 0))
+			continue;
+
+		QHash<QString, int>::ConstIterator itr = fileMap.find(loc.file_);
+		if (itr == fileMap.end()) {
+			FileEdit file;
+			file.path_ = loc.file_;
+			file.changed_ = false;
+			if (exclude.contains(loc.file_)) {
+				file.error_ = QObject::tr("The file has unsaved changes in an "
+				                          "editor");
+			}
+
+			fileList_.append(file);
+			itr = fileMap.insert(loc.file_, fileList_.size() - 1);
+		}
+
+		fileList_[*itr].lines_.append(loc.line_);
+	}
+
+	// A line may hold more than one reference.
+	QVector<FileEdit>::Iterator itr;
+	for (itr = fileList_.begin(); itr != fileList_.end(); ++itr) {
+		QVector<uint>& lines = (*itr).lines_;
+		std::sort(lines.begin(), lines.end());
+		lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+	}
+
+	return QtConcurrent::map(fileList_, VerifyFile(*this));
+}
+
+/**
+ * Starts writing the verified edits.
+ * Files that could not be verified are left untouched.
+ * @return A future for monitoring the progress of the operation
+ */
+QFuture<void> Rename::apply()
+{
+	return QtConcurrent::map(fileList_, ApplyFile(*this));
+}
+
+/**
+ * Describes the verified edits.
+ * @param  locList  Holds a location for each edited line, with the text of the
+ *                  line after the edit
+ */
+void Rename::preview(LocationList& locList) const
+{
+	QVector<FileEdit>::ConstIterator fileItr;
+	for (fileItr = fileList_.begin(); fileItr != fileList_.end(); ++fileItr) {
+		if (!(*fileItr).error_.isEmpty())
+			continue;
+
+		QVector<LineEdit>::ConstIterator editItr;
+		for (editItr = (*fileItr).edits_.begin();
+		     editItr != (*fileItr).edits_.end();
+		     ++editItr) {
+			Location loc((*fileItr).path_, (*editItr).line_,
+			             (*editItr).column_);
+			loc.tag_.name_ = newName_;
+			loc.text_ = QString::fromLocal8Bit((*editItr).newText_)
+			            .trimmed();
+			locList.append(loc);
+		}
+	}
+}
+
+/**
+ * Describes the results that cannot be handled.
+ * @param  locList  Holds a location for each file that cannot be changed, and
+ *                  for each reported line on which the name was not found
+ */
+void Rename::problems(LocationList& locList) const
+{
+	QVector<FileEdit>::ConstIterator fileItr;
+	for (fileItr = fileList_.begin(); fileItr != fileList_.end(); ++fileItr) {
+		if (!(*fileItr).error_.isEmpty()) {
+			Location loc((*fileItr).path_);
+			loc.text_ = (*fileItr).error_;
+			locList.append(loc);
+			continue;
+		}
+
+		foreach (uint line, (*fileItr).rejected_) {
+			Location loc((*fileItr).path_, line);
+			loc.text_ = QObject::tr("'%1' not found on this line")
+			            .arg(oldName_);
+			locList.append(loc);
+		}
+	}
+}
+
+/**
+ * @return The number of lines to be edited in files that can be changed
+ */
+int Rename::editCount() const
+{
+	int count = 0;
+	QVector<FileEdit>::ConstIterator itr;
+	for (itr = fileList_.begin(); itr != fileList_.end(); ++itr) {
+		if ((*itr).error_.isEmpty())
+			count += (*itr).edits_.size();
+	}
+
+	return count;
+}
+
+/**
+ * @return The files written by apply()
+ */
+QStringList Rename::changedFiles() const
+{
+	QStringList files;
+	QVector<FileEdit>::ConstIterator itr;
+	for (itr = fileList_.begin(); itr != fileList_.end(); ++itr) {
+		if ((*itr).changed_)
+			files.append((*itr).path_);
+	}
+
+	return files;
+}
+
+/**
+ * @param  name  A symbol name
+ * @return true if the name can be used as a replacement, false otherwise
+ */
+bool Rename::isValidName(const QString& name)
+{
+	static QRegExp nameRE("[A-Za-z_][A-Za-z0-9_]*");
+	return nameRE.exactMatch(name);
+}
+
+/**
+ * Finds the reported lines in a file, and creates the edits for each.
+ * Runs in a worker thread.
+ * @param  file  The file to check
+ */
+void Rename::verifyFile(FileEdit& file) const
+{
+	if (!file.error_.isEmpty())
+		return;
+
+	QFile in(file.path_);
+	if (!in.open(QIODevice::ReadOnly)) {
+		file.error_ = QObject::tr("Failed to read the file");
+		return;
+	}
+
+	QByteArray data = in.readAll();
+	in.close();
+
+	uint line = 1;
+	int pos = 0;
+	foreach (uint target, file.lines_) {
+		// Advance to the beginning of the reported line.
+		while ((line < target) && (pos >= 0)) {
+			pos = data.indexOf('\n', pos);
+			if (pos >= 0) {
+				pos++;
+				line++;
+			}
+		}
+
+		if ((pos < 0) || (pos >= data.size())) {
+			file.rejected_.append(target);
+			continue;
+		}
+
+		int end = data.indexOf('\n', pos);
+		if (end < 0)
+			end = data.size();
+
+		LineEdit edit;
+		edit.line_ = target;
+		edit.oldText_ = data.mid(pos, end - pos);
+		if (replace(edit.oldText_, edit.newText_, edit.column_) > 0)
+			file.edits_.append(edit);
+		else
+			file.rejected_.append(target);
+	}
+}
+
+/**
+ * Writes the edits to a file.
+ * The file is left untouched if any of the edited lines changed since the
+ * file was verified.
+ * Runs in a worker thread.
+ * @param  file  The file to change
+ */
+void Rename::applyFile(FileEdit& file) const
+{
+	if (!file.error_.isEmpty() || file.edits_.isEmpty() || file.changed_)
+		return;
+
+	QFile in(file.path_);
+	if (!in.open(QIODevice::ReadOnly)) {
+		file.error_ = QObject::tr("Failed to read the file");
+		return;
+	}
+
+	QByteArray data = in.readAll();
+	in.close();
+
+	// Copy the contents, replacing the edited lines.
+	QByteArray result;
+	result.reserve(data.size() + file.edits_.size()
+	               * qMax(0, newBytes_.size() - oldBytes_.size()));
+
+	uint line = 1;
+	int pos = 0;
+	int copied = 0;
+	foreach (const LineEdit& edit, file.edits_) {
+		while ((line < edit.line_) && (pos >= 0)) {
+			pos = data.indexOf('\n', pos);
+			if (pos >= 0) {
+				pos++;
+				line++;
+			}
+		}
+
+		int end = (pos < 0) ? -1 : data.indexOf('\n', pos);
+		if ((pos >= 0) && (end < 0))
+			end = data.size();
+
+		if ((pos < 0)
+		    || (QByteArray::fromRawData(data.constData() + pos, end - pos)
+		        != edit.oldText_)) {
+			file.error_ = QObject::tr("The file changed since it was "
+			                          "verified");
+			return;
+		}
+
+		result.append(data.constData() + copied, pos - copied);
+		result.append(edit.newText_);
+		copied = end;
+	}
+
+	result.append(data.constData() + copied, data.size() - copied);
+
+	// Replace the file atomically.
+	QSaveFile out(file.path_);
+	if (!out.open(QIODevice::WriteOnly)
+	    || (out.write(result) != result.size())
+	    || !out.commit()) {
+		file.error_ = QObject::tr("Failed to write the file: %1")
+		              .arg(out.errorString());
+		return;
+	}
+
+	file.changed_ = true;
+}
+
+/**
+ * Replaces all whole-word occurrences of the old name in a line.
+ * @param  text    The line to edit
+ * @param  result  Holds the edited line
+ * @param  column  Holds the column of the first occurrence (1-based)
+ * @return The number of replaced occurrences
+ */
+int Rename::replace(const QByteArray& text, QByteArray& result,
+                    uint& column) const
+{
+	int count = 0;
+	int copied = 0;
+	int pos = 0;
+
+	result.clear();
+	column = 0;
+	if (oldBytes_.isEmpty())
+		return 0;
+
+	while ((pos = text.indexOf(oldBytes_, pos)) >= 0) {
+		int end = pos + oldBytes_.size();
+		if (((pos > 0) && isNameChar(text[pos - 1]))
+		    || ((end < text.size()) && isNameChar(text[end]))) {
+			pos++;
+			continue;
+		}
+
+		if (count == 0)
+			column = pos + 1;
+
+		result.append(text.constData() + copied, pos - copied);
+		result.append(newBytes_);
+		copied = end;
+		pos = end;
+		count++;
+	}
+
+	result.append(text.constData() + copied, text.size() - copied);
+	return count;
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,177 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_RENAME_H__
+#define __CORE_RENAME_H__
+
+#include <QFuture>
+#include <QStringList>
+#include <QVector>
+#include "globals.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Renames a symbol in all files of the code base.
+ * The operation is driven by the results of a References query, which are
+ * not trusted as is: the database may be out of date, and Cscope reports the
+ * line of each reference but not its column. The first stage, verify(),
+ * reads every file with results, and finds whole-word occurrences of the old
+ * name on each reported line. Lines on which the name is not found are
+ * reported as problems. The second stage, apply(), writes the verified edits,
+ * after checking that none of the edited lines changed since they were
+ * verified.
+ * Files are handled independently of each other, and both stages run them
+ * concurrently in the global thread pool. Only the edited lines are kept in
+ * memory between the stages, and each file is replaced atomically, so that
+ * a failure never leaves a partially-written file behind.
+ * @author Elad Lahav
+ */
+class Rename
+{
+public:
+	Rename(const QString&, const QString&);
+	~Rename();
+
+	QFuture<void> verify(const LocationList&, const QStringList&);
+	QFuture<void> apply();
+	void preview(LocationList&) const;
+	void problems(LocationList&) const;
+	int editCount() const;
+	QStringList changedFiles() const;
+
+	/**
+	 * @return The name being replaced
+	 */
+	const QString& oldName() const { return oldName_; }
+
+	/**
+	 * @return The replacement name
+	 */
+	const QString& newName() const { return newName_; }
+
+	static bool isValidName(const QString&);
+
+private:
+	/**
+	 * The edits made to a single line.
+	 */
+	struct LineEdit
+	{
+		/**
+		 * The line number (1-based).
+		 */
+		uint line_;
+
+		/**
+		 * The column of the first replaced occurrence (1-based).
+		 */
+		uint column_;
+
+		/**
+		 * The original contents of the line.
+		 */
+		QByteArray oldText_;
+
+		/**
+		 * The contents of the line after the edit.
+		 */
+		QByteArray newText_;
+	};
+
+	/**
+	 * The edits made to a single file.
+	 */
+	struct FileEdit
+	{
+		/**
+		 * The path of the file.
+		 */
+		QString path_;
+
+		/**
+		 * The lines reported by the query, in increasing order.
+		 */
+		QVector<uint> lines_;
+
+		/**
+		 * Verified edits, in increasing line order.
+		 */
+		QVector<LineEdit> edits_;
+
+		/**
+		 * Reported lines on which the name was not found.
+		 */
+		QVector<uint> rejected_;
+
+		/**
+		 * A description of the reason the file could not be handled, or an
+		 * empty string if there were no errors.
+		 */
+		QString error_;
+
+		/**
+		 * Whether the edits were written to the file.
+		 */
+		bool changed_;
+	};
+
+	/**
+	 * The name being replaced.
+	 */
+	QString oldName_;
+
+	/**
+	 * The replacement name.
+	 */
+	QString newName_;
+
+	/**
+	 * The name being replaced, in the encoding of the files.
+	 */
+	QByteArray oldBytes_;
+
+	/**
+	 * The replacement name, in the encoding of the files.
+	 */
+	QByteArray newBytes_;
+
+	/**
+	 * All files with query results.
+	 */
+	QVector<FileEdit> fileList_;
+
+	void verifyFile(FileEdit&) const;
+	void applyFile(FileEdit&) const;
+	int replace(const QByteArray&, QByteArray&, uint&) const;
+
+	friend struct VerifyFile;
+	friend struct ApplyFile;
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_RENAME_H__
@@ -0,0 +1,375 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include "symbolindex.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Score offsets for the different kinds of matches.
+ * Fuzzy scores are always larger than prefix ones.
+ */
+enum {
+	ExactMatch = 0,
+	CasePrefixMatch = 1,
+	PrefixMatch = 2,
+	FuzzyMatch = 0x100
+};
+
+/**
+ * Compares two names for sorting.
+ * Names are ordered case-insensitively, with case-sensitive comparison used
+ * to break ties.
+ */
+static bool nameLessThan(const QByteArray& name1, const QByteArray& name2)
+{
+	int result = qstricmp(name1.constData(), name2.constData());
+	if (result == 0)
+		result = qstrcmp(name1, name2);
+
+	return result < 0;
+}
+
+/**
+ * Class constructor.
+ */
+SymbolIndex::SymbolIndex()
+{
+}
+
+/**
+ * Class destructor.
+ */
+SymbolIndex::~SymbolIndex()
+{
+}
+
+/**
+ * Records an occurrence of a symbol.
+ * The symbol is not searchable until finalize() is called.
+ * @param  name  The symbol name
+ */
+void SymbolIndex::add(const QByteArray& name)
+{
+	if (!name.isEmpty())
+		pending_[name]++;
+}
+
+/**
+ * Builds the compact, sorted representation of all added symbols.
+ */
+void SymbolIndex::finalize()
+{
+	// Sort the names.
+	QList<QByteArray> nameList = pending_.keys();
+	std::sort(nameList.begin(), nameList.end(), nameLessThan);
+
+	// Compute the size of the name buffer.
+	int total = 0;
+	foreach (const QByteArray& name, nameList)
+		total += name.size() + 1;
+
+	names_.clear();
+	names_.reserve(total);
+	offsets_.resize(nameList.size());
+	counts_.resize(nameList.size());
+	masks_.resize(nameList.size());
+
+	// Fill the arrays.
+	for (int i = 0; i < nameList.size(); i++) {
+		const QByteArray& name = nameList[i];
+		offsets_[i] = names_.size();
+		counts_[i] = pending_.value(name);
+		masks_[i] = charMask(name.constData(), name.size());
+		names_.append(name.constData(), name.size() + 1);
+	}
+
+	pending_.clear();
+}
+
+/**
+ * Removes all symbols from the index.
+ */
+void SymbolIndex::clear()
+{
+	names_.clear();
+	offsets_.clear();
+	counts_.clear();
+	masks_.clear();
+	pending_.clear();
+}
+
+/**
+ * Suggests completions for a partial symbol name.
+ * Names starting with the given text are preferred, followed by fuzzy
+ * matches. Within each group, names that occur more frequently in the code
+ * base come first.
+ * @param  text        The partial name
+ * @param  maxResults  The maximal number of suggestions to return
+ * @param  budget      The time limit for the search, in milliseconds
+ * @return A list of symbol names, best match first
+ */
+QStringList SymbolIndex::complete(const QString& text, int maxResults,
+                                  int budget) const
+{
+	QByteArray pattern = text.toLocal8Bit();
+	if (pattern.isEmpty() || offsets_.isEmpty() || (maxResults <= 0))
+		return QStringList();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QVector<Match> matches;
+
+	// Find all names starting with the pattern.
+	int first = lowerBound(pattern);
+	int last = upperBound(pattern);
+	for (int i = first; i < last; i++) {
+		if (((i & 0x3ff) == 0) && (timer.elapsed() >= budget))
+			break;
+
+		if (qstrcmp(name(i), pattern) == 0)
+			addMatch(matches, i, ExactMatch);
+		else if (qstrncmp(name(i), pattern.constData(), pattern.size()) == 0)
+			addMatch(matches, i, CasePrefixMatch);
+		else
+			addMatch(matches, i, PrefixMatch);
+	}
+
+	// Look for fuzzy matches if there are not enough prefixes.
+	if (matches.size() < maxResults) {
+		QByteArray folded = pattern.toLower();
+		quint32 mask = charMask(folded.constData(), folded.size());
+		for (int i = 0; i < offsets_.size(); i++) {
+			if (((i & 0xfff) == 0) && (timer.elapsed() >= budget))
+				break;
+
+			// Quickly rule out names missing some of the characters.
+			if ((masks_[i] & mask) != mask)
+				continue;
+
+			// Already matched as a prefix.
+			if ((i >= first) && (i < last))
+				continue;
+
+			int score = fuzzyScore(name(i), length(i), folded);
+			if (score < 0)
+				continue;
+
+			addMatch(matches, i, FuzzyMatch + score);
+		}
+	}
+
+	// Sort only as many matches as needed.
+	int count = qMin(maxResults, matches.size());
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+	                  lessThan);
+
+	QStringList result;
+	for (int i = 0; i < count; i++)
+		result.append(QString::fromLocal8Bit(name(matches[i].index_)));
+
+	return result;
+}
+
+/**
+ * Lists all symbols that are equal to the given one, ignoring case.
+ * @param  symbol  The name to look for
+ * @return All variants of the name found in the code base
+ */
+QStringList SymbolIndex::caseVariants(const QString& symbol) const
+{
+	QByteArray key = symbol.toLocal8Bit();
+
+	// Find the first name that is not smaller than the key.
+	int low = 0, high = offsets_.size();
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (qstricmp(name(mid), key.constData()) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	// All variants follow.
+	QStringList result;
+	for (int i = low; (i < offsets_.size())
+	                  && (qstricmp(name(i), key.constData()) == 0); i++) {
+		result.append(QString::fromLocal8Bit(name(i)));
+	}
+
+	return result;
+}
+
+/**
+ * Finds the first name that is not case-insensitively smaller than the
+ * given prefix.
+ * @param  prefix  The prefix to look for
+ * @return The index of the name
+ */
+int SymbolIndex::lowerBound(const QByteArray& prefix) const
+{
+	int low = 0, high = offsets_.size();
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (qstrnicmp(name(mid), prefix.constData(), prefix.size()) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/**
+ * Finds the first name that is case-insensitively greater than the given
+ * prefix (ignoring characters following the prefix).
+ * @param  prefix  The prefix to look for
+ * @return The index of the name
+ */
+int SymbolIndex::upperBound(const QByteArray& prefix) const
+{
+	int low = 0, high = offsets_.size();
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (qstrnicmp(name(mid), prefix.constData(), prefix.size()) <= 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/**
+ * Adds a candidate completion.
+ * @param  matches  The list of candidates
+ * @param  index    The index of the matching symbol
+ * @param  score    The quality of the match
+ */
+void SymbolIndex::addMatch(QVector<Match>& matches, int index, int score) const
+{
+	Match match;
+	match.index_ = index;
+	match.score_ = score;
+	match.count_ = counts_[index];
+	match.length_ = length(index);
+	matches.append(match);
+}
+
+/**
+ * Ranks two matches.
+ * @param  m1  The first match
+ * @param  m2  The second match
+ * @return true if the first match is better than the second one
+ */
+bool SymbolIndex::lessThan(const Match& m1, const Match& m2)
+{
+	if (m1.score_ != m2.score_)
+		return m1.score_ < m2.score_;
+
+	if (m1.count_ != m2.count_)
+		return m1.count_ > m2.count_;
+
+	if (m1.length_ != m2.length_)
+		return m1.length_ < m2.length_;
+
+	return m1.index_ < m2.index_;
+}
+
+/**
+ * Computes a bitmask of the characters in a name.
+ * Each letter (regardless of case) has its own bit. All digits share a
+ * single bit, and so do all other characters.
+ * @param  name  The name
+ * @param  len   The length of the name
+ * @return The mask
+ */
+quint32 SymbolIndex::charMask(const char* name, int len)
+{
+	quint32 mask = 0;
+	for (int i = 0; i < len; i++) {
+		char c = name[i];
+		if ((c >= 'a') && (c <= 'z'))
+			mask |= 1 << (c - 'a');
+		else if ((c >= 'A') && (c <= 'Z'))
+			mask |= 1 << (c - 'A');
+		else if ((c >= '0') && (c <= '9'))
+			mask |= 1 << 26;
+		else if (c == '_')
+			mask |= 1 << 27;
+		else
+			mask |= 1 << 28;
+	}
+
+	return mask;
+}
+
+/**
+ * Determines whether the characters of a (lower-case) pattern appear in order
+ * in a name, and if so, how well the name matches the pattern.
+ * Each gap between matched characters is penalised, unless the character
+ * following the gap starts a word in the name (i.e., follows an underscore,
+ * or is an upper-case letter following a lower-case one).
+ * @param  name     The name
+ * @param  len      The length of the name
+ * @param  pattern  The case-folded pattern
+ * @return A non-negative score (lower is better), -1 if there is no match
+ */
+int SymbolIndex::fuzzyScore(const char* name, int len,
+                            const QByteArray& pattern)
+{
+	int score = 0;
+	int p = 0;
+	int prev = -1;
+	for (int i = 0; (i < len) && (p < pattern.size()); i++) {
+		char c = name[i];
+		char fc = ((c >= 'A') && (c <= 'Z')) ? (c - 'A' + 'a') : c;
+		if (fc != pattern[p])
+			continue;
+
+		if (i != prev + 1) {
+			bool wordStart = (name[i - 1] == '_')
+			                 || ((c >= 'A') && (c <= 'Z')
+			                     && (name[i - 1] >= 'a')
+			                     && (name[i - 1] <= 'z'));
+			score += wordStart ? 1 : 4;
+		}
+
+		prev = i;
+		p++;
+	}
+
+	if (p < pattern.size())
+		return -1;
+
+	// Prefer names with fewer unmatched characters.
+	return (score * 16) + qMin(len - pattern.size(), 15);
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,165 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_SYMBOLINDEX_H__
+#define __CORE_SYMBOLINDEX_H__
+
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * An in-memory index of all symbol names in a code base.
+ * Used to suggest completions for partially-typed symbols.
+ * The index is filled by calling add() for every occurrence of a symbol,
+ * followed by a single call to finalize(). The names are then kept in a
+ * single buffer, sorted case-insensitively, with a few parallel arrays
+ * holding the offset of each name, the number of its occurrences and a
+ * bitmask of the characters that appear in it.
+ * Two kinds of matches are supported:
+ * - Prefixes, found with a binary search over the sorted names;
+ * - Fuzzy matches, where the characters of the pattern appear in order in the
+ *   name. The character bitmasks quickly rule out most of the names, so that
+ *   only a handful need to be examined.
+ * Since completions are requested on every keystroke, the search is bounded
+ * by a time budget. Once the budget is exhausted, the best results found so
+ * far are returned.
+ * The case-insensitive order also means that all case variants of a name
+ * are adjacent, so the index doubles as a case-folded lookup table.
+ * @author Elad Lahav
+ */
+class SymbolIndex
+{
+public:
+	SymbolIndex();
+	~SymbolIndex();
+
+	void add(const QByteArray&);
+	void finalize();
+	void clear();
+	QStringList complete(const QString&, int, int budget = 5) const;
+	QStringList caseVariants(const QString&) const;
+
+	/**
+	 * @return true if no symbols are indexed, false otherwise
+	 */
+	bool isEmpty() const { return offsets_.isEmpty(); }
+
+	/**
+	 * @return The number of distinct symbols
+	 */
+	int size() const { return offsets_.size(); }
+
+	/**
+	 * @param  index  The index of a symbol in sorted order
+	 * @return A pointer to the NUL-terminated name of the symbol
+	 */
+	const char* name(int index) const {
+		return names_.constData() + offsets_[index];
+	}
+
+	/**
+	 * @param  index  The index of a symbol in sorted order
+	 * @return The length of the name of the symbol
+	 */
+	int length(int index) const {
+		return ((index + 1 < offsets_.size()) ? offsets_[index + 1]
+		                                      : names_.size())
+		       - offsets_[index] - 1;
+	}
+
+	/**
+	 * @param  index  The index of a symbol in sorted order
+	 * @return The number of occurrences of the symbol in the code base
+	 */
+	quint32 count(int index) const { return counts_[index]; }
+
+private:
+	/**
+	 * All names, in sorted order, each terminated by a NUL character.
+	 */
+	QByteArray names_;
+
+	/**
+	 * The offset of each name in the buffer.
+	 */
+	QVector<quint32> offsets_;
+
+	/**
+	 * The number of occurrences of each name.
+	 */
+	QVector<quint32> counts_;
+
+	/**
+	 * The set of (case-folded) characters in each name.
+	 */
+	QVector<quint32> masks_;
+
+	/**
+	 * Collects names until the index is finalised.
+	 */
+	QHash<QByteArray, quint32> pending_;
+
+	/**
+	 * A candidate completion.
+	 */
+	struct Match
+	{
+		/**
+		 * The index of the symbol.
+		 */
+		int index_;
+
+		/**
+		 * Lower values indicate better matches.
+		 */
+		int score_;
+
+		/**
+		 * The number of occurrences of the symbol.
+		 */
+		quint32 count_;
+
+		/**
+		 * The length of the symbol's name.
+		 */
+		int length_;
+	};
+
+	int lowerBound(const QByteArray&) const;
+	int upperBound(const QByteArray&) const;
+	void addMatch(QVector<Match>&, int, int) const;
+	static bool lessThan(const Match&, const Match&);
+	static quint32 charMask(const char*, int);
+	static int fuzzyScore(const char*, int, const QByteArray&);
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_SYMBOLINDEX_H__
@@ -0,0 +1,246 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegExp>
+#include <QDebug>
+#include "exception.h"
+#include "textsearch.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+TextSearch::TextSearch(QObject* parent) : QThread(parent), conn_(NULL),
+	flags_(0), timeout_(0), stop_(0), timedOut_(false), deleteOnExit_(false)
+{
+	// Both signals are emitted by the search thread, but need to be handled
+	// in the main one.
+	connect(this, SIGNAL(progress(uint, uint)), this,
+	        SLOT(handleProgress(uint, uint)), Qt::QueuedConnection);
+	connect(this, SIGNAL(finished()), this, SLOT(handleFinished()),
+	        Qt::QueuedConnection);
+}
+
+/**
+ * Class destructor.
+ */
+TextSearch::~TextSearch()
+{
+	stop();
+	wait();
+}
+
+/**
+ * Starts a search.
+ * The Text query type looks for a literal string, while a pattern with the
+ * RegExp flag is treated as an extended regular expression. The IgnoreCase
+ * flag is honoured in both cases.
+ * @param  conn      Used to report progress and results
+ * @param  fileList  The files to search
+ * @param  query     The query to run
+ * @throw  Exception
+ */
+void TextSearch::search(Engine::Connection* conn, const QStringList& fileList,
+                        const Query& query)
+{
+	// An empty pattern would match every line of every file.
+	if (query.pattern_.isEmpty())
+		throw new Exception("Empty search pattern");
+
+	conn_ = conn;
+	conn_->setCtrlObject(this);
+	fileList_ = fileList;
+	pattern_ = query.pattern_;
+	flags_ = query.flags_;
+	timeout_ = query.timeout_;
+	stop_.storeRelease(0);
+	timedOut_ = false;
+	locList_.clear();
+
+	start();
+}
+
+/**
+ * Aborts the search.
+ */
+void TextSearch::stop()
+{
+	stop_.storeRelease(1);
+}
+
+/**
+ * The thread's main function.
+ */
+void TextSearch::run()
+{
+	// A literal, case-sensitive search is done on the raw file contents.
+	// Anything else requires a regular expression.
+	QByteArray needle;
+	QRegExp regExp;
+	Qt::CaseSensitivity cs = (flags_ & Query::IgnoreCase) ? Qt::CaseInsensitive
+	                                                      : Qt::CaseSensitive;
+	if (flags_ & Query::RegExp)
+		regExp = QRegExp(pattern_, cs, QRegExp::RegExp2);
+	else if (cs == Qt::CaseInsensitive)
+		regExp = QRegExp(pattern_, cs, QRegExp::FixedString);
+	else
+		needle = pattern_.toLocal8Bit();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	for (int i = 0; i < fileList_.size() && !stop_.loadAcquire(); i++) {
+		searchFile(fileList_[i], needle, regExp);
+		if ((i & 0x3f) == 0)
+			emit progress(i, fileList_.size());
+
+		// Stop at the deadline, keeping the matches found so far.
+		if ((timeout_ > 0) && timer.hasExpired(timeout_)) {
+			qWarning() << "Text search timed out after" << i + 1 << "of"
+			           << fileList_.size() << "files";
+			timedOut_ = true;
+			break;
+		}
+	}
+}
+
+/**
+ * Searches a single file.
+ * @param  path    The path of the file
+ * @param  needle  A literal string to look for (if not empty)
+ * @param  regExp  A regular expression to look for (if the literal is empty)
+ */
+void TextSearch::searchFile(const QString& path, const QByteArray& needle,
+                            QRegExp& regExp)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+
+	QByteArray data = file.readAll();
+	file.close();
+
+	if (!needle.isEmpty()) {
+		// Jump between occurrences of the string, counting lines in between.
+		int pos = 0, lineStart = 0;
+		uint line = 1;
+		while ((pos = data.indexOf(needle, pos)) >= 0) {
+			for (int i = lineStart; i < pos; i++) {
+				if (data[i] == '\n') {
+					line++;
+					lineStart = i + 1;
+				}
+			}
+
+			int lineEnd = data.indexOf('\n', pos);
+			if (lineEnd < 0)
+				lineEnd = data.size();
+
+			addMatch(path, data, lineStart, lineEnd, line);
+			pos = lineEnd;
+		}
+
+		return;
+	}
+
+	// Match the expression on each line.
+	uint line = 1;
+	for (int lineStart = 0; lineStart < data.size(); line++) {
+		int lineEnd = data.indexOf('\n', lineStart);
+		if (lineEnd < 0)
+			lineEnd = data.size();
+
+		QString text = QString::fromLocal8Bit(data.constData() + lineStart,
+		                                      lineEnd - lineStart);
+		if (regExp.indexIn(text) >= 0)
+			addMatch(path, data, lineStart, lineEnd, line);
+
+		lineStart = lineEnd + 1;
+	}
+}
+
+/**
+ * Records a matching line.
+ * @param  path   The path of the file
+ * @param  data   The contents of the file
+ * @param  start  The offset of the start of the line
+ * @param  end    The offset of the end of the line
+ * @param  line   The line number
+ */
+void TextSearch::addMatch(const QString& path, const QByteArray& data,
+                          int start, int end, uint line)
+{
+	Location loc(path, line);
+	loc.tag_.type_ = Tag::UnknownTag;
+	loc.text_ = QString::fromLocal8Bit(data.constData() + start, end - start)
+	            .trimmed();
+	locList_.append(loc);
+}
+
+/**
+ * Reports progress in the main thread.
+ * @param  cur    The number of files searched so far
+ * @param  total  The number of files to search
+ */
+void TextSearch::handleProgress(uint cur, uint total)
+{
+	if (conn_)
+		conn_->onProgress(tr("Searching..."), cur, total);
+}
+
+/**
+ * Delivers the results in the main thread.
+ */
+void TextSearch::handleFinished()
+{
+	if (conn_) {
+		if (stop_.loadAcquire()) {
+			conn_->onAborted();
+		}
+		else {
+			if (!locList_.isEmpty())
+				conn_->onDataReady(locList_);
+
+			if (timedOut_)
+				conn_->onTimedOut();
+			else
+				conn_->onFinished();
+		}
+
+		conn_->setCtrlObject(NULL);
+		conn_ = NULL;
+	}
+
+	locList_.clear();
+	if (deleteOnExit_)
+		deleteLater();
+}
+
+} // namespace Core
+
+} // namespace KScope
@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CORE_TEXTSEARCH_H__
+#define __CORE_TEXTSEARCH_H__
+
+#include <QAtomicInt>
+#include <QThread>
+#include <QStringList>
+#include <QRegExp>
+#include "engine.h"
+
+namespace KScope
+{
+
+namespace Core
+{
+
+/**
+ * Searches a list of files for text.
+ * Used instead of an external process when only a subset of the files in the
+ * code base needs to be searched. The search runs in a separate thread.
+ * Results are delivered to the connection object in the main thread, once the
+ * search completes.
+ * @author Elad Lahav
+ */
+class TextSearch : public QThread, public Engine::Controlled
+{
+	Q_OBJECT
+
+public:
+	TextSearch(QObject* parent = 0);
+	~TextSearch();
+
+	void search(Engine::Connection*, const QStringList&, const Query&);
+	void stop();
+
+	/**
+	 * Causes the object to be deleted once the search terminates.
+	 */
+	void setDeleteOnExit() { deleteOnExit_ = true; }
+
+signals:
+	void progress(uint cur, uint total);
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The connection to report to.
+	 */
+	Engine::Connection* conn_;
+
+	/**
+	 * The files to search.
+	 */
+	QStringList fileList_;
+
+	/**
+	 * The text to look for.
+	 */
+	QString pattern_;
+
+	/**
+	 * Query flags.
+	 */
+	uint flags_;
+
+	/**
+	 * The maximal search time, in milliseconds, or 0 for no limit.
+	 */
+	int timeout_;
+
+	/**
+	 * Set by stop() to abort the search.
+	 * Written by the main thread and read by the search thread.
+	 */
+	QAtomicInt stop_;
+
+	/**
+	 * Set if the search was stopped by its deadline.
+	 */
+	bool timedOut_;
+
+	/**
+	 * Whether to delete the object when done.
+	 */
+	bool deleteOnExit_;
+
+	/**
+	 * Matches found so far.
+	 */
+	LocationList locList_;
+
+	void searchFile(const QString&, const QByteArray&, QRegExp&);
+	void addMatch(const QString&, const QByteArray&, int, int, uint);
+
+private slots:
+	void handleProgress(uint, uint);
+	void handleFinished();
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __CORE_TEXTSEARCH_H__
@@ -0,0 +1,244 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QDebug>
+#include <core/compiledb.h>
+#include <core/exception.h>
+#include "compiledbfiles.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Collects source files and include directories from compilation database
+ * entries.
+ * @author Elad Lahav
+ */
+struct FileCollector : public Core::Callback<const Core::CompileDb::Entry&>
+{
+	/**
+	 * Struct constructor.
+	 * @param  includeHeaders  Whether to collect include directories
+	 */
+	FileCollector(bool includeHeaders) : includeHeaders_(includeHeaders) {}
+
+	/**
+	 * Adds the file compiled by an entry.
+	 * @param  entry  The compilation command
+	 */
+	virtual void call(const Core::CompileDb::Entry& entry) {
+		files_.insert(entry.file_);
+		if (includeHeaders_) {
+			QStringList dirs = Core::CompileDb::includeDirs(entry);
+			QStringList::ConstIterator itr;
+			for (itr = dirs.begin(); itr != dirs.end(); ++itr)
+				dirs_.insert(*itr);
+		}
+	}
+
+	/**
+	 * Whether to collect include directories.
+	 */
+	bool includeHeaders_;
+
+	/**
+	 * The set of translation units.
+	 */
+	QSet<QString> files_;
+
+	/**
+	 * The set of include directories.
+	 */
+	QSet<QString> dirs_;
+};
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+CompileDbFiles::CompileDbFiles(QObject* parent) : Files(parent),
+	includeHeaders_(false)
+{
+	timer_.setSingleShot(true);
+	timer_.setInterval(500);
+	connect(&watcher_, SIGNAL(fileChanged(const QString&)), this,
+	        SLOT(dbChanged()));
+	connect(&watcher_, SIGNAL(directoryChanged(const QString&)), this,
+	        SLOT(dirChanged()));
+	connect(&timer_, SIGNAL(timeout()), this, SLOT(regenerate()));
+}
+
+/**
+ * Class destructor.
+ */
+CompileDbFiles::~CompileDbFiles()
+{
+}
+
+/**
+ * Opens the code base.
+ * If a compilation database is configured, the list of files is regenerated
+ * in case the database is newer than the list.
+ * @param  initString  The project path, followed by optional parameters
+ * @param  cb          Called when the code base is ready
+ * @throw  Exception
+ */
+void CompileDbFiles::open(const QString& initString, Core::Callback<>* cb)
+{
+	// Parse the initialisation string.
+	QStringList args = initString.split("*", QString::SkipEmptyParts);
+	if (args.isEmpty())
+		throw new Core::Exception("Missing project path");
+
+	QString projPath = args.takeFirst();
+	dbPath_.clear();
+	includeHeaders_ = args.removeAll("-I") > 0;
+	if (!args.isEmpty())
+		dbPath_ = args.first();
+
+	// Make sure the database exists before committing to it.
+	QFileInfo dbInfo(dbPath_);
+	if (!dbPath_.isEmpty() && !dbInfo.isReadable()) {
+		throw new Core::Exception(QString("Cannot read the compilation "
+		                                  "database '%1'").arg(dbPath_));
+	}
+
+	try {
+		Files::open(projPath, NULL);
+	}
+	catch (Core::Exception* e) {
+		throw e;
+	}
+
+	listPath_ = QDir(projPath).filePath("cscope.files");
+	if (!watcher_.files().isEmpty())
+		watcher_.removePaths(watcher_.files());
+	if (!watcher_.directories().isEmpty())
+		watcher_.removePaths(watcher_.directories());
+
+	if (!dbPath_.isEmpty()) {
+		watcher_.addPath(dbPath_);
+		watcher_.addPath(dbInfo.absolutePath());
+
+		// Regenerate the list if it is missing or older than the database.
+		QFileInfo listInfo(listPath_);
+		if (listInfo.size() == 0
+		    || listInfo.lastModified() < dbInfo.lastModified()) {
+			generate();
+		}
+	}
+
+	if (cb)
+		cb->call();
+}
+
+/**
+ * Creates the list of files from the compilation database.
+ * @throw  Exception
+ */
+void CompileDbFiles::generate()
+{
+	Core::CompileDb db;
+	FileCollector collector(includeHeaders_);
+	if (!db.read(dbPath_, collector)) {
+		throw new Core::Exception(QString("Failed to parse '%1': %2")
+		                          .arg(dbPath_).arg(db.errorString()));
+	}
+
+	// Add headers that reside directly under the include directories.
+	QStringList filters;
+	filters << "*.h" << "*.hh" << "*.hpp" << "*.hxx" << "*.inl";
+
+	QSet<QString>::ConstIterator dirItr;
+	for (dirItr = collector.dirs_.begin(); dirItr != collector.dirs_.end();
+	     ++dirItr) {
+		QDir dir(*dirItr);
+		QStringList headers = dir.entryList(filters, QDir::Files);
+		QStringList::ConstIterator itr;
+		for (itr = headers.begin(); itr != headers.end(); ++itr)
+			collector.files_.insert(dir.filePath(*itr));
+	}
+
+	QStringList fileList = collector.files_.toList();
+	fileList.sort();
+	Files::setFiles(fileList);
+}
+
+/**
+ * Called by the watcher when the compilation database is modified.
+ * Build systems typically rewrite the database in several steps, so
+ * regeneration is deferred until changes have settled.
+ */
+void CompileDbFiles::dbChanged()
+{
+	timer_.start();
+}
+
+/**
+ * Called by the watcher when an entry is added to or removed from the
+ * directory holding the compilation database.
+ * A database that was deleted (e.g., by a clean build) is no longer watched,
+ * and so the watch is restored once the database is created again. Other
+ * changes to the directory are ignored.
+ */
+void CompileDbFiles::dirChanged()
+{
+	if (watcher_.files().contains(dbPath_) || !QFileInfo(dbPath_).exists())
+		return;
+
+	watcher_.addPath(dbPath_);
+	timer_.start();
+}
+
+/**
+ * Regenerates the list of files following a change to the compilation
+ * database.
+ */
+void CompileDbFiles::regenerate()
+{
+	// A database that was replaced, rather than modified in place, is no
+	// longer watched. If it was deleted, the watch is restored by dirChanged()
+	// when it reappears.
+	if (!watcher_.files().contains(dbPath_)) {
+		if (!QFileInfo(dbPath_).exists())
+			return;
+
+		watcher_.addPath(dbPath_);
+	}
+
+	try {
+		generate();
+	}
+	catch (Core::Exception* e) {
+		// Keep the current list.
+		qDebug() << e->reason();
+		delete e;
+	}
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_COMPILEDBFILES_H__
+#define __CSCOPE_COMPILEDBFILES_H__
+
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include "files.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * A cscope.files code base that can be derived from a compilation database.
+ * When the project is configured with a compile_commands.json file, the list
+ * of files is taken from the database, rather than by scanning the file
+ * system: every translation unit is included, along with (optionally) the
+ * headers found directly under the -I and -iquote directories. The list is
+ * regenerated whenever the database changes, and cannot be modified by the
+ * user.
+ * Without a database, this class behaves exactly as Files.
+ * The initialisation string has the form "projPath[*dbPath][*-I]".
+ * @author Elad Lahav
+ */
+class CompileDbFiles : public Files
+{
+	Q_OBJECT
+
+public:
+	CompileDbFiles(QObject* parent = NULL);
+	~CompileDbFiles();
+
+	// Core::Codebase implementation.
+	void open(const QString&, Core::Callback<>*);
+	bool canModify() { return dbPath_.isEmpty() && Files::canModify(); }
+	bool needFiles() { return dbPath_.isEmpty() && Files::needFiles(); }
+
+private:
+	/**
+	 * The path to the cscope.files file.
+	 */
+	QString listPath_;
+
+	/**
+	 * The path to the compile_commands.json file (empty if not used).
+	 */
+	QString dbPath_;
+
+	/**
+	 * Whether to add headers from include directories.
+	 */
+	bool includeHeaders_;
+
+	/**
+	 * Notifies of changes to the compilation database, and to the directory
+	 * holding it (in case the database is deleted and created again).
+	 */
+	QFileSystemWatcher watcher_;
+
+	/**
+	 * Delays regeneration until the database has been completely written.
+	 */
+	QTimer timer_;
+
+	void generate();
+
+private slots:
+	void dbChanged();
+	void dirChanged();
+	void regenerate();
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_COMPILEDBFILES_H__
@@ -20,9 +20,13 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QRegExp>
 #include <core/exception.h>
+#include <core/connectiongroup.h>
+#include <core/textsearch.h>
 #include "crossref.h"
 #include "ctags.h"
+#include "snapshot.h"
 
 namespace KScope
 {
@@ -30,12 +34,37 @@ namespace KScope
 namespace Cscope
 {
 
+/**
+ * Removes locations outside the directories to which a query is restricted.
+ * @param  query    The query
+ * @param  locList  The list to filter
+ */
+static void filterLocations(const Core::Query& query,
+                            Core::LocationList& locList)
+{
+	if (query.pathPrefixes_.isEmpty())
+		return;
+
+	Core::LocationList inScope;
+	foreach (const Core::Location& loc, locList) {
+		if (query.matchesPath(loc.file_))
+			inScope.append(loc);
+	}
+
+	locList = inScope;
+}
+
 /**
  * Class constructor.
  * @param  parent  Parent object
  */
-Crossref::Crossref(QObject* parent) : Core::Engine(parent), status_(Unknown)
+Crossref::Crossref(QObject* parent) : Core::Engine(parent), status_(Unknown),
+	codebase_(NULL), indicesReady_(true), dbGeneration_(0),
+	passGeneration_(0), indexGeneration_(0)
 {
+	indexBuilder_ = new IndexBuilder(this);
+	connect(indexBuilder_, SIGNAL(finished()), this,
+	        SLOT(indexBuilderFinished()));
 }
 
 /**
@@ -43,6 +72,7 @@ Crossref::Crossref(QObject* parent) : Core::Engine(parent), status_(Unknown)
  */
 Crossref::~Crossref()
 {
+	indexBuilder_->stop();
 }
 
 /**
@@ -93,6 +123,17 @@ void Crossref::open(const QString& initString, Core::Callback<>* cb)
 	path_ = path;
 	args_ = args;
 	status_ = status;
+	snapshotStore_.setPath(path_);
+
+	// Discard indices of a previously-opened database.
+	indexBuilder_->stop();
+	includeGraph_ = Core::IncludeGraph();
+	symbolIndex_.clear();
+	metrics_.clear();
+	indicesReady_ = true;
+	dbGeneration_++;
+	if (status_ == Ready)
+		buildIndices();
 
 	if (cb)
 		cb->call();
@@ -145,6 +186,21 @@ Crossref::queryFields(Core::Query::Type type) const
 		          << Core::Location::TagType;
 		break;
 
+	case Core::Query::IncludeClosure:
+		fieldList << Core::Location::Scope
+		          << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
+	case Core::Query::Metrics:
+		fieldList << Core::Location::Count
+		          << Core::Location::TagName
+		          << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
 	default:
 		;
 	}
@@ -152,6 +208,104 @@ Crossref::queryFields(Core::Query::Type type) const
 	return fieldList;
 }
 
+/**
+ * Associates the database with the code base it indexes.
+ * The file list of the code base is kept in an in-memory index, which is used
+ * to answer file-name queries. The index is refreshed whenever the code base
+ * is loaded or modified, and updated in place when files are added or
+ * removed.
+ * @param  cbase  The code base object
+ */
+void Crossref::setCodebase(const Core::Codebase* cbase)
+{
+	if (codebase_)
+		disconnect(codebase_, NULL, this, NULL);
+
+	codebase_ = cbase;
+	pathIndex_.clear();
+	if (!codebase_)
+		return;
+
+	connect(codebase_, SIGNAL(loaded()), this, SLOT(indexFiles()));
+	connect(codebase_, SIGNAL(modified()), this, SLOT(indexFiles()));
+	connect(codebase_,
+	        SIGNAL(filesChanged(const QStringList&, const QStringList&)),
+	        this,
+	        SLOT(updateFileIndex(const QStringList&, const QStringList&)));
+}
+
+/**
+ * Suggests symbol names for a partially-typed pattern.
+ * @param  text        The partial pattern
+ * @param  maxResults  The maximal number of suggestions
+ * @return Suggested names, best match first
+ */
+QStringList Crossref::complete(const QString& text, int maxResults) const
+{
+	return symbolIndex_.complete(text, maxResults);
+}
+
+/**
+ * Saves the current version of the database.
+ * @param  name  The name of the snapshot
+ * @return true if successful, false otherwise
+ * @throw  Exception if the name is not valid
+ */
+bool Crossref::createSnapshot(const QString& name)
+{
+	if (!SnapshotStore::isValidName(name)) {
+		throw new Core::Exception(QString("'%1' is not a valid snapshot name. "
+		                                  "Names may contain letters, digits, "
+		                                  "'.', '_' and '-', and may not "
+		                                  "start with a '.'").arg(name));
+	}
+
+	if (status_ != Ready && status_ != Rebuild)
+		return false;
+
+	return snapshotStore_.create(name);
+}
+
+/**
+ * @return The names of existing snapshots, most recent first
+ */
+QStringList Crossref::snapshots() const
+{
+	return snapshotStore_.list();
+}
+
+/**
+ * @param  name  The name of the snapshot
+ * @return An engine for querying the snapshot, or NULL if it does not exist
+ */
+Core::Engine* Crossref::openSnapshot(const QString& name) const
+{
+	if (!snapshotStore_.list().contains(name))
+		return NULL;
+
+	return new Snapshot(*this, snapshotStore_.path(name));
+}
+
+/**
+ * Queries answered from the include graph or from code metrics need to wait
+ * for the background pass over the database.
+ * @param  query  The query to check
+ * @return true if the query can be started, false otherwise
+ */
+bool Crossref::canQuery(const Core::Query& query) const
+{
+	switch (query.type_) {
+	case Core::Query::IncludeClosure:
+	case Core::Query::Metrics:
+		return indicesReady_;
+
+	default:
+		;
+	}
+
+	return true;
+}
+
 /**
  * Starts a Cscope query.
  * Creates a new Cscope process to handle the query.
@@ -165,10 +319,32 @@ void Crossref::query(Core::Engine::Connection* conn,
 	Cscope::QueryArg args;
 
 	args.flags = query.flags_;
+	args.pathPrefixes = query.pathPrefixes_;
+	args.timeout = query.timeout_;
 	
 	// Translate the requested type into a Cscope query number.
 	switch (query.type_) {
 	case Core::Query::Text:
+		// Search only the files in scope, if the query is restricted.
+		if (!query.pathPrefixes_.isEmpty() && !pathIndex_.isEmpty()) {
+			QStringList fileList;
+			foreach (const QString& path, pathIndex_.paths()) {
+				if (query.matchesPath(path))
+					fileList.append(path);
+			}
+
+			Core::TextSearch* search = new Core::TextSearch();
+			search->setDeleteOnExit();
+			try {
+				search->search(conn, fileList, query);
+			}
+			catch (Core::Exception* e) {
+				delete search;
+				throw e;
+			}
+			return;
+		}
+
 		if (query.flags_ & Core::Query::RegExp)
 			args.type = Cscope::EGrepPattern;
 		else
@@ -192,17 +368,84 @@ void Crossref::query(Core::Engine::Connection* conn,
 		break;
 
 	case Core::Query::FindFile:
+		// Use the path index, unless a regular expression was given.
+		if (!(query.flags_ & Core::Query::RegExp) && !pathIndex_.isEmpty()) {
+			Core::LocationList locList;
+			pathIndex_.query(query, locList);
+			if (!locList.isEmpty())
+				conn->onDataReady(locList);
+			conn->onFinished();
+			return;
+		}
+
 		args.type = Cscope::FindFile;
 		break;
 
 	case Core::Query::IncludingFiles:
+		// Use the include graph, unless a regular expression was given.
+		if (!(query.flags_ & Core::Query::RegExp)
+		    && !includeGraph_.isEmpty()) {
+			Core::LocationList locList;
+			includeGraph_.includers(query.pattern_, locList);
+			filterLocations(query, locList);
+			if (!locList.isEmpty())
+				conn->onDataReady(locList);
+			conn->onFinished();
+			return;
+		}
+
 		args.type = Cscope::IncludingFiles;
 		break;
 
+	case Core::Query::IncludeClosure:
+		{
+			// Cscope cannot answer this type of query directly.
+			if (includeGraph_.isEmpty()) {
+				throw new Core::Exception("The #include graph is not "
+				                          "available yet");
+			}
+
+			Core::LocationList locList;
+			includeGraph_.closure(query.pattern_, locList);
+			filterLocations(query, locList);
+			if (!locList.isEmpty())
+				conn->onDataReady(locList);
+			conn->onFinished();
+			return;
+		}
+
+	case Core::Query::Metrics:
+		{
+			// Reports are generated from the metrics gathered when the
+			// database was last read.
+			Core::CodeMetrics::Report report;
+			if (!Core::CodeMetrics::reportFromName(query.pattern_, report)) {
+				throw new Core::Exception(QString("Unknown report '%1' "
+				                                  "(available reports: %2)")
+				                          .arg(query.pattern_)
+				                          .arg(Core::CodeMetrics::reportNames()
+				                               .join(", ")));
+			}
+
+			if (metrics_.isEmpty()) {
+				throw new Core::Exception("Code metrics are not available "
+				                          "yet");
+			}
+
+			Core::LocationList locList;
+			metrics_.report(report, locList);
+			filterLocations(query, locList);
+			if (!locList.isEmpty())
+				conn->onDataReady(locList);
+			conn->onFinished();
+			return;
+		}
+
 	case Core::Query::LocalTags:
 		{
 			Ctags* ctags = new Ctags();
 			ctags->setDeleteOnExit();
+			ctags->setDeadline(query.timeout_);
 			ctags->query(conn, query.pattern_);
 			return;
 		}
@@ -214,12 +457,75 @@ void Crossref::query(Core::Engine::Connection* conn,
 		                          .arg(query.type_));
 	}
 
+	// Avoid slow case-insensitive symbol look-ups.
+	if ((query.flags_ & Core::Query::IgnoreCase)
+	    && queryCaseVariants(conn, args, query.pattern_)) {
+		return;
+	}
+
 	// Create a new Cscope process object, and start the query.
 	Cscope* cscope = new Cscope();
 	cscope->setDeleteOnExit();
 	cscope->query(conn, path_, args, query.pattern_);
 }
 
+/**
+ * Handles a case-insensitive symbol query using the symbol index.
+ * Cscope answers case-insensitive queries by scanning the entire database.
+ * Instead, all case variants of the symbol are looked up in the index, and
+ * a case-sensitive query is run for each, concurrently.
+ * @param  conn     Connection object to attach to the query
+ * @param  args     Cscope query arguments
+ * @param  pattern  The symbol to look for
+ * @return true if the query was handled, false if it needs to be passed to
+ *         Cscope as is
+ */
+bool Crossref::queryCaseVariants(Core::Engine::Connection* conn,
+                                 Cscope::QueryArg args,
+                                 const QString& pattern) const
+{
+	// Only applies to symbol queries.
+	switch (args.type) {
+	case Cscope::References:
+	case Cscope::Definition:
+	case Cscope::CalledFunctions:
+	case Cscope::CallingFunctions:
+		break;
+
+	default:
+		return false;
+	}
+
+	// Make sure the pattern is a plain symbol name, and that the index is
+	// available and describes the current database (it is rebuilt in the
+	// background after each build, and does not cover files added since).
+	static QRegExp symbolRE("[A-Za-z_][A-Za-z0-9_]*");
+	if (!symbolRE.exactMatch(pattern) || symbolIndex_.isEmpty()
+	    || (indexGeneration_ != dbGeneration_)) {
+		return false;
+	}
+
+	// The index holds every symbol in the database, so if there are no
+	// variants there are no results either.
+	QStringList variants = symbolIndex_.caseVariants(pattern);
+	if (variants.isEmpty()) {
+		conn->onFinished();
+		return true;
+	}
+
+	// Run a case-sensitive query for each variant.
+	args.flags &= ~Core::Query::IgnoreCase;
+	Core::ConnectionGroup* group = new Core::ConnectionGroup(conn,
+	                                                         variants.size());
+	for (int i = 0; i < variants.size(); i++) {
+		Cscope* cscope = new Cscope();
+		cscope->setDeleteOnExit();
+		cscope->query(group->branch(i), path_, args, variants[i]);
+	}
+
+	return true;
+}
+
 /**
  * Starts a Cscope build process.
  * @param  conn  Connection object to attach to the new process
@@ -240,8 +546,81 @@ void Crossref::build(Core::Engine::Connection* conn) const
 
 void Crossref::buildProcessFinished(int code, QProcess::ExitStatus status)
 {
-	if ((code == 0) && (status == QProcess::NormalExit))
+	if ((code == 0) && (status == QProcess::NormalExit)) {
 		status_ = Ready;
+		dbGeneration_++;
+		buildIndices();
+	}
+}
+
+/**
+ * Rebuilds the path index from the current list of files in the code base.
+ */
+void Crossref::indexFiles()
+{
+	if (codebase_)
+		pathIndex_.build(*codebase_);
+
+	qDebug() << __func__ << pathIndex_.size() << "files";
+}
+
+/**
+ * Updates the path index with files added to or removed from the code base.
+ * Symbols defined in these files are only updated by the next build, so the
+ * database is marked for rebuilding.
+ * @param  added    Files added to the code base
+ * @param  removed  Files removed from the code base
+ */
+void Crossref::updateFileIndex(const QStringList& added,
+                               const QStringList& removed)
+{
+	pathIndex_.update(added, removed);
+	dbGeneration_++;
+
+	// The database does not describe the new list of files.
+	if (status_ == Ready)
+		status_ = Rebuild;
+
+	qDebug() << __func__ << added.size() << "added" << removed.size()
+	         << "removed";
+}
+
+/**
+ * Starts a background pass over the cross-reference file, which extracts the
+ * include graph and the symbol index.
+ * The current indices remain in use until the pass completes.
+ */
+void Crossref::buildIndices()
+{
+	indicesReady_ = false;
+	passGeneration_ = dbGeneration_;
+	indexBuilder_->start(QDir(path_).filePath("cscope.out"));
+}
+
+/**
+ * Replaces the current indices and code metrics with the ones generated by the
+ * last pass over the database.
+ */
+void Crossref::indexBuilderFinished()
+{
+	// Ignore the end of a pass that was replaced by a newer one.
+	if (indexBuilder_->isRunning())
+		return;
+
+	if (indexBuilder_->succeeded()) {
+		includeGraph_ = indexBuilder_->includeGraph();
+		indexBuilder_->includeGraph() = Core::IncludeGraph();
+		symbolIndex_ = indexBuilder_->symbolIndex();
+		indexBuilder_->symbolIndex().clear();
+		metrics_ = indexBuilder_->metrics();
+		indexBuilder_->metrics().clear();
+		indexGeneration_ = passGeneration_;
+	}
+
+	// Queries waiting for the indices fail from now on if the pass did not
+	// succeed, rather than wait forever.
+	indicesReady_ = true;
+	emit indicesChanged();
 }
 
 } // namespace Cscope
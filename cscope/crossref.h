@@ -21,9 +21,16 @@
 #ifndef __CSCOPE_CROSSREF_H__
 #define __CSCOPE_CROSSREF_H__
 
+#include <core/codebase.h>
+#include <core/pathindex.h>
+#include <core/includegraph.h>
+#include <core/symbolindex.h>
+#include <core/codemetrics.h>
 #include "cscope.h"
 #include "ctags.h"
 #include "engineconfigwidget.h"
+#include "indexbuilder.h"
+#include "snapshotstore.h"
 
 namespace KScope
 {
@@ -57,6 +64,13 @@ public:
 
 	QList<Core::Location::Fields> queryFields(Core::Query::Type) const;
 
+	void setCodebase(const Core::Codebase*);
+	QStringList complete(const QString&, int) const;
+	bool createSnapshot(const QString&);
+	QStringList snapshots() const;
+	Core::Engine* openSnapshot(const QString&) const;
+	bool canQuery(const Core::Query&) const;
+
 public slots:
 	void query(Core::Engine::Connection*, const Core::Query&) const;
 	void build(Core::Engine::Connection*) const;
@@ -79,8 +93,74 @@ private:
 	 */
 	Status status_;
 
+	/**
+	 * The code base indexed by the database (may be NULL).
+	 */
+	const Core::Codebase* codebase_;
+
+	/**
+	 * Answers FindFile queries without running Cscope.
+	 */
+	Core::PathIndex pathIndex_;
+
+	/**
+	 * Answers #include queries without running Cscope.
+	 */
+	Core::IncludeGraph includeGraph_;
+
+	/**
+	 * Provides symbol completions.
+	 */
+	Core::SymbolIndex symbolIndex_;
+
+	/**
+	 * Answers code metrics queries.
+	 */
+	Core::CodeMetrics metrics_;
+
+	/**
+	 * Extracts the include graph and symbol index from the database in the
+	 * background.
+	 */
+	IndexBuilder* indexBuilder_;
+
+	/**
+	 * Whether the indices describe the current database, i.e., no pass over
+	 * the database is in progress.
+	 */
+	bool indicesReady_;
+
+	/**
+	 * Incremented whenever the database, or the set of files it should
+	 * describe, changes.
+	 */
+	uint dbGeneration_;
+
+	/**
+	 * The database generation read by the current pass over the database.
+	 */
+	uint passGeneration_;
+
+	/**
+	 * The database generation from which the symbol index was built.
+	 * The index is stale if this differs from dbGeneration_.
+	 */
+	uint indexGeneration_;
+
+	/**
+	 * Keeps old versions of the database.
+	 */
+	SnapshotStore snapshotStore_;
+
+	void buildIndices();
+	bool queryCaseVariants(Core::Engine::Connection*, Cscope::QueryArg,
+	                       const QString&) const;
+
 private slots:
 	void buildProcessFinished(int, QProcess::ExitStatus);
+	void indexFiles();
+	void updateFileIndex(const QStringList&, const QStringList&);
+	void indexBuilderFinished();
 };
 
 } // namespace Cscope
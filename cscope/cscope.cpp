@@ -136,6 +136,15 @@ void Cscope::query(Core::Engine::Connection* conn, const QString& path,
 	setState(queryProgState_);
 	locList_.clear();
 	type_ = extraArgs.type;
+	pathPrefixes_ = extraArgs.pathPrefixes;
+	setDeadline(extraArgs.timeout);
+
+	// Text searches read every source file, and may not find anything for a
+	// long time. Only the deadline applies to these.
+	if ((type_ == Text) || (type_ == EGrepPattern))
+		setIdleTimeout(0);
+	else
+		setIdleTimeout(defaultIdleTimeout_);
 
 	// Start the process.
 	qDebug() << "Running" << execPath_ << args << "in" << path;
@@ -170,6 +179,9 @@ void Cscope::build(Core::Engine::Connection* conn, const QString& path,
 	conn_->setCtrlObject(this);
 	setState(buildInitState_);
 
+	// Building the inverted index produces no output for a long time.
+	setIdleTimeout(10 * defaultIdleTimeout_);
+
 	// Start the process.
 	qDebug() << "Running cscope:" << args << "in" << path;
 	start(prog, args);
@@ -188,8 +200,13 @@ void Cscope::handleFinished(int code, QProcess::ExitStatus status)
 	if (!locList_.isEmpty())
 		conn_->onDataReady(locList_);
 
-	// Signal normal termination.
-	conn_->onFinished();
+	// Signal termination.
+	if (timedOut())
+		conn_->onTimedOut();
+	else if (cancelled())
+		conn_->onAborted();
+	else
+		conn_->onFinished();
 
 	// Detach from the connection object.
 	conn_->setCtrlObject(NULL);
@@ -66,6 +66,8 @@ public:
 	 struct QueryArg {
 		enum QueryType type;
 		uint flags;
+		QStringList pathPrefixes;
+		int timeout;
 	};
 
     QStringList flags2Str(uint flags);
@@ -77,7 +79,7 @@ public:
 	/**
 	 * Stops a query/build process.
 	 */
-	virtual void stop() { kill(); }
+	virtual void stop() { cancel(); }
 
 	static QString execPath_;
 
@@ -133,6 +135,11 @@ private:
 	 */
 	QueryType type_;
 
+	/**
+	 * Results from files outside these directories are discarded.
+	 */
+	QStringList pathPrefixes_;
+
 	/**
 	 * Functor for progress-states transition-functions.
 	 */
@@ -212,9 +219,16 @@ private:
 		 * @param  capList  List of captured strings
 		 */
 		void operator()(const Parser::CapList& capList) const {
+			// Skip results outside the query's scope.
+			QString file = capList[0].toString();
+			if (!Core::Query::matchesPath(self_.pathPrefixes_, file)) {
+				self_.resParsed_++;
+				return;
+			}
+
 			// Fill-in a Location object, using the parsed result information.
 			Core::Location loc;
-			loc.file_ = capList[0].toString();
+			loc.file_ = file;
 			loc.line_ = capList[2].toUInt();
 			loc.column_ = 0;
 			loc.text_ = capList[3].toString();
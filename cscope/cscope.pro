@@ -11,7 +11,12 @@ HEADERS += engineconfigwidget.h \
     managedproject.h \
     crossref.h \
     cscope.h \
-    files.h
+    files.h \
+    dbreader.h \
+    indexbuilder.h \
+    compiledbfiles.h \
+    snapshotstore.h \
+    snapshot.h
 FORMS += configwidget.ui \
     engineconfigwidget.ui
 SOURCES += engineconfigwidget.cpp \
@@ -20,7 +25,12 @@ SOURCES += engineconfigwidget.cpp \
     managedproject.cpp \
     crossref.cpp \
     cscope.cpp \
-    files.cpp
+    files.cpp \
+    dbreader.cpp \
+    indexbuilder.cpp \
+    compiledbfiles.cpp \
+    snapshotstore.cpp \
+    snapshot.cpp
 INCLUDEPATH += .. \
     .
 CONFIG(debug, debug|release):LIBS += -L../core/debug -lkscope_core
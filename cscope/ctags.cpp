@@ -100,8 +100,13 @@ void Ctags::handleFinished(int code, QProcess::ExitStatus status)
 	if (!locList_.isEmpty())
 		conn_->onDataReady(locList_);
 
-	// Signal normal termination.
-	conn_->onFinished();
+	// Signal termination.
+	if (timedOut())
+		conn_->onTimedOut();
+	else if (cancelled())
+		conn_->onAborted();
+	else
+		conn_->onFinished();
 
 	// Detach from the connection object.
 	conn_->setCtrlObject(NULL);
@@ -50,7 +50,7 @@ public:
 	/**
 	 * Stops a running process.
 	 */
-	virtual void stop() { kill(); }
+	virtual void stop() { cancel(); }
 
 	static QString execPath_;
 
@@ -0,0 +1,232 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDebug>
+#include <string.h>
+#include "dbreader.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * The 16 most frequent first characters of a digraph, as defined by Cscope.
+ */
+static const char dichar1[] = " teisaprnl(of)=c";
+
+/**
+ * The 8 most frequent second characters of a digraph, as defined by Cscope.
+ */
+static const char dichar2[] = " tnerpla";
+
+/**
+ * Class constructor.
+ */
+DbReader::DbReader() : data_(NULL), size_(0), start_(0), compressed_(true)
+{
+}
+
+/**
+ * Class destructor.
+ */
+DbReader::~DbReader()
+{
+	close();
+}
+
+/**
+ * Maps a cross-reference file into memory and parses its header.
+ * @param  path  The path of the cscope.out file
+ * @return true if successful, false otherwise
+ */
+bool DbReader::open(const QString& path)
+{
+	close();
+
+	file_.setFileName(path);
+	if (!file_.open(QIODevice::ReadOnly))
+		return false;
+
+	size_ = file_.size();
+	data_ = reinterpret_cast<const char*>(file_.map(0, size_));
+	if (data_ == NULL) {
+		qDebug() << "Failed to map" << path;
+		close();
+		return false;
+	}
+
+	// The header is a single line of the form:
+	// cscope <version> <directory> [-c] [-q] [-T] <trailer offset>
+	const char* eol = static_cast<const char*>(memchr(data_, '\n', size_));
+	if ((eol == NULL) || (strncmp(data_, "cscope ", 7) != 0)) {
+		qDebug() << "Invalid cross-reference file" << path;
+		close();
+		return false;
+	}
+
+	QByteArray header(data_, eol - data_);
+	compressed_ = !header.split(' ').contains("-c");
+	start_ = (eol - data_) + 1;
+	return true;
+}
+
+/**
+ * Unmaps the file.
+ */
+void DbReader::close()
+{
+	if (data_)
+		file_.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data_)));
+
+	file_.close();
+	data_ = NULL;
+	size_ = 0;
+}
+
+/**
+ * Passes over the symbol data of the database.
+ * @param  visitor  Receives file and symbol information
+ * @return true if the entire database was read, false if the pass was
+ *         aborted by the visitor, or the file is not open
+ */
+bool DbReader::read(Visitor& visitor)
+{
+	enum { RecordStart, SymbolLine, TextLine } state = RecordStart;
+	const char* pos = data_ + start_;
+	const char* end = data_ + size_;
+	uint line = 0;
+	bool wantText = false;
+	QByteArray name;
+
+	if (data_ == NULL)
+		return false;
+
+	while (pos < end) {
+		// Find the end of the current line.
+		const char* eol = static_cast<const char*>(memchr(pos, '\n',
+		                                                  end - pos));
+		if (eol == NULL)
+			eol = end;
+
+		int len = eol - pos;
+
+		switch (state) {
+		case RecordStart:
+			// Either a file mark, or the beginning of a source line.
+			if (len == 0)
+				break;
+
+			if (pos[0] == '\t') {
+				if ((len < 2) || (pos[1] != File))
+					break;
+
+				// An empty file name marks the end of the symbol data.
+				if (len == 2)
+					return true;
+
+				if (visitor.cancelled())
+					return false;
+
+				decode(pos + 2, len - 2, name);
+				visitor.file(QString::fromLocal8Bit(name));
+			}
+			else if ((pos[0] >= '0') && (pos[0] <= '9')) {
+				line = 0;
+				for (int i = 0; (i < len) && (pos[i] >= '0')
+				                && (pos[i] <= '9'); i++) {
+					line = (line * 10) + (pos[i] - '0');
+				}
+
+				state = SymbolLine;
+			}
+			break;
+
+		case SymbolLine:
+			// An empty line ends the source line.
+			if (len == 0) {
+				state = RecordStart;
+				break;
+			}
+
+			if ((pos[0] == '\t') && (len >= 2)) {
+				decode(pos + 2, len - 2, name);
+				wantText = visitor.symbol(pos[1], name, line);
+			}
+			else {
+				decode(pos, len, name);
+				wantText = visitor.symbol(Reference, name, line);
+			}
+
+			state = TextLine;
+			break;
+
+		case TextLine:
+			// Non-symbol text is only decoded on request.
+			if (wantText) {
+				decode(pos, len, name);
+				visitor.text(name);
+				wantText = false;
+			}
+
+			state = SymbolLine;
+			break;
+		}
+
+		pos = eol + 1;
+	}
+
+	return true;
+}
+
+/**
+ * Copies a string from the database, undoing digraph compression.
+ * Each byte with the high bit set encodes two characters: the index of the
+ * first in dichar1 is given by bits 3-6, and the index of the second in
+ * dichar2 by bits 0-2.
+ * @param  str  The encoded string
+ * @param  len  The length of the encoded string
+ * @param  out  Holds the decoded string
+ */
+void DbReader::decode(const char* str, int len, QByteArray& out) const
+{
+	out.resize(0);
+	if (!compressed_) {
+		out.append(str, len);
+		return;
+	}
+
+	for (int i = 0; i < len; i++) {
+		uchar c = static_cast<uchar>(str[i]);
+		if (c & 0x80) {
+			c &= 0x7f;
+			out.append(dichar1[c / 8]);
+			out.append(dichar2[c & 7]);
+		}
+		else {
+			out.append(static_cast<char>(c));
+		}
+	}
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,153 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_DBREADER_H__
+#define __CSCOPE_DBREADER_H__
+
+#include <QFile>
+#include <QByteArray>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Reads the symbol data of a cscope.out cross-reference file directly.
+ * Some information, such as the list of #include directives in the code base
+ * or the set of all symbols, would require a huge number of queries to
+ * extract through the Cscope command-line interface. This class parses the
+ * database file instead, in a single pass.
+ * The file is mapped into memory. For each source file, the database holds a
+ * file mark, followed by the source lines that contain symbols. Each such line
+ * is made of the line number, followed by alternating lines of non-symbol text
+ * and symbols. Symbols may be preceded by a tab and a single-character mark
+ * that classifies them (function definition, function call, #include, etc.).
+ * Unless the database was built with the -c option, text is compressed using
+ * a digraph scheme, which is undone by the reader.
+ * @author Elad Lahav
+ */
+class DbReader
+{
+public:
+	DbReader();
+	~DbReader();
+
+	/**
+	 * Symbol marks, as defined by Cscope.
+	 */
+	enum Mark {
+		Reference = ' ',
+		File = '@',
+		FunctionDef = '$',
+		FunctionCall = '`',
+		FunctionEnd = '}',
+		Define = '#',
+		DefineEnd = ')',
+		Include = '~',
+		Assignment = '=',
+		ClassDef = 'c',
+		EnumDef = 'e',
+		GlobalDef = 'g',
+		LocalDef = 'l',
+		MemberDef = 'm',
+		Parameter = 'p',
+		StructDef = 's',
+		TypedefDef = 't',
+		UnionDef = 'u'
+	};
+
+	/**
+	 * Receives information from the reader.
+	 */
+	struct Visitor
+	{
+		virtual ~Visitor() {}
+
+		/**
+		 * Called when a new source file starts.
+		 * @param  path  The path of the file, as stored in the database
+		 */
+		virtual void file(const QString& path) = 0;
+
+		/**
+		 * Called for each symbol in the current file.
+		 * @param  mark  The type of the symbol (a Mark value)
+		 * @param  name  The name of the symbol
+		 * @param  line  The line number in the source file
+		 * @return true to receive the source text following the symbol
+		 *         through text(), false otherwise
+		 */
+		virtual bool symbol(char mark, const QByteArray& name, uint line) = 0;
+
+		/**
+		 * Called with the source text following a symbol, if requested by
+		 * symbol().
+		 * @param  text  The text up to the next symbol on the line
+		 */
+		virtual void text(const QByteArray& text) { (void)text; }
+
+		/**
+		 * Allows the visitor to abort the pass.
+		 * Checked whenever a new file starts.
+		 * @return true to stop reading, false to continue
+		 */
+		virtual bool cancelled() const { return false; }
+	};
+
+	bool open(const QString&);
+	void close();
+	bool read(Visitor&);
+
+private:
+	/**
+	 * The database file.
+	 */
+	QFile file_;
+
+	/**
+	 * The memory-mapped contents of the file.
+	 */
+	const char* data_;
+
+	/**
+	 * The size of the mapped area.
+	 */
+	qint64 size_;
+
+	/**
+	 * The offset of the first line following the header.
+	 */
+	qint64 start_;
+
+	/**
+	 * Whether the database uses digraph compression.
+	 */
+	bool compressed_;
+
+	void decode(const char*, int, QByteArray&) const;
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_DBREADER_H__
@@ -20,6 +20,7 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QSet>
 #include <QTextStream>
 #include <core/exception.h>
 #include "files.h"
@@ -94,6 +95,8 @@ void Files::open(const QString& path, Core::Callback<>* cb)
 		}
 	}
 
+	emit loaded();
+
 	if (cb)
 		cb->call();
 }
@@ -116,16 +119,83 @@ void Files::getFiles(Core::Callback<const QString&>& cb) const
 
 void Files::setFiles(const QStringList& fileList)
 {
-	QFile file(path_);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	if (!write(fileList, false))
 		return;
 
+	emit modified();
+}
+
+/**
+ * Adds files to, and removes files from, the list.
+ * New files are appended to the existing file, which only needs to be
+ * rewritten if files are removed.
+ * @param  added    Files to add
+ * @param  removed  Files to remove
+ */
+void Files::updateFiles(const QStringList& added, const QStringList& removed)
+{
+	if (!writable_ || (added.isEmpty() && removed.isEmpty()))
+		return;
+
+	if (removed.isEmpty()) {
+		if (!write(added, true))
+			return;
+	}
+	else {
+		QFile file(path_);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+			return;
+
+		// Copy the list, without the removed files.
+		QSet<QString> removedSet = removed.toSet();
+		QStringList fileList;
+		QTextStream strm(&file);
+		while (!strm.atEnd()) {
+			QString path = strm.readLine();
+			if (!removedSet.contains(path))
+				fileList.append(path);
+		}
+
+		file.close();
+		if (!write(fileList + added, false))
+			return;
+	}
+
+	emit filesChanged(added, removed);
+}
+
+/**
+ * Writes files to the cscope.files file.
+ * @param  fileList  The files to write
+ * @param  append    true to add the files to the end of the list, false to
+ *                   replace the list
+ * @return true if successful, false otherwise
+ */
+bool Files::write(const QStringList& fileList, bool append)
+{
+	QFile file(path_);
+	QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+	if (append)
+		mode |= QIODevice::Append;
+
+	if (!file.open(mode))
+		return false;
+
 	QTextStream strm(&file);
 	QStringList::ConstIterator itr;
 	for (itr = fileList.begin(); itr != fileList.end(); ++itr)
 		strm << *itr << endl;
 
-	empty_ = fileList.isEmpty();
+	// Make sure the list is on disk before anyone re-reads it.
+	strm.flush();
+	file.close();
+
+	if (!append)
+		empty_ = fileList.isEmpty();
+	else if (!fileList.isEmpty())
+		empty_ = false;
+
+	return true;
 }
 
 } // namespace Cscope
@@ -53,6 +53,9 @@ public:
 	bool canModify() { return writable_; }
 	bool needFiles() { return writable_ && empty_; }
 
+public slots:
+	void updateFiles(const QStringList&, const QStringList&);
+
 private:
 	/**
 	 * The path to the cscope.files file.
@@ -68,6 +71,8 @@ private:
 	 * Whether the file contains any data.
 	 */
 	bool empty_;
+
+	bool write(const QStringList&, bool);
 };
 
 } // namespace Cscope
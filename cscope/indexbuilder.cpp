@@ -0,0 +1,281 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include "indexbuilder.h"
+#include "dbreader.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Feeds the contents of the database into the indices.
+ * Cscope does not mark function declarations: a prototype such as
+ * "int foo(void);" is recorded as a plain reference to "foo". Such a
+ * reference is recognised by its position outside function bodies and
+ * macro definitions, where it is immediately followed by an opening
+ * parenthesis (calls inside functions are marked as such). Declarations are
+ * not counted as uses of the function, as otherwise every function declared
+ * in a header would appear to be used.
+ */
+struct BuildVisitor : public DbReader::Visitor
+{
+	BuildVisitor(IndexBuilder* builder) : builder_(builder), node_(-1),
+		function_(-1), define_(false) {}
+
+	void file(const QString& path) {
+		addPending();
+		node_ = builder_->includeGraph_.addFile(path);
+		path_ = path;
+		function_ = -1;
+		define_ = false;
+	}
+
+	bool symbol(char mark, const QByteArray& name, uint line) {
+		addPending();
+
+		// The end of a function or a macro definition carries no name.
+		if (mark == DbReader::FunctionEnd) {
+			function_ = -1;
+			return false;
+		}
+
+		if (mark == DbReader::DefineEnd) {
+			define_ = false;
+			return false;
+		}
+
+		if (name.isEmpty())
+			return false;
+
+		bool wantText = false;
+		switch (mark) {
+		case DbReader::Include:
+			addInclude(name, line);
+			return false;
+
+		case DbReader::Define:
+			define_ = true;
+			builder_->metrics_.addDefinition(name, Core::Tag::Define, path_,
+			                                 line);
+			break;
+
+		case DbReader::FunctionDef:
+			function_ = builder_->metrics_.addDefinition(name,
+			                                             Core::Tag::Function,
+			                                             path_, line);
+			break;
+
+		case DbReader::FunctionCall:
+			builder_->metrics_.addCall(function_, path_, name);
+			break;
+
+		case DbReader::Reference:
+			// May be a declaration, which is determined by the text that
+			// follows.
+			if ((function_ < 0) && !define_) {
+				pending_ = name;
+				wantText = true;
+			}
+			else {
+				builder_->metrics_.addReference(path_, name);
+			}
+			break;
+
+		case DbReader::Assignment:
+			builder_->metrics_.addReference(path_, name);
+			break;
+
+		case DbReader::LocalDef:
+		case DbReader::Parameter:
+			// Local names are not reported.
+			break;
+
+		default:
+			builder_->metrics_.addDefinition(name, tagType(mark), path_, line);
+		}
+
+		builder_->symbolIndex_.add(name);
+		return wantText;
+	}
+
+	void text(const QByteArray& text) {
+		// Skip white space between the name and the parameter list.
+		int pos = 0;
+		while ((pos < text.size()) && ((text[pos] == ' ')
+		                               || (text[pos] == '\t'))) {
+			pos++;
+		}
+
+		if ((pos < text.size()) && (text[pos] == '('))
+			pending_.clear();
+		else
+			addPending();
+	}
+
+	/**
+	 * Counts a file-scope reference that turned out not to be a
+	 * declaration.
+	 */
+	void addPending() {
+		if (!pending_.isEmpty()) {
+			builder_->metrics_.addReference(path_, pending_);
+			pending_.clear();
+		}
+	}
+
+	static Core::Tag::Type tagType(char mark) {
+		switch (mark) {
+		case DbReader::Define:
+			return Core::Tag::Define;
+
+		case DbReader::ClassDef:
+		case DbReader::StructDef:
+			return Core::Tag::Struct;
+
+		case DbReader::EnumDef:
+			return Core::Tag::Enum;
+
+		case DbReader::GlobalDef:
+			return Core::Tag::Variable;
+
+		case DbReader::MemberDef:
+			return Core::Tag::Member;
+
+		case DbReader::TypedefDef:
+			return Core::Tag::Typedef;
+
+		case DbReader::UnionDef:
+			return Core::Tag::Union;
+		}
+
+		return Core::Tag::UnknownTag;
+	}
+
+	void addInclude(const QByteArray& name, uint line) {
+		if (node_ < 0)
+			return;
+
+		// The name starts with the opening delimiter of the directive.
+		// Depending on the version of Cscope, the closing one may also be
+		// included.
+		bool system = (name[0] == '<');
+		QByteArray incName = name;
+		if (system || (name[0] == '"'))
+			incName.remove(0, 1);
+		if (incName.endsWith('>') || incName.endsWith('"'))
+			incName.chop(1);
+
+		if (!incName.isEmpty()) {
+			builder_->includeGraph_.addInclude(node_,
+			                                   QString::fromLocal8Bit(incName),
+			                                   system, line);
+		}
+	}
+
+	bool cancelled() const { return builder_->stop_; }
+
+	IndexBuilder* builder_;
+	int node_;
+	QString path_;
+	int function_;
+	bool define_;
+	QByteArray pending_;
+};
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+IndexBuilder::IndexBuilder(QObject* parent) : QThread(parent), stop_(false),
+	succeeded_(false)
+{
+}
+
+/**
+ * Class destructor.
+ */
+IndexBuilder::~IndexBuilder()
+{
+	stop();
+}
+
+/**
+ * Starts a new pass over the given database file.
+ * @param  dbPath  The path of the cscope.out file
+ */
+void IndexBuilder::start(const QString& dbPath)
+{
+	stop();
+
+	dbPath_ = dbPath;
+	stop_ = false;
+	succeeded_ = false;
+	includeGraph_ = Core::IncludeGraph();
+	symbolIndex_.clear();
+	metrics_.clear();
+	QThread::start(QThread::LowPriority);
+}
+
+/**
+ * Aborts the current pass, and waits for the thread to terminate.
+ */
+void IndexBuilder::stop()
+{
+	stop_ = true;
+	wait();
+}
+
+/**
+ * The thread's main function.
+ */
+void IndexBuilder::run()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	DbReader reader;
+	if (!reader.open(dbPath_))
+		return;
+
+	BuildVisitor visitor(this);
+	if (!reader.read(visitor))
+		return;
+
+	visitor.addPending();
+
+	includeGraph_.resolve();
+	symbolIndex_.finalize();
+	metrics_.finalize(includeGraph_);
+	succeeded_ = !stop_;
+
+	qDebug() << __func__ << includeGraph_.size() << "files"
+	         << includeGraph_.edgeCount() << "#include directives"
+	         << symbolIndex_.size() << "symbols"
+	         << timer.elapsed() << "ms";
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_INDEXBUILDER_H__
+#define __CSCOPE_INDEXBUILDER_H__
+
+#include <QThread>
+#include <core/includegraph.h>
+#include <core/codemetrics.h>
+#include <core/symbolindex.h>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Extracts in-memory indices from a cscope.out file.
+ * These include the graph of #include directives, the list of all symbols
+ * in the code base and the code metrics derived from definitions, calls and
+ * references.
+ * Reading the database can take a few seconds for large code bases, and so
+ * is done in a separate thread. Once the thread finishes, the owner of the
+ * object can take the new indices.
+ * @author Elad Lahav
+ */
+class IndexBuilder : public QThread
+{
+	Q_OBJECT
+
+public:
+	IndexBuilder(QObject* parent = 0);
+	~IndexBuilder();
+
+	void start(const QString&);
+	void stop();
+
+	/**
+	 * @return true if the last pass completed successfully, false otherwise
+	 */
+	bool succeeded() const { return succeeded_; }
+
+	/**
+	 * @return The include graph generated by the last pass
+	 */
+	Core::IncludeGraph& includeGraph() { return includeGraph_; }
+
+	/**
+	 * @return The symbol index generated by the last pass
+	 */
+	Core::SymbolIndex& symbolIndex() { return symbolIndex_; }
+
+	/**
+	 * @return The code metrics generated by the last pass
+	 */
+	Core::CodeMetrics& metrics() { return metrics_; }
+
+protected:
+	virtual void run();
+
+private:
+	/**
+	 * The path of the cscope.out file.
+	 */
+	QString dbPath_;
+
+	/**
+	 * Set by stop() to abort the pass.
+	 */
+	volatile bool stop_;
+
+	/**
+	 * Whether the last pass completed successfully.
+	 */
+	bool succeeded_;
+
+	/**
+	 * The generated include graph.
+	 */
+	Core::IncludeGraph includeGraph_;
+
+	/**
+	 * The generated symbol index.
+	 */
+	Core::SymbolIndex symbolIndex_;
+
+	/**
+	 * The generated code metrics.
+	 */
+	Core::CodeMetrics metrics_;
+
+	friend struct BuildVisitor;
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_INDEXBUILDER_H__
@@ -31,8 +31,10 @@ namespace Cscope
  * @param  projPath The directory to use for this project
  */
 ManagedProject::ManagedProject(const QString& projPath)
-	: Core::Project<Crossref, Files>("project.conf", projPath)
+	: Core::Project<Crossref, CompileDbFiles>("project.conf", projPath)
 {
+	// Let the engine track changes to the list of files.
+	engine_.setCodebase(&codebase_);
 }
 
 /**
@@ -50,7 +52,7 @@ ManagedProject::~ManagedProject()
 void ManagedProject::create(const Core::ProjectBase::Params& params)
 {
 	try {
-		Core::Project<Crossref, Files>::create(params);
+		Core::Project<Crossref, CompileDbFiles>::create(params);
 		Files().create(params.projPath_);
 	}
 	catch (Core::Exception* e) {
@@ -66,11 +68,18 @@ void ManagedProject::create(const Core::ProjectBase::Params& params)
 void ManagedProject::updateConfig(const Core::ProjectBase::Params& params)
 {
 	try {
+		bool codebaseChanged
+			= (params.codebaseString_ != params_.codebaseString_);
+
 		// Base class implementation.
-		Core::Project<Crossref, Files>::updateConfig(params);
+		Core::Project<Crossref, CompileDbFiles>::updateConfig(params);
 
 		// Apply changes to the engine.
 		engine_.open(params.engineString_, NULL);
+
+		// Switching to or from a compilation database changes the file list.
+		if (codebaseChanged)
+			codebase_.open(params.codebaseString_, NULL);
 	}
 	catch (Core::Exception* e) {
 		throw e;
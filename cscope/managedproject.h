@@ -24,7 +24,7 @@
 #include <core/project.h>
 #include <core/projectconfig.h>
 #include "crossref.h"
-#include "files.h"
+#include "compiledbfiles.h"
 #include "configwidget.h"
 
 namespace KScope
@@ -36,10 +36,11 @@ namespace Cscope
 /**
  * A managed Cscope project.
  * This is a managed project, since KScope has control over the code base, which
- * is kept as a cscope.files file.
+ * is kept as a cscope.files file. The file list can either be edited by the
+ * user, or derived from a compilation database.
  * @author Elad Lahav
  */
-class ManagedProject : public Core::Project<Crossref, Files>
+class ManagedProject : public Core::Project<Crossref, CompileDbFiles>
 {
 public:
 	ManagedProject(const QString& projPath = QString());
@@ -82,12 +83,19 @@ struct ProjectConfig<Cscope::ManagedProject>
 			widget->kernelCheck_->setChecked(args.contains("-k"));
 			widget->invIndexCheck_->setChecked(args.contains("-q"));
 			widget->compressCheck_->setChecked(!args.contains("-c"));
+
+			// The code base string may name a compilation database.
+			args = params.codebaseString_.split("*");
+			widget->includeHeadersCheck_->setChecked(args.removeAll("-I") > 0);
+			if (args.size() > 1)
+				widget->compileDbEdit_->setText(args[1]);
 		}
 		else {
 			// New project: set default configuration.
 			widget->kernelCheck_->setChecked(false);
 			widget->invIndexCheck_->setChecked(true);
 			widget->compressCheck_->setChecked(true);
+			widget->includeHeadersCheck_->setChecked(false);
 		}
 
 		return widget;
@@ -112,6 +120,13 @@ struct ProjectConfig<Cscope::ManagedProject>
 				params.engineString_ += "*-q";
 			if (!confWidget->compressCheck_->isChecked())
 				params.engineString_ += "*-c";
+
+			QString dbPath = confWidget->compileDbEdit_->text().trimmed();
+			if (!dbPath.isEmpty()) {
+				params.codebaseString_ += "*" + dbPath;
+				if (confWidget->includeHeadersCheck_->isChecked())
+					params.codebaseString_ += "*-I";
+			}
 		}
 	}
 };
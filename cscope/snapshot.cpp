@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <core/exception.h>
+#include "crossref.h"
+#include "snapshot.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Class constructor.
+ * @param  crossref  The database from which the snapshot was taken
+ * @param  path      The directory holding the snapshot files
+ * @param  parent    Parent object
+ */
+Snapshot::Snapshot(const Crossref& crossref, const QString& path,
+                   QObject* parent)
+	: Core::Engine(parent), crossref_(crossref), path_(path)
+{
+}
+
+/**
+ * Class destructor.
+ */
+Snapshot::~Snapshot()
+{
+}
+
+/**
+ * Snapshots are ready as soon as they are created.
+ * @param  initString  Ignored
+ * @param  cb          Called immediately
+ */
+void Snapshot::open(const QString& initString, Core::Callback<>* cb)
+{
+	(void)initString;
+	if (cb)
+		cb->call();
+}
+
+/**
+ * @param  type  The requested query type
+ * @return The fields filled by the original database for the query type
+ */
+QList<Core::Location::Fields> Snapshot::queryFields(Core::Query::Type type)
+	const
+{
+	return crossref_.queryFields(type);
+}
+
+/**
+ * Starts a Cscope query on the snapshot files.
+ * Text and regular expression searches are not supported, as Cscope answers
+ * those by reading the current source files, rather than the snapshot.
+ * @param  conn   Connection object to attach to the new process
+ * @param  query  Query information
+ * @throw  Exception
+ */
+void Snapshot::query(Core::Engine::Connection* conn,
+                     const Core::Query& query) const
+{
+	Cscope::QueryArg args;
+	args.flags = query.flags_;
+	args.pathPrefixes = query.pathPrefixes_;
+	args.timeout = query.timeout_;
+
+	switch (query.type_) {
+	case Core::Query::Text:
+		throw new Core::Exception("Text searches cannot be compared with a "
+		                          "snapshot, as they read the current "
+		                          "source files");
+
+	case Core::Query::References:
+		args.type = Cscope::References;
+		break;
+
+	case Core::Query::Definition:
+		args.type = Cscope::Definition;
+		break;
+
+	case Core::Query::CalledFunctions:
+		args.type = Cscope::CalledFunctions;
+		break;
+
+	case Core::Query::CallingFunctions:
+		args.type = Cscope::CallingFunctions;
+		break;
+
+	case Core::Query::FindFile:
+		args.type = Cscope::FindFile;
+		break;
+
+	case Core::Query::IncludingFiles:
+		args.type = Cscope::IncludingFiles;
+		break;
+
+	default:
+		throw new Core::Exception(QString("Query type '%1' is not supported "
+		                                  "for snapshots").arg(query.type_));
+	}
+
+	Cscope* cscope = new Cscope();
+	cscope->setDeleteOnExit();
+	cscope->query(conn, path_, args, query.pattern_);
+}
+
+/**
+ * Snapshots cannot be rebuilt.
+ * @param  conn  Ignored
+ * @throw  Exception
+ */
+void Snapshot::build(Core::Engine::Connection* conn) const
+{
+	(void)conn;
+	throw new Core::Exception("Snapshots cannot be rebuilt");
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_SNAPSHOT_H__
+#define __CSCOPE_SNAPSHOT_H__
+
+#include <core/engine.h>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+class Crossref;
+
+/**
+ * Queries a snapshot of a Cscope database.
+ * Unlike Crossref, no in-memory indices are built for the snapshot, so all
+ * queries are passed to Cscope, and only the query types Cscope answers
+ * directly are supported.
+ * @author Elad Lahav
+ */
+class Snapshot : public Core::Engine
+{
+	Q_OBJECT
+
+public:
+	Snapshot(const Crossref& crossref, const QString& path,
+	         QObject* parent = NULL);
+	~Snapshot();
+
+	// Engine implementation.
+	void open(const QString& initString, Core::Callback<>* cb);
+	Status status() const { return Ready; }
+	QList<Core::Location::Fields> queryFields(Core::Query::Type type) const;
+
+public slots:
+	void query(Core::Engine::Connection* conn, const Core::Query& query) const;
+	void build(Core::Engine::Connection* conn) const;
+
+private:
+	/**
+	 * The database from which the snapshot was taken.
+	 */
+	const Crossref& crossref_;
+
+	/**
+	 * The directory holding the snapshot files.
+	 */
+	QString path_;
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_SNAPSHOT_H__
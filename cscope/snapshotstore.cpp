@@ -0,0 +1,251 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QDebug>
+#include "snapshotstore.h"
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * The database files copied into a snapshot.
+ */
+static const char* DbFiles[] = {
+	"cscope.out",
+	"cscope.in.out",
+	"cscope.po.out",
+	NULL
+};
+
+/**
+ * Class constructor.
+ */
+SnapshotStore::SnapshotStore()
+{
+}
+
+/**
+ * Class destructor.
+ */
+SnapshotStore::~SnapshotStore()
+{
+}
+
+/**
+ * @param  dbPath  The directory holding the database
+ */
+void SnapshotStore::setPath(const QString& dbPath)
+{
+	dbPath_ = dbPath;
+	storePath_ = QDir(dbPath).filePath("snapshots");
+}
+
+/**
+ * Creates a snapshot of the current database.
+ * An existing snapshot with the same name is replaced. If the number of
+ * snapshots exceeds MaxSnapshots, the oldest ones are removed.
+ * @param  name  The name of the snapshot
+ * @return true if successful, false otherwise
+ */
+bool SnapshotStore::create(const QString& name)
+{
+	if (!isValidName(name))
+		return false;
+
+	if (!QFileInfo(QDir(dbPath_), "cscope.out").exists())
+		return false;
+
+	// Write a new snapshot under a temporary name, so that a failure does not
+	// destroy an existing snapshot with the same name.
+	QDir storeDir(storePath_);
+	if (!storeDir.mkpath("objects"))
+		return false;
+
+	QString tmpName = "." + name + ".tmp";
+	QDir(storeDir.filePath(tmpName)).removeRecursively();
+	if (!storeDir.mkdir(tmpName))
+		return false;
+
+	QDir tmpDir(storeDir.filePath(tmpName));
+	for (int i = 0; DbFiles[i] != NULL; i++) {
+		QFileInfo fi(QDir(dbPath_), DbFiles[i]);
+		if (!fi.exists())
+			continue;
+
+		QString object = store(fi.filePath());
+		if (object.isEmpty()
+		    || !linkFile(object, tmpDir.filePath(DbFiles[i]))) {
+			tmpDir.removeRecursively();
+			prune();
+			return false;
+		}
+	}
+
+	// Replace the old snapshot.
+	QDir(storeDir.filePath(name)).removeRecursively();
+	if (!storeDir.rename(tmpName, name)) {
+		tmpDir.removeRecursively();
+		prune();
+		return false;
+	}
+
+	// Drop the oldest snapshots.
+	QStringList names = list();
+	while (names.size() > MaxSnapshots)
+		QDir(storeDir.filePath(names.takeLast())).removeRecursively();
+
+	prune();
+	return true;
+}
+
+/**
+ * Deletes a snapshot.
+ * @param  name  The name of the snapshot
+ * @return true if successful, false otherwise
+ */
+bool SnapshotStore::remove(const QString& name)
+{
+	if (!list().contains(name))
+		return false;
+
+	bool result = QDir(path(name)).removeRecursively();
+	prune();
+	return result;
+}
+
+/**
+ * @return The names of all snapshots, most recent first
+ */
+QStringList SnapshotStore::list() const
+{
+	QDir storeDir(storePath_);
+	QStringList names = storeDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot,
+	                                       QDir::Time);
+	names.removeAll("objects");
+	return names;
+}
+
+/**
+ * @param  name  The name of a snapshot
+ * @return The directory holding the database files of the snapshot
+ */
+QString SnapshotStore::path(const QString& name) const
+{
+	return QDir(storePath_).filePath(name);
+}
+
+/**
+ * Checks whether a string can be used as the name of a snapshot.
+ * Snapshots are directories in the store, which is removed recursively when
+ * a snapshot is replaced, and so names that refer to other directories (such
+ * as ".." or "objects") must be rejected. Names starting with a dot are
+ * reserved for temporary directories.
+ * @param  name  The name to check
+ * @return true if the name is valid, false otherwise
+ */
+bool SnapshotStore::isValidName(const QString& name)
+{
+	static QRegExp nameRE("[A-Za-z0-9_-][A-Za-z0-9._-]*");
+	return nameRE.exactMatch(name) && (name != "objects");
+}
+
+/**
+ * Adds a file to the object directory, unless a file with the same contents
+ * is already there.
+ * @param  filePath  The file to add
+ * @return The path of the stored file, or an empty string on failure
+ */
+QString SnapshotStore::store(const QString& filePath)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly))
+		return QString();
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	if (!hash.addData(&file))
+		return QString();
+
+	file.close();
+
+	QDir objDir(QDir(storePath_).filePath("objects"));
+	QString object = objDir.filePath(hash.result().toHex());
+	if (QFileInfo(object).exists())
+		return object;
+
+	// Copy under a temporary name first, so that a partial copy is never
+	// mistaken for a stored file.
+	QString tmpObject = object + ".tmp";
+	QFile::remove(tmpObject);
+	if (!QFile::copy(filePath, tmpObject)
+	    || !QFile::rename(tmpObject, object)) {
+		QFile::remove(tmpObject);
+		return QString();
+	}
+
+	return object;
+}
+
+/**
+ * Deletes stored files that are not linked from any snapshot.
+ * Such files have a single link, from the object directory.
+ */
+void SnapshotStore::prune()
+{
+	QDir objDir(QDir(storePath_).filePath("objects"));
+	QStringList objects = objDir.entryList(QDir::Files);
+	foreach (const QString& object, objects) {
+		QString objPath = objDir.filePath(object);
+		struct stat st;
+		if (::stat(QFile::encodeName(objPath).constData(), &st) < 0)
+			continue;
+
+		if (st.st_nlink <= 1) {
+			qDebug() << "Removing unreferenced snapshot object" << object;
+			QFile::remove(objPath);
+		}
+	}
+}
+
+/**
+ * Creates a hard link to a stored file.
+ * @param  target  The stored file
+ * @param  link    The path of the link
+ * @return true if successful, false otherwise
+ */
+bool SnapshotStore::linkFile(const QString& target, const QString& link)
+{
+	return ::link(QFile::encodeName(target).constData(),
+	              QFile::encodeName(link).constData()) == 0;
+}
+
+} // namespace Cscope
+
+} // namespace KScope
@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __CSCOPE_SNAPSHOTSTORE_H__
+#define __CSCOPE_SNAPSHOTSTORE_H__
+
+#include <QStringList>
+
+namespace KScope
+{
+
+namespace Cscope
+{
+
+/**
+ * Keeps copies of the database files, so that old versions of the database
+ * can be queried after it is rebuilt.
+ * Files are stored once, under a name derived from a hash of their contents,
+ * in an "objects" directory. Each snapshot is a directory holding hard links
+ * to the stored files, so a file that did not change between snapshots (e.g.,
+ * an inverted index that was not rebuilt) takes no additional space, and a
+ * snapshot directory can be passed to Cscope as a database directory.
+ * Stored files that are no longer linked from any snapshot are deleted
+ * whenever a snapshot is removed. Only the most recent MaxSnapshots snapshots
+ * are kept.
+ * @author Elad Lahav
+ */
+class SnapshotStore
+{
+public:
+	SnapshotStore();
+	~SnapshotStore();
+
+	void setPath(const QString& dbPath);
+	bool create(const QString& name);
+	bool remove(const QString& name);
+	QStringList list() const;
+	QString path(const QString& name) const;
+
+	static bool isValidName(const QString& name);
+
+	/**
+	 * The maximal number of snapshots kept.
+	 */
+	static const int MaxSnapshots = 12;
+
+private:
+	/**
+	 * The directory holding the database.
+	 */
+	QString dbPath_;
+
+	/**
+	 * The directory holding the snapshots.
+	 */
+	QString storePath_;
+
+	QString store(const QString& filePath);
+	void prune();
+
+	static bool linkFile(const QString& target, const QString& link);
+};
+
+} // namespace Cscope
+
+} // namespace KScope
+
+#endif // __CSCOPE_SNAPSHOTSTORE_H__
@@ -45,6 +45,12 @@ Editor::Editor(QWidget* parent) : ViScintilla(parent),
 	onLoadColumn_(0),
 	onLoadFocus_(false)
 {
+	// Report the symbol under the mouse pointer after a short delay.
+	SendScintilla(SCI_SETMOUSEDWELLTIME, HoverDelay);
+	connect(this, SIGNAL(SCN_DWELLSTART(int, int, int)), this,
+	        SLOT(dwellStart(int, int, int)));
+	connect(this, SIGNAL(SCN_DWELLEND(int, int, int)), this,
+	        SLOT(dwellEnd(int, int, int)));
 }
 
 /**
@@ -225,29 +231,8 @@ QString Editor::currentSymbol() const
 		return QsciScintilla::selectedText();
 
 	// No selected text.
-	// Get the boundaries of the word from the current cursor position.
-	long pos, start, end;
-	pos = SendScintilla(SCI_GETCURRENTPOS);
-	start = SendScintilla(SCI_WORDSTARTPOSITION, pos, 0L);
-	end = SendScintilla(SCI_WORDENDPOSITION, pos, 0L);
-
-	// Return an empty string if no word is found.
-	if (start >= end)
-		return QString();
-
-	// Extract the word's text using its position boundaries.
-	QByteArray curText;
-	curText.resize(end - start );
-	SendScintilla(SCI_GETTEXTRANGE, start, end, curText.data());
-
-	// NOTE: Scintilla's definition of a "word" does not correspond to a
-	// "symbol". Make sure the result contains only alpha-numeric characters
-	// or an underscore.
-	QString symbol(curText);
-	if (!QRegExp("\\w+").exactMatch(symbol))
-		return QString();
-
-	return symbol;
+	// Get the word at the current cursor position.
+	return symbolAt(SendScintilla(SCI_GETCURRENTPOS));
 }
 
 /**
@@ -396,6 +381,72 @@ void Editor::loadDone(const QString& text)
 	}
 }
 
+/**
+ * Returns the symbol at the given position in the text.
+ * @param  pos  A position in the document
+ * @return The symbol, or an empty string if the position is not on a symbol
+ */
+QString Editor::symbolAt(long pos) const
+{
+	// Get the boundaries of the word from the given position.
+	long start, end;
+	start = SendScintilla(SCI_WORDSTARTPOSITION, pos, 0L);
+	end = SendScintilla(SCI_WORDENDPOSITION, pos, 0L);
+
+	// Return an empty string if no word is found.
+	if (start >= end)
+		return QString();
+
+	// Extract the word's text using its position boundaries.
+	QByteArray curText;
+	curText.resize(end - start );
+	SendScintilla(SCI_GETTEXTRANGE, start, end, curText.data());
+
+	// NOTE: Scintilla's definition of a "word" does not correspond to a
+	// "symbol". Make sure the result contains only alpha-numeric characters
+	// or an underscore.
+	QString symbol(curText);
+	if (!QRegExp("\\w+").exactMatch(symbol))
+		return QString();
+
+	return symbol;
+}
+
+/**
+ * Called when the mouse pointer rests over the text.
+ * Emits symbolHovered() if the pointer is on a symbol.
+ * @param  pos  The position in the document under the pointer, -1 if the
+ *              pointer is not over any text
+ * @param  x    The horizontal coordinate of the pointer
+ * @param  y    The vertical coordinate of the pointer
+ */
+void Editor::dwellStart(int pos, int x, int y)
+{
+	if (isLoading_ || (pos < 0))
+		return;
+
+	QString symbol = symbolAt(pos);
+	if (symbol.isEmpty())
+		return;
+
+	emit symbolHovered(symbol, viewport()->mapToGlobal(QPoint(x, y)));
+}
+
+/**
+ * Called when the mouse pointer moves, or a key is pressed, after
+ * dwellStart().
+ * @param  pos  Unused
+ * @param  x    Unused
+ * @param  y    Unused
+ */
+void Editor::dwellEnd(int pos, int x, int y)
+{
+	(void)pos;
+	(void)x;
+	(void)y;
+	emit hoverEnded();
+}
+
 } // namespace Editor
 
 } // namespace KScope
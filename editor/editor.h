@@ -115,10 +115,29 @@ signals:
 	 */
 	void titleChanged(const QString& oldTitle, const QString& newTitle);
 
+	/**
+	 * Emitted when the mouse pointer rests over a symbol.
+	 * @param  symbol  The symbol under the pointer
+	 * @param  pos     The position of the pointer, in global coordinates
+	 */
+	void symbolHovered(const QString& symbol, const QPoint& pos);
+
+	/**
+	 * Emitted when the pointer moves away, or a key is pressed, after
+	 * symbolHovered().
+	 */
+	void hoverEnded();
+
 protected:
 	void closeEvent(QCloseEvent*);
 
 private:
+	/**
+	 * The time, in milliseconds, the mouse pointer needs to rest over a
+	 * symbol before symbolHovered() is emitted.
+	 */
+	static const int HoverDelay = 300;
+
 	/**
 	 * The file being edited.
 	 */
@@ -150,8 +169,12 @@ private:
 	 */
 	bool onLoadFocus_;
 
+	QString symbolAt(long) const;
+
 private slots:
 	void loadDone(const QString&);
+	void dwellStart(int, int, int);
+	void dwellEnd(int, int, int);
 };
 
 } // namespace Editor
@@ -0,0 +1,287 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QRegExp>
+#include <core/exception.h>
+#include <cscope/ctags.h>
+#include "crossref.h"
+
+namespace KScope
+{
+
+namespace Global
+{
+
+/**
+ * Escapes characters that have a special meaning in extended regular
+ * expressions.
+ * @param  text  The text to escape
+ * @return The escaped text
+ */
+static QString escapeRegExp(const QString& text)
+{
+	QString result;
+	foreach (QChar c, text) {
+		if (QString(".[]()*+?^$|\\{}").contains(c))
+			result += '\\';
+		result += c;
+	}
+
+	return result;
+}
+
+/**
+ * Class constructor.
+ * @param  parent  Parent object
+ */
+Crossref::Crossref(QObject* parent) : Core::Engine(parent), status_(Unknown),
+	codebase_(NULL)
+{
+}
+
+/**
+ * Class destructor.
+ */
+Crossref::~Crossref()
+{
+}
+
+/**
+ * Opens a GNU Global database.
+ * The initialisation string is made of the path of the directory holding the
+ * database files, followed by the root path of the code base, separated by an
+ * asterisk.
+ * @param  initString  The initialisation string
+ * @param  cb          Called once the database is open
+ * @throw  Exception
+ */
+void Crossref::open(const QString& initString, Core::Callback<>* cb)
+{
+	// Parse the initialisation string.
+	QStringList args = initString.split("*", QString::SkipEmptyParts);
+	if (args.isEmpty())
+		throw new Core::Exception("Invalid engine initialisation string");
+
+	QString path = args.takeFirst();
+	QString rootPath = args.isEmpty() ? QString("/") : args.takeFirst();
+
+	// Make sure the path exists.
+	QDir dir(path);
+	if (!dir.exists())
+		throw new Core::Exception("Database directory does not exist");
+
+	// Handle reopening with different parameters (i.e., after a change to the
+	// project parameters).
+	Status status = Ready;
+	if ((status_ != Unknown) && (rootPath != rootPath_))
+		status = Rebuild;
+
+	path_ = path;
+	rootPath_ = rootPath;
+	status_ = dbExists() ? status : Build;
+
+	if (cb)
+		cb->call();
+}
+
+/**
+ * Builds a list of fields for each query type.
+ * @param  type  Query type
+ * @return A list of Location structure fields
+ */
+QList<Core::Location::Fields>
+Crossref::queryFields(Core::Query::Type type) const
+{
+	QList<Core::Location::Fields> fieldList;
+
+	switch (type) {
+	case Core::Query::FindFile:
+		fieldList << Core::Location::File;
+		break;
+
+	case Core::Query::Text:
+	case Core::Query::IncludingFiles:
+		fieldList << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
+	case Core::Query::Definition:
+	case Core::Query::References:
+	case Core::Query::CallingFunctions:
+		fieldList << Core::Location::TagName
+		          << Core::Location::File
+		          << Core::Location::Line
+		          << Core::Location::Text;
+		break;
+
+	case Core::Query::LocalTags:
+		fieldList << Core::Location::TagName
+		          << Core::Location::Scope
+		          << Core::Location::Line
+		          << Core::Location::TagType;
+		break;
+
+	default:
+		;
+	}
+
+	return fieldList;
+}
+
+/**
+ * Associates the database with the code base it indexes.
+ * Changes to the list of files mark the database as out of date.
+ * @param  cbase  The code base object
+ */
+void Crossref::setCodebase(const Core::Codebase* cbase)
+{
+	if (codebase_)
+		disconnect(codebase_, NULL, this, NULL);
+
+	codebase_ = cbase;
+	if (codebase_)
+		connect(codebase_, SIGNAL(modified()), this, SLOT(codebaseModified()));
+}
+
+/**
+ * Starts a query.
+ * Query types are translated into 'global' command-line options. Note that
+ * GNU Global does not distinguish between function calls and other
+ * references, and does not record the scope of a reference. Thus, a query for
+ * calling functions returns all references to the given function, and there
+ * is no support for a query of called functions.
+ * @param  conn   Connection object to attach to the new process
+ * @param  query  Query information
+ * @throw  Exception
+ */
+void Crossref::query(Core::Engine::Connection* conn,
+                     const Core::Query& query) const
+{
+	QStringList args;
+	bool regExp = (query.flags_ & Core::Query::RegExp) != 0;
+	bool grep = false;
+
+	if (query.flags_ & Core::Query::IgnoreCase)
+		args << "-i";
+
+	switch (query.type_) {
+	case Core::Query::Definition:
+		args << "-d" << query.pattern_;
+		break;
+
+	case Core::Query::References:
+	case Core::Query::CallingFunctions:
+		args << "-r" << query.pattern_;
+		break;
+
+	case Core::Query::Text:
+		args << "-g";
+		if (!regExp)
+			args << "--literal";
+		args << query.pattern_;
+		grep = true;
+		break;
+
+	case Core::Query::FindFile:
+		args << "-P" << (regExp ? query.pattern_
+		                        : escapeRegExp(query.pattern_));
+		break;
+
+	case Core::Query::IncludingFiles:
+		args << "-g"
+		     << QString("^[ \t]*#[ \t]*include[ \t]*[\"<](.*/)?%1[\">]")
+		        .arg(regExp ? query.pattern_ : escapeRegExp(query.pattern_));
+		grep = true;
+		break;
+
+	case Core::Query::LocalTags:
+		{
+			Cscope::Ctags* ctags = new Cscope::Ctags();
+			ctags->setDeleteOnExit();
+			ctags->setDeadline(query.timeout_);
+			ctags->query(conn, query.pattern_);
+			return;
+		}
+
+	default:
+		throw new Core::Exception(QString("Unsupported query type '%1'")
+		                          .arg(query.type_));
+	}
+
+	// Create a new process object, and start the query.
+	Gtags* gtags = new Gtags();
+	gtags->setDeleteOnExit();
+	gtags->setDeadline(query.timeout_);
+
+	// Searches with -g read every source file, and may not produce any output
+	// for a long time. Only the deadline applies to these.
+	if (grep)
+		gtags->setIdleTimeout(0);
+
+	gtags->query(conn, path_, rootPath_, args, query.pathPrefixes_);
+}
+
+/**
+ * Builds or updates the database.
+ * If a database already exists, it is updated incrementally.
+ * @param  conn  Connection object to attach to the new process
+ */
+void Crossref::build(Core::Engine::Connection* conn) const
+{
+	Gtags* gtags = new Gtags();
+	gtags->setDeleteOnExit();
+
+	// Need to update the status upon successful termination.
+	connect(gtags, SIGNAL(finished(int, QProcess::ExitStatus)), this,
+	        SLOT(buildProcessFinished(int, QProcess::ExitStatus)));
+
+	gtags->build(conn, path_, rootPath_, dbExists());
+}
+
+/**
+ * @return true if the database files exist, false otherwise
+ */
+bool Crossref::dbExists() const
+{
+	QDir dir(path_);
+	return dir.exists("GTAGS") && dir.exists("GRTAGS") && dir.exists("GPATH");
+}
+
+void Crossref::buildProcessFinished(int code, QProcess::ExitStatus status)
+{
+	if ((code == 0) && (status == QProcess::NormalExit))
+		status_ = Ready;
+}
+
+/**
+ * Called when files are added to or removed from the code base.
+ */
+void Crossref::codebaseModified()
+{
+	if (status_ == Ready)
+		status_ = Rebuild;
+}
+
+} // namespace Global
+
+} // namespace KScope
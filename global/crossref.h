@@ -0,0 +1,146 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __GLOBAL_CROSSREF_H__
+#define __GLOBAL_CROSSREF_H__
+
+#include <core/engine.h>
+#include <core/codebase.h>
+#include "engineconfigwidget.h"
+#include "gtags.h"
+
+namespace KScope
+{
+
+namespace Global
+{
+
+/**
+ * Manages a GNU Global database.
+ * The database (GTAGS, GRTAGS and GPATH files) is kept in the project
+ * directory, and is generated from the list of files in cscope.files.
+ * Unlike Cscope, GNU Global can update an existing database incrementally, so
+ * that only modified files need to be parsed again. Any build after the first
+ * one is therefore an incremental update.
+ * @author Elad Lahav
+ */
+class Crossref : public Core::Engine
+{
+	Q_OBJECT
+
+public:
+	Crossref(QObject* parent = 0);
+	~Crossref();
+
+	void open(const QString&, Core::Callback<>*);
+
+	/**
+	 * @return The current status of the database.
+	 */
+	Status status() const { return status_; }
+
+	QList<Core::Location::Fields> queryFields(Core::Query::Type) const;
+
+	void setCodebase(const Core::Codebase*);
+
+public slots:
+	void query(Core::Engine::Connection*, const Core::Query&) const;
+	void build(Core::Engine::Connection*) const;
+
+private:
+	/**
+	 * The path of the directory containing the database files.
+	 */
+	QString path_;
+
+	/**
+	 * The root directory of the code base.
+	 */
+	QString rootPath_;
+
+	/**
+	 * The current status of the database.
+	 */
+	Status status_;
+
+	/**
+	 * The code base indexed by the database (may be NULL).
+	 */
+	const Core::Codebase* codebase_;
+
+	bool dbExists() const;
+
+private slots:
+	void buildProcessFinished(int, QProcess::ExitStatus);
+	void codebaseModified();
+};
+
+} // namespace Global
+
+namespace Core
+{
+
+/**
+ * Provides configuration management for the GNU Global engine.
+ */
+template<>
+struct EngineConfig<Global::Crossref>
+{
+	static QString name() { return "GNU Global"; }
+
+	static void getConfig(KeyValuePairs& confParams) {
+		confParams["GlobalPath"] = Global::Gtags::globalPath_;
+		confParams["GtagsPath"] = Global::Gtags::gtagsPath_;
+	}
+
+	static void setConfig(const KeyValuePairs& confParams) {
+		QString globalPath = confParams["GlobalPath"].toString();
+		if (!globalPath.isEmpty())
+			Global::Gtags::globalPath_ = globalPath;
+
+		QString gtagsPath = confParams["GtagsPath"].toString();
+		if (!gtagsPath.isEmpty())
+			Global::Gtags::gtagsPath_ = gtagsPath;
+	}
+
+	static QWidget* createConfigWidget(QWidget* parent) {
+		Global::EngineConfigWidget* widget
+			= new Global::EngineConfigWidget(parent);
+		widget->globalPathEdit_->setText(Global::Gtags::globalPath_);
+		widget->gtagsPathEdit_->setText(Global::Gtags::gtagsPath_);
+		return widget;
+	}
+
+	static void configFromWidget(QWidget* widget) {
+		Global::EngineConfigWidget* configWidget
+			= dynamic_cast<Global::EngineConfigWidget*>(widget);
+		if (configWidget == NULL)
+			return;
+
+		Global::Gtags::globalPath_ = configWidget->globalPath();
+		Global::Gtags::gtagsPath_ = configWidget->gtagsPath();
+	}
+};
+
+} // namespace Core
+
+} // namespace KScope
+
+#endif // __GLOBAL_CROSSREF_H__
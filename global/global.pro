@@ -0,0 +1,22 @@
+include(../config)
+TEMPLATE = lib
+TARGET = kscope_global
+DEPENDPATH += ". ../core ../cscope"
+CONFIG += dll
+
+# Input
+HEADERS += engineconfigwidget.h \
+    gtags.h \
+    crossref.h \
+    managedproject.h
+FORMS += engineconfigwidget.ui
+SOURCES += engineconfigwidget.cpp \
+    gtags.cpp \
+    crossref.cpp \
+    managedproject.cpp
+INCLUDEPATH += .. \
+    .
+CONFIG(debug, debug|release):LIBS += -L../core/debug -lkscope_core -L../cscope/debug -lkscope_cscope
+CONFIG(release, debug|release):LIBS += -L../core/release -lkscope_core -L../cscope/release -lkscope_cscope
+target.path = $${INSTALL_PATH}/lib
+INSTALLS += target
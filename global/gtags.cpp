@@ -0,0 +1,181 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include <QDebug>
+#include <QProcessEnvironment>
+#include <QDir>
+#include <core/exception.h>
+#include "gtags.h"
+
+namespace KScope
+{
+
+namespace Global
+{
+
+QString Gtags::globalPath_("/usr/bin/global");
+QString Gtags::gtagsPath_("/usr/bin/gtags");
+
+/**
+ * Class constructor.
+ * Creates the parser objects used for parsing query results.
+ */
+Gtags::Gtags()
+	: Process(),
+	  conn_(NULL),
+	  queryResultState_("QueryResults"),
+	  buildState_("Build")
+{
+	// Same as Cscope's line-oriented output.
+	addRule(queryResultState_, Parser::String<>(' ')
+	                           << Parser::Whitespace()
+	                           << Parser::String<>(' ')
+	                           << Parser::Whitespace()
+	                           << Parser::Number()
+	                           << Parser::Whitespace()
+	                           << Parser::String<>('\n')
+	                           << Parser::Literal("\n"),
+	        queryResultState_, QueryResultAction(*this));
+}
+
+/**
+ * Class destructor.
+ */
+Gtags::~Gtags()
+{
+}
+
+/**
+ * Starts a 'global' query process.
+ * @param  conn      A connection object used for reporting progress and data
+ * @param  dbPath    The directory holding the database
+ * @param  rootPath  The root directory of the code base
+ * @param  args      Query arguments (excluding the output format)
+ * @param  prefixes  Directories to which results are restricted
+ * @throw  Exception
+ */
+void Gtags::query(Core::Engine::Connection* conn, const QString& dbPath,
+                  const QString& rootPath, const QStringList& args,
+                  const QStringList& prefixes)
+{
+	// Abort if a process is already running.
+	if (state() != QProcess::NotRunning || conn_ != NULL)
+		throw new Core::Exception("Process already running");
+
+	// Request absolute paths in Cscope's format.
+	QStringList fullArgs;
+	fullArgs << "-a" << "--result=cscope" << args;
+	setEnvironment(dbPath, rootPath);
+
+	// Initialise parsing.
+	conn_ = conn;
+	conn_->setCtrlObject(this);
+	setState(queryResultState_);
+	locList_.clear();
+	pathPrefixes_ = prefixes;
+
+	// Start the process.
+	qDebug() << "Running" << globalPath_ << fullArgs << "in" << rootPath;
+	start(globalPath_, fullArgs);
+}
+
+/**
+ * Starts a 'gtags' build process.
+ * The list of files is taken from the cscope.files file in the database
+ * directory. An incremental build only re-parses files that were added or
+ * modified since the last build, and forgets files that no longer exist.
+ * @param  conn         A connection object used for reporting progress
+ * @param  dbPath       The directory holding the database
+ * @param  rootPath     The root directory of the code base
+ * @param  incremental  true to update an existing database, false to create
+ *                      a new one
+ * @throw  Exception
+ */
+void Gtags::build(Core::Engine::Connection* conn, const QString& dbPath,
+                  const QString& rootPath, bool incremental)
+{
+	// Abort if a process is already running.
+	if (state() != QProcess::NotRunning || conn_ != NULL)
+		throw new Core::Exception("Process already running");
+
+	QStringList args;
+	if (incremental)
+		args << "-i";
+	args << "-f" << QDir(dbPath).filePath("cscope.files") << dbPath;
+	setEnvironment(dbPath, rootPath);
+
+	// Initialise parsing.
+	conn_ = conn;
+	conn_->setCtrlObject(this);
+	setState(buildState_);
+
+	// Large files are parsed without any output.
+	setIdleTimeout(10 * defaultIdleTimeout_);
+	conn_->onProgress(incremental ? tr("Updating database...")
+	                              : tr("Building database..."), 0, 0);
+
+	// Start the process.
+	qDebug() << "Running" << gtagsPath_ << args << "in" << rootPath;
+	start(gtagsPath_, args);
+}
+
+/**
+ * Called when the process terminates.
+ * @param  code    The exit code of the process
+ * @param  status  Used to indicate process crashes
+ */
+void Gtags::handleFinished(int code, QProcess::ExitStatus status)
+{
+	Process::handleFinished(code, status);
+
+	// Hand over data to the other side of the connection.
+	if (!locList_.isEmpty())
+		conn_->onDataReady(locList_);
+
+	// Signal termination.
+	if (timedOut())
+		conn_->onTimedOut();
+	else if (status == QProcess::NormalExit && !cancelled())
+		conn_->onFinished();
+	else
+		conn_->onAborted();
+
+	// Detach from the connection object.
+	conn_->setCtrlObject(NULL);
+	conn_ = NULL;
+}
+
+/**
+ * Tells the GNU Global tools where to find the database and the sources.
+ * @param  dbPath    The directory holding the database
+ * @param  rootPath  The root directory of the code base
+ */
+void Gtags::setEnvironment(const QString& dbPath, const QString& rootPath)
+{
+	QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+	env.insert("GTAGSDBPATH", dbPath);
+	env.insert("GTAGSROOT", rootPath);
+	setProcessEnvironment(env);
+	setWorkingDirectory(rootPath);
+}
+
+} // namespace Global
+
+} // namespace KScope
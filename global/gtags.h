@@ -0,0 +1,149 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __GLOBAL_GTAGS_H__
+#define __GLOBAL_GTAGS_H__
+
+#include <core/process.h>
+#include <core/globals.h>
+#include <core/engine.h>
+
+namespace KScope
+{
+
+namespace Global
+{
+
+/**
+ * Front-end to the GNU Global tools.
+ * Queries are handled by a 'global' process, while the database is built by a
+ * 'gtags' process. In both cases, the database is kept in the project
+ * directory (GTAGSDBPATH), and source paths are relative to the root of the
+ * code base (GTAGSROOT).
+ * Query results are requested in Cscope's line-oriented format, so they are
+ * parsed exactly as the output of Cscope.
+ * @author Elad Lahav
+ */
+class Gtags : public Core::Process, public Core::Engine::Controlled
+{
+public:
+	Gtags();
+	~Gtags();
+
+	void query(Core::Engine::Connection*, const QString&, const QString&,
+	           const QStringList&, const QStringList&);
+	void build(Core::Engine::Connection*, const QString&, const QString&,
+	           bool);
+
+	/**
+	 * Stops a query/build process.
+	 */
+	virtual void stop() { cancel(); }
+
+	static QString globalPath_;
+	static QString gtagsPath_;
+
+protected slots:
+	virtual void handleFinished(int, QProcess::ExitStatus);
+
+private:
+	/**
+	 * The current connection object, used to communicate progress and result
+	 * information.
+	 */
+	Core::Engine::Connection* conn_;
+
+	/**
+	 * List of locations.
+	 * The list is constructed when result lines are parsed.
+	 */
+	Core::LocationList locList_;
+
+	/**
+	 * Results from files outside these directories are discarded.
+	 */
+	QStringList pathPrefixes_;
+
+	/**
+	 * State for parsing query results.
+	 */
+	State queryResultState_;
+
+	/**
+	 * State for a build process (output is ignored).
+	 */
+	State buildState_;
+
+	void setEnvironment(const QString&, const QString&);
+
+	/**
+	 * Functor for parsing a result line.
+	 */
+	struct QueryResultAction
+	{
+		/**
+		 * Struct constructor.
+		 * @param  self  The owner Gtags object
+		 */
+		QueryResultAction(Gtags& self) : self_(self) {}
+
+		/**
+		 * Functor operator.
+		 * Parses result lines.
+		 * @param  capList  List of captured strings
+		 */
+		void operator()(const Parser::CapList& capList) const {
+			// Skip results outside the query's scope.
+			QString file = capList[0].toString();
+			if (!Core::Query::matchesPath(self_.pathPrefixes_, file))
+				return;
+
+			// Fill-in a Location object, using the parsed result information.
+			// Global reports the matched tag in place of Cscope's scope.
+			Core::Location loc;
+			loc.file_ = file;
+			loc.line_ = capList[2].toUInt();
+			loc.column_ = 0;
+			loc.text_ = capList[3].toString();
+			loc.tag_.type_ = Core::Tag::UnknownTag;
+			loc.tag_.name_ = capList[1].toString();
+
+			// Add to the list of parsed locations.
+			self_.locList_.append(loc);
+
+			// Provide progress information for result-parsing.
+			if ((self_.locList_.size() & 0xff) == 0) {
+				self_.conn_->onProgress(tr("Parsing..."),
+				                        self_.locList_.size(), 0);
+			}
+		}
+
+		/**
+		 * The owner Gtags object.
+		 */
+		Gtags& self_;
+	};
+};
+
+} // namespace Global
+
+} // namespace KScope
+
+#endif // __GLOBAL_GTAGS_H__
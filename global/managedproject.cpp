@@ -0,0 +1,115 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#include "managedproject.h"
+
+namespace KScope
+{
+
+namespace Global
+{
+
+/**
+ * The name of the project configuration file.
+ * Differs from the one used by Cscope projects, so that the type of a project
+ * can be determined from the contents of its directory.
+ */
+static const char* configFileName = "globalproject.conf";
+
+/**
+ * Class constructor.
+ * @param  projPath The directory to use for this project
+ */
+ManagedProject::ManagedProject(const QString& projPath)
+	: Core::Project<Crossref, Cscope::Files>(configFileName, projPath)
+{
+	// Let the engine track changes to the list of files.
+	engine_.setCodebase(&codebase_);
+}
+
+/**
+ * Class destructor.
+ */
+ManagedProject::~ManagedProject()
+{
+}
+
+/**
+ * Creates a new GNU Global managed project.
+ * @param  params Configuration parameters for the new project
+ * @throw  Exception
+ */
+void ManagedProject::create(const Core::ProjectBase::Params& params)
+{
+	try {
+		Params newParams = params;
+		setInitStrings(newParams);
+		Core::Project<Crossref, Cscope::Files>::create(newParams);
+		Cscope::Files().create(params.projPath_);
+	}
+	catch (Core::Exception* e) {
+		throw e;
+	}
+}
+
+/**
+ * Modified configuration parameters for this project.
+ * @param  params Updated configuration parameters.
+ * @throw  Exception
+ */
+void ManagedProject::updateConfig(const Core::ProjectBase::Params& params)
+{
+	try {
+		// Base class implementation.
+		Params newParams = params;
+		setInitStrings(newParams);
+		Core::Project<Crossref, Cscope::Files>::updateConfig(newParams);
+
+		// Apply changes to the engine.
+		engine_.open(newParams.engineString_, NULL);
+	}
+	catch (Core::Exception* e) {
+		throw e;
+	}
+}
+
+/**
+ * @param  projPath  A project directory
+ * @return true if the directory holds a GNU Global project, false otherwise
+ */
+bool ManagedProject::isProject(const QString& projPath)
+{
+	return QDir(projPath).exists(configFileName);
+}
+
+/**
+ * Derives the engine and code base initialisation strings from the other
+ * project parameters.
+ * @param  params  The parameters to update
+ */
+void ManagedProject::setInitStrings(Params& params)
+{
+	params.engineString_ = params.projPath_ + "*" + params.rootPath_;
+	params.codebaseString_ = params.projPath_;
+}
+
+} // namespace Global
+
+} // namespace KScope
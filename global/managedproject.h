@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   Copyright (C) 2007-2009 by Elad Lahav
+ *   elad_lahav@users.sourceforge.net
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ ***************************************************************************/
+
+#ifndef __GLOBAL_MANAGEDPROJECT_H__
+#define __GLOBAL_MANAGEDPROJECT_H__
+
+#include <core/project.h>
+#include <cscope/files.h>
+#include "crossref.h"
+
+namespace KScope
+{
+
+namespace Global
+{
+
+/**
+ * A managed GNU Global project.
+ * As with Cscope projects, the code base is kept in a cscope.files file under
+ * the project directory, which also holds the database.
+ * @author Elad Lahav
+ */
+class ManagedProject : public Core::Project<Crossref, Cscope::Files>
+{
+public:
+	ManagedProject(const QString& projPath = QString());
+	virtual ~ManagedProject();
+
+	void create(const Params&);
+	void updateConfig(const Params&);
+
+	static bool isProject(const QString&);
+
+private:
+	static void setInitStrings(Params&);
+};
+
+} // namespace Global
+
+} // namespace KScope
+
+#endif // __GLOBAL_MANAGEDPROJECT_H__
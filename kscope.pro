@@ -3,6 +3,6 @@ include(config)
 TEMPLATE = subdirs
 
 # Directories
-SUBDIRS += core cscope editor app
+SUBDIRS += core cscope global editor app
 
 message(Installation root path is $${INSTALL_PATH})